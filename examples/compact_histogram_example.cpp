@@ -0,0 +1,87 @@
+#include "Histogram.hpp"
+#include "CDF.hpp"
+#include "CompactHistogram.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+int main() {
+    using Clock = std::chrono::steady_clock;
+    using histogram::CompactHistogram;
+    std::cout << "=== 有损压缩的变宽直方图 ===\n\n";
+
+    // 双峰的延迟分布，10万个bin
+    histogram::Histogram hist(0.0f, 1000.0f, 100000);
+    std::mt19937 gen(3);
+    std::lognormal_distribution<float> fast(3.0f, 0.4f);
+    std::normal_distribution<float> slow(400.0f, 60.0f);
+    for (int i = 0; i < 2000000; ++i) {
+        hist.addData(i % 10 == 0 ? slow(gen) : fast(gen));
+    }
+    std::string full;
+    hist.serialize(full);
+    histogram::CDF cdf;
+    cdf.computeFromHistogram(hist);
+
+    const std::vector<float> percentiles = {50.0f, 95.0f, 99.0f, 99.9f};
+    std::cout << "原直方图: " << hist.getResolution() << "个bin，序列化" << full.size() << "字节\n";
+    std::cout << std::fixed << std::setprecision(3) << "  百分位:";
+    for (float p : percentiles) {
+        std::cout << "  p" << p << "=" << cdf.getPercentile(p);
+    }
+    std::cout << "\n\n";
+
+    auto report = [&](const std::string& name, const CompactHistogram& compact, double seconds) {
+        std::string encoded;
+        compact.serialize(encoded);
+        std::cout << std::left << std::setw(34) << name << std::right << std::setw(6) << compact.getResolution()
+                  << "个bucket，" << std::setw(6) << encoded.size() << "字节（" << std::setprecision(0)
+                  << std::setw(4) << double(full.size()) / encoded.size() << "x），压缩" << std::setprecision(2)
+                  << seconds * 1e3 << " ms\n  百分位:" << std::setprecision(3);
+        for (float p : percentiles) {
+            std::cout << "  p" << p << "=" << compact.getPercentile(p);
+        }
+        std::cout << "\n";
+    };
+
+    // 贪心通常与最优只差几个bucket，最优解的代价与可行bucket的跨度成正比
+    for (auto [epsilon, optimal] : {std::make_pair(1e-4, false), std::make_pair(1e-3, false),
+                                    std::make_pair(1e-3, true), std::make_pair(1e-2, false)}) {
+        auto start = Clock::now();
+        auto compact = CompactHistogram::compactByQuantileError(hist, epsilon, optimal);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::ostringstream name;
+        name << "分位误差≤" << epsilon << (optimal ? "（最优）" : "（贪心）");
+        report(name.str(), compact, seconds);
+    }
+    for (double distance : {0.02, 0.05}) {
+        auto start = Clock::now();
+        auto compact = CompactHistogram::compactByTotalVariation(hist, distance);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::ostringstream name;
+        name << "总变差距离≤" << distance;
+        report(name.str(), compact, seconds);
+    }
+
+    // 百分位查询：CDF逐bin扫描，压缩结果对bucket二分
+    auto compact = CompactHistogram::compactByQuantileError(hist, 1e-3);
+    const int queries = 100000;
+    float sink = 0.0f;
+    auto start = Clock::now();
+    for (int i = 0; i < queries; ++i) {
+        sink += cdf.getPercentile(static_cast<float>(i % 999 + 1) / 10.0f);
+    }
+    double cdfSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    start = Clock::now();
+    for (int i = 0; i < queries; ++i) {
+        sink += compact.getPercentile(static_cast<float>(i % 999 + 1) / 10.0f);
+    }
+    double compactSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "\n百分位查询: CDF " << std::setprecision(0) << cdfSeconds / queries * 1e9 << " ns/次，压缩后 "
+              << compactSeconds / queries * 1e9 << " ns/次（校验和" << std::setprecision(1) << sink << "）\n";
+    return 0;
+}
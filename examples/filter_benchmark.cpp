@@ -0,0 +1,290 @@
+#include "GaussianFilter.hpp"
+#include "ScaleSpace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// 优化前的实现：每个抽头都做边界检查并累加权重
+void referenceFilter(const std::vector<float>& kernel, const float* input, float* output, int size) {
+    int radius = static_cast<int>(kernel.size() / 2);
+    for (int i = 0; i < size; ++i) {
+        float sum = 0.0f;
+        float weightSum = 0.0f;
+        for (int j = -radius; j <= radius; ++j) {
+            int idx = i + j;
+            if (idx >= 0 && idx < size) {
+                float weight = kernel[j + radius];
+                sum += input[idx] * weight;
+                weightSum += weight;
+            }
+        }
+        output[i] = (weightSum > 0) ? sum / weightSum : 0.0f;
+    }
+}
+
+// 重复运行直到累计时间足够长，返回单次耗时（毫秒）
+template <typename Func>
+double measure(Func&& func) {
+    using Clock = std::chrono::steady_clock;
+    int repeats = 0;
+    auto start = Clock::now();
+    double elapsed = 0.0;
+    do {
+        func();
+        ++repeats;
+        elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    } while (elapsed < 200.0 && repeats < 1000);
+    return elapsed / repeats;
+}
+
+const char* methodName(histogram::GaussianFilter::Method method) {
+    switch (method) {
+    case histogram::GaussianFilter::Method::Recursive:
+        return "递归";
+    case histogram::GaussianFilter::Method::FFT:
+        return "FFT";
+    default:
+        return "直接";
+    }
+}
+
+} // namespace
+
+int main() {
+    std::cout << "=== 高斯滤波性能测试 ===\n\n";
+#if defined(__AVX512F__)
+    std::cout << "SIMD路径: AVX-512\n\n";
+#elif defined(__AVX2__) && defined(__FMA__)
+    std::cout << "SIMD路径: AVX2 + FMA\n\n";
+#else
+    std::cout << "SIMD路径: 编译器自动向量化（使用 -DHISTOGRAM_NATIVE_ARCH=ON 启用AVX2/AVX-512）\n\n";
+#endif
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dist(0.0f, 1000.0f);
+
+    const std::vector<size_t> sizes = {10000, 100000, 1000000};
+    const std::vector<float> sigmas = {1.0f, 4.0f, 16.0f, 64.0f};
+
+    std::cout << "     大小 |  sigma | 原始实现(ms) | 直接卷积(ms) | 递归(ms) |  FFT(ms) | Auto选择 | 直接卷积加速比\n";
+    std::cout << "   -------|--------|--------------|--------------|----------|----------|----------|---------------\n";
+
+    for (size_t size : sizes) {
+        std::vector<float> input(size);
+        for (auto& v : input) {
+            v = dist(gen);
+        }
+        std::vector<float> output(size);
+
+        for (float sigma : sigmas) {
+            histogram::GaussianFilter direct(sigma);
+            histogram::GaussianFilter recursive(sigma, histogram::GaussianFilter::Method::Recursive);
+            histogram::GaussianFilter fft(sigma, histogram::GaussianFilter::Method::FFT);
+            histogram::GaussianFilter automatic(sigma, histogram::GaussianFilter::Method::Auto);
+
+            double referenceMs = measure([&]() {
+                referenceFilter(direct.getKernel(), input.data(), output.data(), static_cast<int>(size));
+            });
+            double directMs = measure([&]() { direct.filter(input.data(), output.data(), size); });
+            double recursiveMs = measure([&]() { recursive.filter(input.data(), output.data(), size); });
+            double fftMs = measure([&]() { fft.filter(input.data(), output.data(), size); });
+
+            std::cout << std::setw(10) << size << " | "
+                      << std::setw(6) << sigma << " | "
+                      << std::setw(12) << std::fixed << std::setprecision(3) << referenceMs << " | "
+                      << std::setw(12) << directMs << " | "
+                      << std::setw(8) << recursiveMs << " | "
+                      << std::setw(8) << fftMs << " | "
+                      << std::setw(8) << methodName(automatic.selectMethod(size)) << " | "
+                      << std::setw(12) << std::setprecision(1) << referenceMs / directMs << "x\n";
+        }
+    }
+
+    // 在更细的sigma网格上比较实测最快的方法与Auto的选择，用于校准代价模型
+    std::cout << "\n=== 方法交叉点（实测最快 / Auto选择） ===\n\n";
+    const std::vector<float> sweep = {0.5f, 1.0f, 2.0f, 3.0f, 4.0f, 6.0f, 8.0f, 12.0f, 16.0f, 24.0f, 32.0f, 64.0f, 128.0f};
+    for (size_t size : sizes) {
+        std::vector<float> input(size);
+        for (auto& v : input) {
+            v = dist(gen);
+        }
+        std::vector<float> output(size);
+
+        std::cout << std::setw(10) << size << ":";
+        for (float sigma : sweep) {
+            histogram::GaussianFilter direct(sigma);
+            histogram::GaussianFilter recursive(sigma, histogram::GaussianFilter::Method::Recursive);
+            histogram::GaussianFilter fft(sigma, histogram::GaussianFilter::Method::FFT);
+            histogram::GaussianFilter automatic(sigma, histogram::GaussianFilter::Method::Auto);
+
+            const std::pair<histogram::GaussianFilter*, double> timings[] = {
+                {&direct, measure([&]() { direct.filter(input.data(), output.data(), size); })},
+                {&recursive, measure([&]() { recursive.filter(input.data(), output.data(), size); })},
+                {&fft, measure([&]() { fft.filter(input.data(), output.data(), size); })},
+            };
+            auto fastest = std::min_element(std::begin(timings), std::end(timings),
+                                            [](const auto& a, const auto& b) { return a.second < b.second; });
+            std::cout << "  σ=" << std::defaultfloat << std::setprecision(3) << sigma << " "
+                      << methodName(fastest->first->selectMethod(size)) << "/"
+                      << methodName(automatic.selectMethod(size));
+        }
+        std::cout << "\n";
+    }
+
+    // 整数盒式滤波与直接卷积在计数数据上的误差和速度对比
+    std::cout << "\n=== 整数盒式滤波（计数） ===\n\n";
+    std::cout << "     大小 |  sigma |    盒宽     | 直接卷积(ms) | 盒式(ms) | 加速比 | 最大误差/峰值 | 平均相对误差\n";
+    std::cout << "   -------|--------|-------------|--------------|----------|--------|---------------|-------------\n";
+    for (size_t size : sizes) {
+        // 带泊松噪声的双峰直方图计数
+        std::vector<size_t> counts(size);
+        for (size_t i = 0; i < size; ++i) {
+            double x = static_cast<double>(i) / size;
+            double mean = 200.0 + 5000.0 * std::exp(-(x - 0.3) * (x - 0.3) / 0.005)
+                        + 2000.0 * std::exp(-(x - 0.7) * (x - 0.7) / 0.001);
+            counts[i] = std::poisson_distribution<size_t>(mean)(gen);
+        }
+        std::vector<float> reference(size);
+        std::vector<size_t> smoothed(size);
+
+        for (float sigma : sigmas) {
+            histogram::GaussianFilter filter(sigma);
+            double directMs = measure([&]() { filter.filterCounts(counts.data(), reference.data(), size); });
+            double boxMs = measure([&]() { filter.filterCountsBox(counts.data(), smoothed.data(), size); });
+
+            double maxError = 0.0;
+            double peak = 0.0;
+            double relativeSum = 0.0;
+            for (size_t i = 0; i < size; ++i) {
+                double diff = std::abs(static_cast<double>(smoothed[i]) - reference[i]);
+                maxError = std::max(maxError, diff);
+                peak = std::max(peak, static_cast<double>(reference[i]));
+                relativeSum += diff / std::max(1.0, static_cast<double>(reference[i]));
+            }
+
+            const auto& widths = filter.getBoxWidths();
+            std::cout << std::setw(10) << size << " | "
+                      << std::setw(6) << std::defaultfloat << sigma << " | "
+                      << std::setw(3) << widths[0] << "," << std::setw(3) << widths[1] << ","
+                      << std::setw(3) << widths[2] << " | "
+                      << std::setw(12) << std::fixed << std::setprecision(3) << directMs << " | "
+                      << std::setw(8) << boxMs << " | "
+                      << std::setw(5) << std::setprecision(1) << directMs / boxMs << "x | "
+                      << std::setw(12) << std::setprecision(3) << 100.0 * maxError / peak << "% | "
+                      << std::setw(10) << 100.0 * relativeSum / size << "%\n";
+        }
+    }
+
+    // 批量多行滤波：逐行调用与批量接口（单线程/全部线程）对比
+    std::cout << "\n=== 批量多行滤波（计数矩阵） ===\n\n";
+    std::cout << "   行数 |  列数 |  sigma | 逐行(ms) | 批量1线程(ms) | 批量多线程(ms) | 单线程加速比\n";
+    std::cout << "  ------|-------|--------|----------|---------------|----------------|-------------\n";
+    const std::vector<std::pair<size_t, size_t>> shapes = {{100000, 8}, {50000, 32}, {10000, 256}, {100, 100000}};
+    for (const auto& shape : shapes) {
+        const size_t rows = shape.first;
+        const size_t cols = shape.second;
+        std::vector<size_t> matrix(rows * cols);
+        for (auto& c : matrix) {
+            c = static_cast<size_t>(dist(gen));
+        }
+        std::vector<float> smoothed(rows * cols);
+
+        for (float sigma : {1.0f, 4.0f}) {
+            histogram::GaussianFilter filter(sigma);
+            double rowMs = measure([&]() {
+                for (size_t r = 0; r < rows; ++r) {
+                    filter.filterCounts(matrix.data() + r * cols, smoothed.data() + r * cols, cols);
+                }
+            });
+            double batchMs = measure([&]() { filter.filterCountsRows(matrix.data(), smoothed.data(), rows, cols, 1); });
+            double parallelMs = measure([&]() { filter.filterCountsRows(matrix.data(), smoothed.data(), rows, cols); });
+
+            std::cout << std::setw(7) << rows << " | "
+                      << std::setw(5) << cols << " | "
+                      << std::setw(6) << std::defaultfloat << sigma << " | "
+                      << std::setw(8) << std::fixed << std::setprecision(3) << rowMs << " | "
+                      << std::setw(13) << batchMs << " | "
+                      << std::setw(14) << parallelMs << " | "
+                      << std::setw(10) << std::setprecision(1) << rowMs / batchMs << "x\n";
+        }
+    }
+
+    // 尺度空间：增量构建（含导数）与每个sigma各做一次独立滤波的对比
+    std::cout << "\n=== 尺度空间（sigma 1~32，每倍频程3层） ===\n\n";
+    std::cout << "     大小 | 层数 | 独立滤波(ms) | 尺度空间构建(ms) | 跨尺度波峰(ms) | 加速比\n";
+    std::cout << "   -------|------|--------------|------------------|----------------|-------\n";
+    for (size_t size : sizes) {
+        std::vector<size_t> counts(size);
+        for (size_t i = 0; i < size; ++i) {
+            double x = static_cast<double>(i) / size;
+            counts[i] = std::poisson_distribution<size_t>(100.0 + 1000.0 * std::exp(-(x - 0.5) * (x - 0.5) / 0.01))(gen);
+        }
+        std::vector<float> smoothed(size);
+
+        histogram::ScaleSpace space(1.0f, 32.0f, 3);
+        double buildMs = measure([&]() { space.build(counts.data(), size); });
+        double peaksMs = measure([&]() { space.findPeaks(); });
+
+        std::vector<histogram::GaussianFilter> filters;
+        for (size_t k = 0; k < space.getLevelCount(); ++k) {
+            filters.emplace_back(space.getSigma(k));
+        }
+        double independentMs = measure([&]() {
+            for (const auto& filter : filters) {
+                filter.filterCounts(counts.data(), smoothed.data(), size);
+            }
+        });
+
+        std::cout << std::setw(10) << size << " | "
+                  << std::setw(4) << space.getLevelCount() << " | "
+                  << std::setw(12) << std::fixed << std::setprecision(3) << independentMs << " | "
+                  << std::setw(16) << buildMs << " | "
+                  << std::setw(14) << peaksMs << " | "
+                  << std::setw(5) << std::setprecision(1) << independentMs / buildMs << "x\n";
+    }
+
+    // 超长信号的分块并行滤波：线程数从1到64，输出应与单线程逐位相同
+    std::cout << "\n=== 分块并行滤波（5000万样本，硬件并发数 " << std::thread::hardware_concurrency()
+              << "） ===\n\n";
+    std::cout << "  sigma | 线程数 | 耗时(ms) | 加速比 | 并行效率 | 与单线程一致\n";
+    std::cout << "  ------|--------|----------|--------|----------|-------------\n";
+    {
+        const size_t size = 50000000;
+        std::vector<float> input(size);
+        for (auto& v : input) {
+            v = dist(gen);
+        }
+        std::vector<float> expected(size);
+        std::vector<float> output(size);
+
+        for (float sigma : {4.0f, 16.0f}) {
+            histogram::GaussianFilter filter(sigma);
+            filter.filter(input.data(), expected.data(), size);
+            double serialMs = 0.0;
+            for (unsigned threads : {1u, 2u, 4u, 8u, 16u, 32u, 64u}) {
+                filter.setThreads(threads);
+                double ms = measure([&]() { filter.filter(input.data(), output.data(), size); });
+                if (threads == 1) {
+                    serialMs = ms;
+                }
+                bool identical = std::equal(output.begin(), output.end(), expected.begin());
+                std::cout << std::setw(7) << std::defaultfloat << std::setprecision(3) << sigma << " | "
+                          << std::setw(6) << threads << " | "
+                          << std::setw(8) << std::fixed << std::setprecision(2) << ms << " | "
+                          << std::setw(5) << std::setprecision(2) << serialMs / ms << "x | "
+                          << std::setw(7) << std::setprecision(1) << 100.0 * serialMs / ms / threads << "% | "
+                          << (identical ? "是" : "否") << "\n";
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include "Histogram.hpp"
+#include "Ingestor.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main() {
+    using Clock = std::chrono::steady_clock;
+    using Format = histogram::Ingestor::Format;
+    std::cout << "=== 文本/二进制文件读入吞吐 ===\n\n";
+
+    const size_t count = 20000000;
+    const std::string textPath = "ingest_benchmark.txt";
+    const std::string binaryPath = "ingest_benchmark.f32";
+    {
+        std::mt19937 gen(5);
+        std::normal_distribution<float> dist(0.0f, 1.0f);
+        std::vector<float> values(count);
+        for (auto& v : values) {
+            v = dist(gen);
+        }
+        std::string text;
+        char buffer[32];
+        for (float v : values) {
+            int length = std::snprintf(buffer, sizeof(buffer), "%.7g\n", v);
+            text.append(buffer, static_cast<size_t>(length));
+        }
+        std::ofstream(textPath, std::ios::binary).write(text.data(), static_cast<std::streamsize>(text.size()));
+        std::ofstream(binaryPath, std::ios::binary)
+            .write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(count * sizeof(float)));
+    }
+
+    auto megabytesPerSecond = [](size_t bytes, double seconds) { return bytes / seconds / (1 << 20); };
+    std::cout << std::fixed << std::setprecision(0);
+
+    // 基线：ifstream >> float 逐个addData
+    {
+        histogram::Histogram hist(-5.0f, 5.0f, 10000);
+        auto start = Clock::now();
+        std::ifstream file(textPath);
+        float value;
+        while (file >> value) {
+            hist.addData(value);
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::ifstream sizeProbe(textPath, std::ios::binary | std::ios::ate);
+        std::cout << "ifstream >> float:          " << megabytesPerSecond(static_cast<size_t>(sizeProbe.tellg()), seconds)
+                  << " MB/s\n";
+    }
+
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    for (auto format : {Format::Text, Format::Float32}) {
+        const std::string& path = format == Format::Text ? textPath : binaryPath;
+        for (unsigned threads = 1; threads <= hardware; threads *= 2) {
+            histogram::Histogram hist(-5.0f, 5.0f, 10000);
+            histogram::Ingestor ingestor(format, threads);
+            auto start = Clock::now();
+            auto stats = ingestor.ingestFile(path, hist);
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            std::cout << (format == Format::Text ? "Ingestor 文本" : "Ingestor float32") << "，" << threads
+                      << "线程: " << std::setw(8) << megabytesPerSecond(stats.bytes, seconds) << " MB/s（"
+                      << stats.values << "个值）\n";
+        }
+    }
+
+    std::remove(textPath.c_str());
+    std::remove(binaryPath.c_str());
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include "Histogram.hpp"
+#include "OpenMetricsExporter.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+int main() {
+    using Clock = std::chrono::steady_clock;
+    std::cout << "=== OpenMetrics导出：20000个直方图 ===\n\n";
+
+    const size_t count = 20000;
+    const size_t resolution = 200;
+    std::mt19937 gen(7);
+    std::lognormal_distribution<float> dist(-3.0f, 1.0f);
+    std::vector<histogram::Histogram> hists;
+    hists.reserve(count);
+    for (size_t h = 0; h < count; ++h) {
+        hists.emplace_back(0.0f, 2.0f, resolution);
+        for (int i = 0; i < 200; ++i) {
+            hists.back().addData(dist(gen));
+        }
+    }
+    std::vector<const histogram::Histogram*> pointers;
+    for (const auto& hist : hists) {
+        pointers.push_back(&hist);
+    }
+    const std::vector<float> ladder = {0.005f, 0.01f, 0.025f, 0.05f, 0.1f, 0.25f, 0.5f, 1.0f, 2.0f};
+
+    std::cout << std::fixed << std::setprecision(2);
+    auto milliseconds = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    // 基线：每次抓取都用ostringstream拼标签、逐个bucket重新累计
+    {
+        auto start = Clock::now();
+        std::ostringstream out;
+        out << "# TYPE request_seconds histogram\n";
+        for (size_t h = 0; h < count; ++h) {
+            const auto& counts = hists[h].getBinCounts();
+            const float binWidth = hists[h].getBinWidth();
+            const std::string labels = "instance=\"" + std::to_string(h) + "\",job=\"api\"";
+            double sum = 0.0;
+            for (size_t i = 0; i < resolution; ++i) {
+                sum += counts[i] * (hists[h].getMin() + (i + 0.5) * binWidth);
+            }
+            for (float le : ladder) {
+                size_t cumulative = 0;
+                for (size_t i = 0; i < resolution && hists[h].getMin() + (i + 1) * binWidth <= le; ++i) {
+                    cumulative += counts[i];
+                }
+                out << "request_seconds_bucket{" << labels << ",le=\"" << le << "\"} " << cumulative << "\n";
+            }
+            out << "request_seconds_bucket{" << labels << ",le=\"+Inf\"} " << hists[h].getTotalCount() << "\n";
+            out << "request_seconds_sum{" << labels << "} " << sum << "\n";
+            out << "request_seconds_count{" << labels << "} " << hists[h].getTotalCount() << "\n";
+        }
+        out << "# EOF\n";
+        std::cout << "ostringstream:            " << std::setw(8) << milliseconds(start) << " ms（"
+                  << out.str().size() / 1024 << " KB）\n";
+    }
+
+    // OpenMetricsExporter：标签前缀在注册时缓存，缓冲区跨抓取复用
+    histogram::OpenMetricsExporter exporter("request_seconds", "Request latency");
+    for (size_t h = 0; h < count; ++h) {
+        exporter.addSeries({{"instance", std::to_string(h)}, {"job", "api"}});
+    }
+    std::string buffer;
+    for (bool coarsened : {true, false}) {
+        exporter.setBuckets(coarsened ? ladder : std::vector<float>());
+        double best = 1e30;
+        for (int scrape = 0; scrape < 5; ++scrape) {
+            auto start = Clock::now();
+            buffer.clear();
+            exporter.write(pointers, buffer);
+            histogram::OpenMetricsExporter::writeEOF(buffer);
+            best = std::min(best, milliseconds(start));
+        }
+        std::cout << (coarsened ? "OpenMetricsExporter，9个le:  " : "OpenMetricsExporter，每bin: ")
+                  << std::setw(8) << best << " ms（" << buffer.size() / 1024 << " KB）\n";
+    }
+    return 0;
+}
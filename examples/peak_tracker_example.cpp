@@ -0,0 +1,76 @@
+#include "Histogram.hpp"
+#include "PeakTracker.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+int main() {
+    std::cout << "=== 实时直方图的增量波峰跟踪 ===\n\n";
+
+    // 小直方图：打印波峰出现和消失的事件
+    histogram::Histogram hist(0.0f, 20.0f, 20);
+    histogram::PeakTracker tracker(hist, 20);
+    tracker.setCallback([&hist](size_t bin, bool appeared) {
+        auto range = hist.getBinRange(bin);
+        std::cout << (appeared ? "  + 波峰出现: bin " : "  - 波峰消失: bin ") << std::setw(2) << bin
+                  << " [" << range.first << ", " << range.second << ")  计数 " << hist.getBinCount(bin) << "\n";
+    });
+
+    std::mt19937 gen(2024);
+    std::normal_distribution<float> left(6.0f, 1.5f);
+    std::normal_distribution<float> right(14.0f, 1.0f);
+    for (int i = 0; i < 400; ++i) {
+        tracker.addData(left(gen));
+        if (i >= 200) {
+            tracker.addData(right(gen)); // 第二个峰后出现
+        }
+    }
+    std::cout << "\n当前波峰:";
+    for (size_t peak : tracker.getPeaks()) {
+        std::cout << " " << peak;
+    }
+    std::cout << "\n\n";
+
+    // 大直方图：每个周期写入一批数据后查询波峰，对比增量跟踪与每次重新扫描
+    const size_t resolution = 1000000;
+    const int ticks = 100;
+    const int valuesPerTick = 10000;
+    histogram::Histogram live(0.0f, 1.0f, resolution);
+    histogram::Histogram rescanned(0.0f, 1.0f, resolution);
+    histogram::PeakTracker liveTracker(live, 3);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::vector<float> values(valuesPerTick);
+
+    using Clock = std::chrono::steady_clock;
+    double trackerMs = 0.0;
+    double rescanMs = 0.0;
+    size_t trackedPeaks = 0;
+    size_t scannedPeaks = 0;
+    for (int tick = 0; tick < ticks; ++tick) {
+        for (auto& v : values) {
+            v = uniform(gen);
+        }
+
+        auto start = Clock::now();
+        for (float v : values) {
+            liveTracker.addData(v);
+        }
+        trackedPeaks = liveTracker.getPeaks().size();
+        trackerMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        start = Clock::now();
+        for (float v : values) {
+            rescanned.addData(v);
+        }
+        scannedPeaks = rescanned.findPeaks(0.0f).size();
+        rescanMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    std::cout << resolution << "个bin，每周期写入" << valuesPerTick << "个数据并查询波峰，共" << ticks << "个周期:\n";
+    std::cout << "  增量跟踪:  " << std::fixed << std::setprecision(3) << trackerMs / ticks << " ms/周期（"
+              << trackedPeaks << "个波峰）\n";
+    std::cout << "  重新扫描:  " << rescanMs / ticks << " ms/周期（" << scannedPeaks << "个波峰）\n";
+    std::cout << "  加速比:    " << std::setprecision(1) << rescanMs / trackerMs << "x\n";
+    return 0;
+}
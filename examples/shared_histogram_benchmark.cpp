@@ -0,0 +1,167 @@
+#include "Histogram.hpp"
+#include "SharedHistogram.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr float kMin = 0.0f;
+constexpr float kMax = 100.0f;
+constexpr size_t kResolution = 10000;
+
+/**
+ * @brief 子进程生成的数据（各进程种子不同）
+ */
+std::vector<float> workerValues(int worker, size_t count) {
+    std::mt19937 gen(1000 + worker);
+    std::normal_distribution<float> dist(50.0f, 12.0f);
+    std::vector<float> values(count);
+    for (auto& v : values) {
+        v = dist(gen);
+    }
+    return values;
+}
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t got = ::read(fd, data, size);
+        if (got <= 0) {
+            return false;
+        }
+        data += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+void waitAll(const std::vector<pid_t>& children) {
+    for (pid_t pid : children) {
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+    }
+}
+
+/**
+ * @brief 所有子进程直接写入共享内存直方图，返回耗时（毫秒）
+ */
+double runShared(int workers, size_t perWorker, size_t& total) {
+    const std::string name = "/histogram_bench_" + std::to_string(::getpid());
+    histogram::SharedHistogram::unlink(name);
+    auto shared = histogram::SharedHistogram::create(name, kMin, kMax, kResolution);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<pid_t> children;
+    for (int w = 0; w < workers; ++w) {
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            auto values = workerValues(w, perWorker);
+            auto child = histogram::SharedHistogram::attach(name);
+            for (float v : values) {
+                child.addData(v);
+            }
+            ::_exit(0);
+        }
+        children.push_back(pid);
+    }
+    waitAll(children);
+    total = shared.snapshot().getTotalCount();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    histogram::SharedHistogram::unlink(name);
+    return ms;
+}
+
+/**
+ * @brief 每个子进程写入私有直方图，结束时序列化后经管道发给父进程合并，返回耗时（毫秒）
+ */
+double runPipe(int workers, size_t perWorker, size_t& total) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<pid_t> children;
+    std::vector<int> pipes;
+    for (int w = 0; w < workers; ++w) {
+        int fds[2];
+        if (::pipe(fds) != 0) {
+            throw std::runtime_error("pipe failed");
+        }
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            ::close(fds[0]);
+            auto values = workerValues(w, perWorker);
+            histogram::Histogram local(kMin, kMax, kResolution);
+            for (float v : values) {
+                local.addData(v);
+            }
+            std::string data;
+            local.serialize(data);
+            uint64_t size = data.size();
+            bool ok = writeAll(fds[1], reinterpret_cast<const char*>(&size), sizeof(size)) &&
+                      writeAll(fds[1], data.data(), data.size());
+            ::_exit(ok ? 0 : 1);
+        }
+        ::close(fds[1]);
+        children.push_back(pid);
+        pipes.push_back(fds[0]);
+    }
+
+    histogram::Histogram merged(kMin, kMax, kResolution);
+    std::string buffer;
+    for (int fd : pipes) {
+        uint64_t size = 0;
+        if (readAll(fd, reinterpret_cast<char*>(&size), sizeof(size))) {
+            buffer.resize(size);
+            if (readAll(fd, &buffer[0], size)) {
+                merged.mergeFromSerialized(buffer.data(), buffer.size());
+            }
+        }
+        ::close(fd);
+    }
+    waitAll(children);
+    total = merged.getTotalCount();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main() {
+    std::cout << "=== 多进程写入：共享内存直方图 vs 各进程直方图经管道合并 ===\n\n";
+    const size_t perWorker = 2000000;
+    const unsigned hardware = std::max(1L, ::sysconf(_SC_NPROCESSORS_ONLN));
+    std::cout << kResolution << "个bin，每个进程" << perWorker << "个数据，" << hardware << "个CPU\n\n";
+    std::cout << "  进程数    共享内存(ms)    管道合并(ms)    共享(M值/秒)    管道(M值/秒)\n";
+
+    for (int workers = 1; workers <= 16; workers *= 2) {
+        size_t sharedTotal = 0;
+        size_t pipeTotal = 0;
+        double sharedMs = runShared(workers, perWorker, sharedTotal);
+        double pipeMs = runPipe(workers, perWorker, pipeTotal);
+        if (sharedTotal != pipeTotal) {
+            std::cerr << "计数不一致: " << sharedTotal << " vs " << pipeTotal << "\n";
+            return 1;
+        }
+        const double values = static_cast<double>(workers) * perWorker / 1e6;
+        std::cout << std::fixed << std::setprecision(1) << std::setw(8) << workers << std::setw(16) << sharedMs
+                  << std::setw(16) << pipeMs << std::setw(18) << values / sharedMs * 1000.0 << std::setw(18)
+                  << values / pipeMs * 1000.0 << "\n";
+    }
+    std::cout << "\n共享内存的写入为原子加法，读取方随时可以取快照；管道方式只在进程结束时得到结果，\n"
+                 "但每次写入是普通的内存加法。同一个热点bin上的竞争随进程数增加。\n";
+    return 0;
+}
@@ -0,0 +1,148 @@
+#ifndef BYTE_IO_HPP
+#define BYTE_IO_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace histogram {
+namespace detail {
+
+/**
+ * @brief 以小端字节序追加整数或浮点数到字符串
+ * @param output 输出字符串
+ * @param value 数值
+ */
+template <typename T>
+void appendLittleEndian(std::string& output, T value) {
+    static_assert(std::is_arithmetic<T>::value, "arithmetic type required");
+    using Bits = typename std::conditional<sizeof(T) == 8, uint64_t,
+                 typename std::conditional<sizeof(T) == 4, uint32_t,
+                 typename std::conditional<sizeof(T) == 2, uint16_t, uint8_t>::type>::type>::type;
+    Bits bits;
+    std::memcpy(&bits, &value, sizeof(T));
+    char bytes[sizeof(T)];
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        bytes[i] = static_cast<char>((bits >> (8 * i)) & 0xFF);
+    }
+    output.append(bytes, sizeof(T));
+}
+
+/**
+ * @brief 以LEB128变长编码追加无符号整数（每字节7位，最高位表示后面还有字节）
+ * @param output 输出字符串
+ * @param value 数值
+ */
+inline void appendVarint(std::string& output, uint64_t value) {
+    char bytes[10];
+    size_t length = 0;
+    while (value >= 0x80) {
+        bytes[length++] = static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    bytes[length++] = static_cast<char>(value);
+    output.append(bytes, length);
+}
+
+/**
+ * @brief 把有符号整数映射为无符号整数（0, -1, 1, -2 ... → 0, 1, 2, 3 ...），使小绝对值的差值编码更短
+ * @param value 有符号整数
+ * @return 映射后的无符号整数
+ */
+inline uint64_t zigZagEncode(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+/**
+ * @brief zigZagEncode的逆映射
+ * @param value 无符号整数
+ * @return 有符号整数
+ */
+inline int64_t zigZagDecode(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+/**
+ * @brief 顺序读取字节缓冲区的游标，越界时抛出std::runtime_error
+ */
+class ByteReader {
+public:
+    ByteReader(const char* data, size_t size) : data_(data), size_(size), offset_(0) {}
+
+    /**
+     * @brief 以小端字节序读取一个数值
+     * @return 数值
+     */
+    template <typename T>
+    T readLittleEndian() {
+        static_assert(std::is_arithmetic<T>::value, "arithmetic type required");
+        using Bits = typename std::conditional<sizeof(T) == 8, uint64_t,
+                     typename std::conditional<sizeof(T) == 4, uint32_t,
+                     typename std::conditional<sizeof(T) == 2, uint16_t, uint8_t>::type>::type>::type;
+        require(sizeof(T));
+        Bits bits = 0;
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            bits |= static_cast<Bits>(static_cast<unsigned char>(data_[offset_ + i])) << (8 * i);
+        }
+        offset_ += sizeof(T);
+        T value;
+        std::memcpy(&value, &bits, sizeof(T));
+        return value;
+    }
+
+    /**
+     * @brief 读取一个LEB128变长编码的无符号整数，超过64位时抛出std::runtime_error
+     * @return 数值
+     */
+    uint64_t readVarint() {
+        uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            require(1);
+            const uint64_t byte = static_cast<unsigned char>(data_[offset_++]);
+            if (shift == 63 && byte > 1) {
+                break;
+            }
+            value |= (byte & 0x7F) << shift;
+            if (byte < 0x80) {
+                return value;
+            }
+        }
+        throw std::runtime_error("Invalid varint in serialized data");
+    }
+
+    /**
+     * @brief 读取指定长度的原始字节
+     * @param size 字节数
+     * @return 指向数据的指针
+     */
+    const char* readBytes(size_t size) {
+        require(size);
+        const char* result = data_ + offset_;
+        offset_ += size;
+        return result;
+    }
+
+    /**
+     * @brief 获取剩余字节数
+     * @return 剩余字节数
+     */
+    size_t remaining() const { return size_ - offset_; }
+
+private:
+    void require(size_t size) const {
+        if (size > size_ - offset_) {
+            throw std::runtime_error("Unexpected end of serialized data");
+        }
+    }
+
+    const char* data_;
+    size_t size_;
+    size_t offset_;
+};
+
+} // namespace detail
+} // namespace histogram
+
+#endif // BYTE_IO_HPP
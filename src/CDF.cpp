@@ -1,33 +1,149 @@
 #include "CDF.hpp"
+#include "CSVExporter.hpp"
+#include "Parallel.hpp"
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <stdexcept>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 namespace histogram {
 
+namespace {
+
+// 每个并行块的最小元素数，小于该规模时线程开销大于收益
+constexpr size_t kBatchChunkSize = size_t(1) << 16;
+
+/**
+ * @brief 批量累计概率计算的核心循环
+ *
+ * 与getCumulativeProbability保持相同的除法和截断方式，因此不插值时结果逐位一致。
+ * 插值时bin下边界取前一个bin的CDF值，上边界取当前bin的CDF值。
+ */
+void evaluateCumulative(const float* cdf, size_t resolution,
+                        float minValue, float maxValue, float binWidth,
+                        const float* values, float* out, size_t count,
+                        bool interpolate) {
+    const size_t lastIndex = resolution - 1;
+    const float upper = static_cast<float>(resolution);
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    if (resolution <= static_cast<size_t>(INT32_MAX)) {
+        const __m256 vMin = _mm256_set1_ps(minValue);
+        const __m256 vMax = _mm256_set1_ps(maxValue);
+        const __m256 vBinWidth = _mm256_set1_ps(binWidth);
+        const __m256 vUpper = _mm256_set1_ps(upper);
+        const __m256 vZero = _mm256_setzero_ps();
+        const __m256 vOne = _mm256_set1_ps(1.0f);
+        const __m256i vLast = _mm256_set1_epi32(static_cast<int>(lastIndex));
+        const __m256i vIntOne = _mm256_set1_epi32(1);
+
+        for (; i + 8 <= count; i += 8) {
+            __m256 v = _mm256_loadu_ps(values + i);
+            __m256 t = _mm256_div_ps(_mm256_sub_ps(v, vMin), vBinWidth);
+            t = _mm256_max_ps(t, vZero); // NaN和负数都截为0
+            t = _mm256_min_ps(t, vUpper);
+            __m256i idx = _mm256_min_epi32(_mm256_cvttps_epi32(t), vLast);
+            __m256 p = _mm256_i32gather_ps(cdf, idx, 4);
+
+            if (interpolate) {
+                __m256i hasPrev = _mm256_cmpgt_epi32(idx, _mm256_setzero_si256());
+                __m256 prev = _mm256_mask_i32gather_ps(vZero, cdf,
+                                                       _mm256_sub_epi32(idx, vIntOne),
+                                                       _mm256_castsi256_ps(hasPrev), 4);
+                __m256 frac = _mm256_min_ps(_mm256_sub_ps(t, _mm256_cvtepi32_ps(idx)), vOne);
+                p = _mm256_add_ps(prev, _mm256_mul_ps(frac, _mm256_sub_ps(p, prev)));
+            }
+
+            p = _mm256_blendv_ps(p, vZero, _mm256_cmp_ps(v, vMin, _CMP_LT_OQ));
+            p = _mm256_blendv_ps(p, vOne, _mm256_cmp_ps(v, vMax, _CMP_GE_OQ));
+            _mm256_storeu_ps(out + i, p);
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        float v = values[i];
+        float t = (v - minValue) / binWidth;
+        t = t > 0.0f ? t : 0.0f; // NaN和负数都截为0
+        t = t < upper ? t : upper;
+        size_t idx = std::min(static_cast<size_t>(t), lastIndex);
+        float p = cdf[idx];
+
+        if (interpolate) {
+            float prev = idx > 0 ? cdf[idx - 1] : 0.0f;
+            float frac = std::min(t - static_cast<float>(idx), 1.0f);
+            p = prev + frac * (p - prev);
+        }
+
+        p = v < minValue ? 0.0f : p;
+        p = v >= maxValue ? 1.0f : p;
+        out[i] = p;
+    }
+}
+
+} // namespace
+
 void CDF::computeFromHistogram(const Histogram& hist) {
-    const auto& binCounts = hist.getBinCounts();
-    size_t totalCount = hist.getTotalCount();
-    
+    computeFromCounts(hist.getBinCounts().data(), hist.getResolution(), hist.getTotalCount(),
+                      hist.getMin(), hist.getMax());
+}
+
+void CDF::computeFromCounts(const size_t* binCounts, size_t resolution, size_t totalCount, float min, float max) {
+    computeFromCounts(binCounts, resolution, totalCount, min, max, nullptr);
+}
+
+void CDF::computeFromHistogram(const Histogram& hist, CumulativeMoments& moments) {
+    computeFromCounts(hist.getBinCounts().data(), hist.getResolution(), hist.getTotalCount(),
+                      hist.getMin(), hist.getMax(), &moments);
+}
+
+void CDF::computeFromCounts(const size_t* binCounts, size_t resolution, size_t totalCount, float min, float max,
+                            CumulativeMoments* moments) {
     if (totalCount == 0) {
         throw std::runtime_error("Histogram has no data");
     }
+    if (resolution == 0 || !(min < max)) {
+        throw std::invalid_argument("Invalid histogram geometry");
+    }
     
-    resolution_ = hist.getResolution();
-    min_ = hist.getMin();
-    max_ = hist.getMax();
-    binWidth_ = hist.getBinWidth();
+    resolution_ = resolution;
+    min_ = min;
+    max_ = max;
+    binWidth_ = (max - min) / resolution;
     
     cdf_.resize(resolution_);
+    if (moments != nullptr) {
+        moments->counts.assign(resolution_ + 1, 0.0);
+        moments->moments.assign(resolution_ + 1, 0.0);
+        moments->entropy.assign(resolution_ + 1, 0.0);
+    }
     
-    // 计算累计分布
+    // 计算累计分布；两个入口共用这一循环，有无累计矩表时结果逐位一致
     float cumulative = 0.0f;
+    double count = 0.0;
+    double moment = 0.0;
+    double entropy = 0.0;
     for (size_t i = 0; i < resolution_; ++i) {
         cumulative += static_cast<float>(binCounts[i]) / totalCount;
         cdf_[i] = cumulative;
+
+        if (moments != nullptr) {
+            const double c = static_cast<double>(binCounts[i]);
+            count += c;
+            moment += static_cast<double>(i) * c;
+            entropy += c > 0.0 ? c * std::log(c) : 0.0;
+            moments->counts[i + 1] = count;
+            moments->moments[i + 1] = moment;
+            moments->entropy[i + 1] = entropy;
+        }
     }
     
     // 确保最后一个值为1.0（由于浮点精度问题）
@@ -47,6 +163,22 @@ float CDF::getCumulativeProbability(float value) const {
     return cdf_[binIndex];
 }
 
+void CDF::getCumulativeProbabilities(const float* values,
+                                     float* probabilities,
+                                     size_t count,
+                                     bool interpolate,
+                                     unsigned threads) const {
+    if (cdf_.empty()) {
+        throw std::runtime_error("CDF not computed");
+    }
+
+    detail::parallelFor(count, kBatchChunkSize, threads, [&](size_t begin, size_t end) {
+        evaluateCumulative(cdf_.data(), resolution_, min_, max_, binWidth_,
+                           values + begin, probabilities + begin, end - begin,
+                           interpolate);
+    });
+}
+
 float CDF::getPercentile(float percentile) const {
     if (percentile < 0.0f || percentile > 100.0f) {
         throw std::invalid_argument("Percentile must be between 0 and 100");
@@ -153,24 +285,10 @@ void CDF::exportHistogramAndCDFToFile(const Histogram& hist,
         return;
     }
     
-    const auto& cdfValues = cdf.getCDFValues();
-    
-    file << "bin索引,计数,bin最小值,bin最大值,CDF值,累计概率%\n";
-    
-    for (size_t i = 0; i < hist.getResolution(); ++i) {
-        auto range = hist.getBinRange(i);
-        size_t count = hist.getBinCount(i);
-        float cdfValue = cdfValues[i];
-        
-        if (showAll || count > 0) {
-            file << i << ","
-                 << count << ","
-                 << std::fixed << std::setprecision(2) << range.first << ","
-                 << std::fixed << std::setprecision(2) << range.second << ","
-                 << std::fixed << std::setprecision(6) << cdfValue << ","
-                 << std::fixed << std::setprecision(2) << (cdfValue * 100) << "%\n";
-        }
-    }
+    // 使用CSVExporter分块格式化，输出与逐行iostream格式化逐字节一致
+    CSVExporter::writeHistogramAndCDF(hist, cdf, [&file](const char* data, size_t size) {
+        file.write(data, static_cast<std::streamsize>(size));
+    }, showAll);
     
     file.close();
     std::cout << "   数据已导出到文件: " << filename << std::endl;
@@ -7,6 +7,17 @@
 
 namespace histogram {
 
+/**
+ * @brief 累计矩表，长度为bin数+1，第i项为前i个bin（不含第i个）的累计值
+ *
+ * 任意连续bin区间[a, b)的计数、一阶矩和熵项都可由两项相减在O(1)内得到，供阈值算法使用。
+ */
+struct CumulativeMoments {
+    std::vector<double> counts;   // Σ c_j
+    std::vector<double> moments;  // Σ j·c_j（以bin索引为坐标）
+    std::vector<double> entropy;  // Σ c_j·ln c_j
+};
+
 class CDF {
 public:
     /**
@@ -14,6 +25,23 @@ public:
      * @param hist 直方图对象
      */
     void computeFromHistogram(const Histogram& hist);
+
+    /**
+     * @brief 从计数数组计算累计分布函数（供不持有bins的视图使用，如MappedHistogram）
+     * @param counts bin计数
+     * @param resolution bin数量
+     * @param totalCount 总数据点数
+     * @param min 最小值
+     * @param max 最大值
+     */
+    void computeFromCounts(const size_t* counts, size_t resolution, size_t totalCount, float min, float max);
+
+    /**
+     * @brief 从直方图计算累计分布函数，并在同一遍扫描中求累计矩表
+     * @param hist 直方图对象
+     * @param moments 输出的累计矩表
+     */
+    void computeFromHistogram(const Histogram& hist, CumulativeMoments& moments);
     
     /**
      * @brief 获取指定值的累计概率
@@ -21,6 +49,20 @@ public:
      * @return 累计概率 [0, 1]
      */
     float getCumulativeProbability(float value) const;
+
+    /**
+     * @brief 批量计算累计概率（向量化、大输入分块并行）
+     * @param values 输入数据数组
+     * @param probabilities 输出累计概率数组，长度不小于count（可与values相同）
+     * @param count 数据个数
+     * @param interpolate 是否在bin内线性插值；为false时结果与getCumulativeProbability逐个计算一致
+     * @param threads 线程数（0表示使用硬件并发数）
+     */
+    void getCumulativeProbabilities(const float* values,
+                                    float* probabilities,
+                                    size_t count,
+                                    bool interpolate = false,
+                                    unsigned threads = 0) const;
     
     /**
      * @brief 获取指定百分位的值
@@ -48,6 +90,30 @@ public:
      * @return CDF值向量
      */
     const std::vector<float>& getCDFValues() const { return cdf_; }
+
+    /**
+     * @brief 获取最小值
+     * @return 最小值
+     */
+    float getMin() const { return min_; }
+
+    /**
+     * @brief 获取最大值
+     * @return 最大值
+     */
+    float getMax() const { return max_; }
+
+    /**
+     * @brief 获取bin宽度
+     * @return bin宽度
+     */
+    float getBinWidth() const { return binWidth_; }
+
+    /**
+     * @brief 获取分辨率
+     * @return bin数量
+     */
+    size_t getResolution() const { return resolution_; }
     
     /**
      * @brief 清除CDF数据
@@ -77,11 +143,17 @@ public:
                                            bool showAll = false);
 
 private:
+    /**
+     * @brief 两个公开入口共用的累计分布计算，moments非空时在同一遍扫描中求累计矩表
+     */
+    void computeFromCounts(const size_t* counts, size_t resolution, size_t totalCount, float min, float max,
+                           CumulativeMoments* moments);
+
     std::vector<float> cdf_; // 累计分布值
-    float min_;              // 最小值
-    float max_;              // 最大值
-    float binWidth_;         // bin宽度
-    size_t resolution_;      // 分辨率
+    float min_ = 0.0f;       // 最小值
+    float max_ = 0.0f;       // 最大值
+    float binWidth_ = 0.0f;  // bin宽度
+    size_t resolution_ = 0;  // 分辨率
 };
 
 } // namespace histogram
@@ -0,0 +1,150 @@
+#include "CSVExporter.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace histogram {
+
+namespace {
+
+// CSV表头，与CDF::exportHistogramAndCDFToFile一致
+const char kHeader[] = "bin索引,计数,bin最小值,bin最大值,CDF值,累计概率%\n";
+
+// 每个格式化块包含的行数
+constexpr size_t kRowsPerBlock = 16384;
+
+// 单行最大字节数：两个64位整数、四个定点浮点数（float最大值定点输出约45字节）及分隔符
+constexpr size_t kMaxRowBytes = 256;
+
+char* writeUnsigned(char* first, char* last, size_t value) {
+    auto result = std::to_chars(first, last, value);
+    if (result.ec != std::errc()) {
+        throw std::runtime_error("CSV row buffer overflow");
+    }
+    return result.ptr;
+}
+
+char* writeFixed(char* first, char* last, float value, int precision) {
+    auto result = std::to_chars(first, last, value, std::chars_format::fixed, precision);
+    if (result.ec != std::errc()) {
+        throw std::runtime_error("CSV row buffer overflow");
+    }
+    return result.ptr;
+}
+
+/**
+ * @brief 将[begin, end)范围内的bin格式化到缓冲区
+ * @return 写入的字节数
+ */
+size_t formatRows(const Histogram& hist, const float* cdfValues,
+                  size_t begin, size_t end, bool showAll, std::vector<char>& buffer) {
+    const auto& bins = hist.getBinCounts();
+    const size_t resolution = hist.getResolution();
+    const float minValue = hist.getMin();
+    const float maxValue = hist.getMax();
+    const float binWidth = hist.getBinWidth();
+
+    buffer.resize((end - begin) * kMaxRowBytes);
+    char* out = buffer.data();
+    char* last = buffer.data() + buffer.size();
+
+    for (size_t i = begin; i < end; ++i) {
+        size_t count = bins[i];
+        if (!showAll && count == 0) {
+            continue;
+        }
+
+        // 与Histogram::getBinRange相同的计算方式
+        float binMin = minValue + i * binWidth;
+        float binMax = (i == resolution - 1) ? maxValue : binMin + binWidth;
+        float cdfValue = cdfValues[i];
+
+        out = writeUnsigned(out, last, i);
+        *out++ = ',';
+        out = writeUnsigned(out, last, count);
+        *out++ = ',';
+        out = writeFixed(out, last, binMin, 2);
+        *out++ = ',';
+        out = writeFixed(out, last, binMax, 2);
+        *out++ = ',';
+        out = writeFixed(out, last, cdfValue, 6);
+        *out++ = ',';
+        out = writeFixed(out, last, cdfValue * 100, 2);
+        *out++ = '%';
+        *out++ = '\n';
+    }
+
+    return static_cast<size_t>(out - buffer.data());
+}
+
+} // namespace
+
+void CSVExporter::formatHistogramAndCDF(const Histogram& hist,
+                                        const CDF& cdf,
+                                        std::string& output,
+                                        bool showAll,
+                                        unsigned threads) {
+    writeHistogramAndCDF(hist, cdf, [&output](const char* data, size_t size) {
+        output.append(data, size);
+    }, showAll, threads);
+}
+
+void CSVExporter::writeHistogramAndCDF(const Histogram& hist,
+                                       const CDF& cdf,
+                                       const Sink& sink,
+                                       bool showAll,
+                                       unsigned threads) {
+    const auto& cdfValues = cdf.getCDFValues();
+    const size_t resolution = hist.getResolution();
+    if (cdfValues.size() != resolution) {
+        throw std::invalid_argument("CDF does not match histogram resolution");
+    }
+
+    sink(kHeader, sizeof(kHeader) - 1);
+
+    // 每一轮并行格式化threads个块，再按顺序写出，内存占用与分辨率无关
+    const size_t blockCount = (resolution + kRowsPerBlock - 1) / kRowsPerBlock;
+    const size_t wave = detail::resolveThreadCount(threads);
+    std::vector<std::vector<char>> buffers(std::min(wave, std::max<size_t>(blockCount, 1)));
+    std::vector<size_t> sizes(buffers.size());
+
+    for (size_t waveBegin = 0; waveBegin < blockCount; waveBegin += buffers.size()) {
+        size_t waveBlocks = std::min(buffers.size(), blockCount - waveBegin);
+        detail::parallelFor(waveBlocks, 1, static_cast<unsigned>(waveBlocks), [&](size_t b, size_t e) {
+            for (size_t slot = b; slot < e; ++slot) {
+                size_t begin = (waveBegin + slot) * kRowsPerBlock;
+                size_t end = std::min(begin + kRowsPerBlock, resolution);
+                sizes[slot] = formatRows(hist, cdfValues.data(), begin, end, showAll, buffers[slot]);
+            }
+        });
+        for (size_t slot = 0; slot < waveBlocks; ++slot) {
+            if (sizes[slot] > 0) {
+                sink(buffers[slot].data(), sizes[slot]);
+            }
+        }
+    }
+}
+
+void CSVExporter::exportHistogramAndCDFToFile(const Histogram& hist,
+                                              const CDF& cdf,
+                                              const std::string& filename,
+                                              bool showAll,
+                                              unsigned threads) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+
+    writeHistogramAndCDF(hist, cdf, [&file](const char* data, size_t size) {
+        file.write(data, static_cast<std::streamsize>(size));
+    }, showAll, threads);
+
+    if (!file) {
+        throw std::runtime_error("Failed to write file: " + filename);
+    }
+}
+
+} // namespace histogram
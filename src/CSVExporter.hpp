@@ -0,0 +1,69 @@
+#ifndef CSV_EXPORTER_HPP
+#define CSV_EXPORTER_HPP
+
+#include "Histogram.hpp"
+#include "CDF.hpp"
+#include <functional>
+#include <string>
+
+namespace histogram {
+
+/**
+ * @brief 直方图和CDF的快速文本导出
+ *
+ * 输出格式与CDF::exportHistogramAndCDFToFile完全一致（逐字节相同），
+ * 但使用std::to_chars格式化到可复用的大缓冲区，并按块整体写出。
+ */
+class CSVExporter {
+public:
+    /**
+     * @brief 输出目标，每次接收一整块已格式化的数据
+     */
+    using Sink = std::function<void(const char* data, size_t size)>;
+
+    /**
+     * @brief 格式化直方图和CDF并追加到字符串
+     * @param hist 直方图对象
+     * @param cdf CDF对象（需由hist计算得到）
+     * @param output 输出字符串（追加写入）
+     * @param showAll 是否显示所有bin（包括计数为0的）
+     * @param threads 格式化线程数（0表示使用硬件并发数）
+     */
+    static void formatHistogramAndCDF(const Histogram& hist,
+                                      const CDF& cdf,
+                                      std::string& output,
+                                      bool showAll = false,
+                                      unsigned threads = 1);
+
+    /**
+     * @brief 格式化直方图和CDF并分块写入任意输出目标
+     * @param hist 直方图对象
+     * @param cdf CDF对象（需由hist计算得到）
+     * @param sink 输出目标，按行顺序接收数据块
+     * @param showAll 是否显示所有bin（包括计数为0的）
+     * @param threads 格式化线程数（0表示使用硬件并发数）
+     */
+    static void writeHistogramAndCDF(const Histogram& hist,
+                                     const CDF& cdf,
+                                     const Sink& sink,
+                                     bool showAll = false,
+                                     unsigned threads = 1);
+
+    /**
+     * @brief 导出直方图和CDF到文本文件
+     * @param hist 直方图对象
+     * @param cdf CDF对象（需由hist计算得到）
+     * @param filename 输出文件名
+     * @param showAll 是否显示所有bin（包括计数为0的）
+     * @param threads 格式化线程数（0表示使用硬件并发数）
+     */
+    static void exportHistogramAndCDFToFile(const Histogram& hist,
+                                            const CDF& cdf,
+                                            const std::string& filename,
+                                            bool showAll = false,
+                                            unsigned threads = 0);
+};
+
+} // namespace histogram
+
+#endif // CSV_EXPORTER_HPP
@@ -0,0 +1,374 @@
+#include "CompactHistogram.hpp"
+#include "ByteIO.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+
+namespace histogram {
+
+namespace {
+
+constexpr char kMagic[4] = {'H', 'S', 'T', 'C'};
+constexpr uint8_t kFormatVersion = 1;
+
+/**
+ * @brief 固定起点a，依次检查每个终点b：[a, b)内所有bin边界到弦的距离不超过tolerance时调用visit(b)
+ * @param cumulative 累计计数，长度为L+1
+ * @param a 起点（bin边界索引）
+ * @param tolerance 允许的累计计数误差
+ * @param visit 对每个可行终点调用
+ *
+ * 中间点j要求弦的斜率落在[(C_j - E - C_a)/(j - a), (C_j + E - C_a)/(j - a)]内，
+ * 这些区间的交随终点右移单调收缩，为空后不再有可行终点。
+ */
+template <typename Visit>
+void forEachFeasibleEnd(const std::vector<double>& cumulative, size_t a, double tolerance, Visit visit) {
+    const size_t last = cumulative.size() - 1;
+    double low = -std::numeric_limits<double>::infinity();
+    double high = std::numeric_limits<double>::infinity();
+    for (size_t b = a + 1; b <= last; ++b) {
+        const double span = static_cast<double>(b - a);
+        const double rise = cumulative[b] - cumulative[a];
+        const double slope = rise / span;
+        if (low <= slope && slope <= high) {
+            visit(b);
+        }
+        low = std::max(low, (rise - tolerance) / span);
+        high = std::min(high, (rise + tolerance) / span);
+        if (low > high) {
+            break;
+        }
+    }
+}
+
+} // namespace
+
+CompactHistogram::CompactHistogram(const Histogram& hist, std::vector<size_t> edges)
+    : min_(hist.getMin()), max_(hist.getMax()), originalResolution_(hist.getResolution()),
+      totalCount_(0), edges_(std::move(edges)) {
+    const auto& bins = hist.getBinCounts();
+    counts_.resize(edges_.size() - 1);
+    for (size_t k = 0; k < counts_.size(); ++k) {
+        size_t sum = 0;
+        for (size_t i = edges_[k]; i < edges_[k + 1]; ++i) {
+            sum += bins[i];
+        }
+        counts_[k] = sum;
+    }
+    computeCumulative();
+}
+
+void CompactHistogram::computeCumulative() {
+    cumulative_.resize(counts_.size() + 1);
+    cumulative_[0] = 0;
+    for (size_t k = 0; k < counts_.size(); ++k) {
+        cumulative_[k + 1] = cumulative_[k] + counts_[k];
+    }
+    totalCount_ = cumulative_.back();
+}
+
+CompactHistogram CompactHistogram::compactByQuantileError(const Histogram& hist, double maxRankError,
+                                                          bool optimal) {
+    if (!(maxRankError >= 0.0)) {
+        throw std::invalid_argument("maxRankError must not be negative");
+    }
+    const auto& bins = hist.getBinCounts();
+    const size_t resolution = bins.size();
+    std::vector<double> cumulative(resolution + 1, 0.0);
+    for (size_t i = 0; i < resolution; ++i) {
+        cumulative[i + 1] = cumulative[i] + static_cast<double>(bins[i]);
+    }
+    const double tolerance = maxRankError * cumulative.back();
+
+    // 贪心：每个bucket取最远的可行终点
+    std::vector<size_t> edges;
+    size_t start = 0;
+    edges.push_back(0);
+    while (start < resolution) {
+        size_t farthest = start + 1;
+        forEachFeasibleEnd(cumulative, start, tolerance, [&](size_t b) { farthest = b; });
+        edges.push_back(farthest);
+        start = farthest;
+    }
+
+    if (optimal) {
+        // 动态规划：best[b]为覆盖前b个bin所需的最少bucket数。
+        // 以贪心的bucket数为上界，经过a的划分至少best[a] + 1个bucket，不少于上界时不必从a扩展
+        const size_t bound = edges.size() - 1;
+        std::vector<size_t> best(resolution + 1, bound); // 未到达的位置记为上界
+        std::vector<size_t> parent(resolution + 1, 0);
+        best[0] = 0;
+        for (size_t a = 0; a < resolution; ++a) {
+            const size_t next = best[a] + 1;
+            if (next >= std::min(bound, best[resolution])) {
+                continue;
+            }
+            forEachFeasibleEnd(cumulative, a, tolerance, [&](size_t b) {
+                if (next < best[b]) {
+                    best[b] = next;
+                    parent[b] = a;
+                }
+            });
+        }
+        if (best[resolution] < bound) {
+            edges.resize(best[resolution] + 1);
+            for (size_t b = resolution, k = edges.size() - 1; k > 0; b = parent[b], --k) {
+                edges[k] = b;
+            }
+            edges[0] = 0;
+        }
+    }
+    return CompactHistogram(hist, std::move(edges));
+}
+
+CompactHistogram CompactHistogram::compactByTotalVariation(const Histogram& hist, double maxDistance) {
+    if (!(maxDistance >= 0.0)) {
+        throw std::invalid_argument("maxDistance must not be negative");
+    }
+    const auto& bins = hist.getBinCounts();
+    const size_t resolution = bins.size();
+
+    // 计数相同的连续bin合并为游程，合并代价为0
+    std::vector<size_t> runStarts;
+    std::vector<double> runValues;
+    size_t binTotal = 0; // 各bin之和；不同几何merge后getTotalCount()可能包含落在范围外的计数
+    for (size_t i = 0; i < resolution; ++i) {
+        binTotal += bins[i];
+        if (i == 0 || bins[i] != bins[i - 1]) {
+            runStarts.push_back(i);
+            runValues.push_back(static_cast<double>(bins[i]));
+        }
+    }
+    const size_t runCount = runStarts.size();
+    runStarts.push_back(resolution);
+
+    // bucket以首个游程的索引标识，覆盖游程[r, end)
+    struct Bucket {
+        size_t end;      // 结束游程（不含）
+        size_t prev;     // 前一个bucket，runCount表示没有
+        double sum;      // 计数和
+        double cost;     // Σ|c_i - 均值|
+        size_t version;  // 每次合并后递增，使堆中的旧候选失效
+    };
+    std::vector<Bucket> buckets(runCount);
+    for (size_t r = 0; r < runCount; ++r) {
+        const double length = static_cast<double>(runStarts[r + 1] - runStarts[r]);
+        buckets[r] = {r + 1, r == 0 ? runCount : r - 1, runValues[r] * length, 0.0, 0};
+    }
+
+    // 均值随合并变化，绝对偏差无法由前缀和得到，逐个游程求和；代价与合并后bucket的游程数成正比
+    auto mergedCost = [&](size_t left, size_t end, double sum) {
+        const double mean = sum / static_cast<double>(runStarts[end] - runStarts[left]);
+        double cost = 0.0;
+        for (size_t r = left; r < end; ++r) {
+            cost += std::abs(runValues[r] - mean) * static_cast<double>(runStarts[r + 1] - runStarts[r]);
+        }
+        return cost;
+    };
+
+    struct Candidate {
+        double delta;         // 合并增加的代价
+        size_t left;          // 左bucket
+        size_t leftVersion;   // 生成候选时左bucket的版本
+        size_t rightVersion;  // 生成候选时右bucket的版本
+        bool operator>(const Candidate& other) const { return delta > other.delta; }
+    };
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> queue;
+    auto push = [&](size_t left) {
+        const size_t right = buckets[left].end;
+        if (right >= runCount) {
+            return;
+        }
+        const double sum = buckets[left].sum + buckets[right].sum;
+        const double delta = mergedCost(left, buckets[right].end, sum) - buckets[left].cost - buckets[right].cost;
+        queue.push({delta, left, buckets[left].version, buckets[right].version});
+    };
+    for (size_t r = 0; r + 1 < runCount; ++r) {
+        push(r);
+    }
+
+    // 总变差距离为Σ|c_i - q_i|/(2N)
+    const double budget = 2.0 * maxDistance * static_cast<double>(binTotal);
+    double used = 0.0;
+    while (!queue.empty()) {
+        const Candidate candidate = queue.top();
+        queue.pop();
+        const size_t left = candidate.left;
+        const size_t right = buckets[left].end;
+        if (buckets[left].version != candidate.leftVersion || right >= runCount ||
+            buckets[right].version != candidate.rightVersion) {
+            continue;
+        }
+        if (used + candidate.delta > budget) {
+            break; // 其余候选的代价都不更小
+        }
+        used += candidate.delta;
+
+        Bucket& merged = buckets[left];
+        merged.sum += buckets[right].sum;
+        merged.cost += buckets[right].cost + candidate.delta;
+        merged.end = buckets[right].end;
+        ++merged.version;
+        ++buckets[right].version;
+        if (merged.end < runCount) {
+            buckets[merged.end].prev = left;
+        }
+        if (merged.prev < runCount) {
+            push(merged.prev);
+        }
+        push(left);
+    }
+
+    std::vector<size_t> edges;
+    for (size_t r = 0; r < runCount; r = buckets[r].end) {
+        edges.push_back(runStarts[r]);
+    }
+    edges.push_back(resolution);
+    return CompactHistogram(hist, std::move(edges));
+}
+
+size_t CompactHistogram::getBucketCount(size_t bucket) const {
+    if (bucket >= counts_.size()) {
+        throw std::out_of_range("bucket out of range");
+    }
+    return counts_[bucket];
+}
+
+float CompactHistogram::edgeValue(size_t bin) const {
+    if (bin == originalResolution_) {
+        return max_;
+    }
+    const float binWidth = (max_ - min_) / originalResolution_;
+    return min_ + bin * binWidth;
+}
+
+std::pair<float, float> CompactHistogram::getBucketRange(size_t bucket) const {
+    if (bucket >= counts_.size()) {
+        throw std::out_of_range("bucket out of range");
+    }
+    return {edgeValue(edges_[bucket]), edgeValue(edges_[bucket + 1])};
+}
+
+double CompactHistogram::getCumulativeProbability(float value) const {
+    if (totalCount_ == 0) {
+        throw std::runtime_error("Histogram has no data");
+    }
+    if (value < min_) return 0.0;
+    if (value >= max_) return 1.0;
+
+    // 第一个下边界大于value的bucket之前的那个
+    size_t low = 0;
+    size_t high = counts_.size();
+    while (high - low > 1) {
+        const size_t mid = low + (high - low) / 2;
+        if (edgeValue(edges_[mid]) <= value) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    const auto range = getBucketRange(low);
+    const double fraction = (static_cast<double>(value) - range.first) / (range.second - range.first);
+    return (static_cast<double>(cumulative_[low]) + fraction * static_cast<double>(counts_[low])) /
+           static_cast<double>(totalCount_);
+}
+
+float CompactHistogram::getPercentile(float percentile) const {
+    if (percentile < 0.0f || percentile > 100.0f) {
+        throw std::invalid_argument("Percentile must be between 0 and 100");
+    }
+    if (totalCount_ == 0) {
+        throw std::runtime_error("Histogram has no data");
+    }
+
+    // 第一个累计计数不小于目标的bucket；目标为0时取第一个非空bucket的下边界
+    const double target = percentile / 100.0 * static_cast<double>(totalCount_);
+    size_t bucket = static_cast<size_t>(
+        std::lower_bound(cumulative_.begin() + 1, cumulative_.end(), target,
+                         [](size_t cumulative, double t) { return static_cast<double>(cumulative) < t; }) -
+        (cumulative_.begin() + 1));
+    bucket = std::min(bucket, counts_.size() - 1);
+    while (counts_[bucket] == 0) {
+        ++bucket;
+    }
+    const auto range = getBucketRange(bucket);
+    const double fraction = (target - static_cast<double>(cumulative_[bucket])) / static_cast<double>(counts_[bucket]);
+    return static_cast<float>(range.first + std::max(0.0, fraction) * (range.second - range.first));
+}
+
+Histogram CompactHistogram::toHistogram() const {
+    Histogram hist(min_, max_, originalResolution_);
+    for (size_t k = 0; k < counts_.size(); ++k) {
+        const size_t width = edges_[k + 1] - edges_[k];
+        const size_t base = counts_[k] / width;
+        const size_t remainder = counts_[k] % width;
+        for (size_t j = 0; j < width; ++j) {
+            // 余数均匀地分散到bucket内
+            const size_t count = base + ((j + 1) * remainder) / width - (j * remainder) / width;
+            if (count > 0) {
+                hist.addBinCount(edges_[k] + j, count);
+            }
+        }
+    }
+    return hist;
+}
+
+void CompactHistogram::serialize(std::string& output) const {
+    output.append(kMagic, sizeof(kMagic));
+    detail::appendLittleEndian(output, kFormatVersion);
+    detail::appendLittleEndian(output, min_);
+    detail::appendLittleEndian(output, max_);
+    detail::appendVarint(output, originalResolution_);
+    detail::appendVarint(output, totalCount_);
+    detail::appendVarint(output, counts_.size());
+    for (size_t k = 0; k < counts_.size(); ++k) {
+        detail::appendVarint(output, edges_[k + 1] - edges_[k]);
+        detail::appendVarint(output, counts_[k]);
+    }
+}
+
+CompactHistogram CompactHistogram::deserialize(const char* data, size_t size) {
+    detail::ByteReader reader(data, size);
+    if (!std::equal(kMagic, kMagic + sizeof(kMagic), reader.readBytes(sizeof(kMagic)))) {
+        throw std::runtime_error("Invalid CompactHistogram data");
+    }
+    if (reader.readLittleEndian<uint8_t>() != kFormatVersion) {
+        throw std::runtime_error("Unsupported CompactHistogram data version");
+    }
+
+    CompactHistogram result;
+    result.min_ = reader.readLittleEndian<float>();
+    result.max_ = reader.readLittleEndian<float>();
+    const uint64_t resolution = reader.readVarint();
+    const uint64_t totalCount = reader.readVarint();
+    const uint64_t bucketCount = reader.readVarint();
+    if (!(result.min_ < result.max_) || resolution == 0 || bucketCount == 0 || bucketCount > resolution) {
+        throw std::runtime_error("Invalid CompactHistogram data");
+    }
+    // 每个bucket至少占两个字节（宽度和计数各一个变长整数），先按剩余数据校验再预留空间
+    if (bucketCount > reader.remaining() / 2) {
+        throw std::runtime_error("Invalid CompactHistogram data");
+    }
+    result.originalResolution_ = static_cast<size_t>(resolution);
+
+    result.edges_.reserve(static_cast<size_t>(bucketCount) + 1);
+    result.counts_.reserve(static_cast<size_t>(bucketCount));
+    result.edges_.push_back(0);
+    for (uint64_t k = 0; k < bucketCount; ++k) {
+        const uint64_t width = reader.readVarint();
+        if (width == 0 || width > resolution - result.edges_.back()) {
+            throw std::runtime_error("Invalid CompactHistogram data");
+        }
+        result.edges_.push_back(result.edges_.back() + static_cast<size_t>(width));
+        result.counts_.push_back(static_cast<size_t>(reader.readVarint()));
+    }
+    result.computeCumulative();
+    if (result.edges_.back() != resolution || result.totalCount_ != totalCount || reader.remaining() != 0) {
+        throw std::runtime_error("Invalid CompactHistogram data");
+    }
+    return result;
+}
+
+} // namespace histogram
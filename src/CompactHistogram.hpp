@@ -0,0 +1,162 @@
+#ifndef COMPACT_HISTOGRAM_HPP
+#define COMPACT_HISTOGRAM_HPP
+
+#include "Histogram.hpp"
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace histogram {
+
+/**
+ * @brief 有损压缩的变宽直方图：把相邻bin合并为bucket，误差不超过给定上界，用于长期存储
+ *
+ * bucket的边界总是原始bin的边界，bucket内按均匀分布处理，CDF在bucket边界之间线性插值
+ * （与CDF::getPercentile在bin内的插值一致）。两种误差准则：
+ * - 分位误差：在每个原始bin边界上，压缩后的CDF与原直方图CDF之差不超过maxRankError
+ *   （两者都分段线性，因此任意值处都成立；百分位查询的秩误差同样有界）。
+ *   固定起点时可行的终点由斜率区间的交判断，逐步收缩，每个候选终点O(1)；
+ *   贪心取最远的可行终点，最优解用动态规划求最少的bucket数。maxRankError = 0时只合并计数相同的bin，是无损的。
+ * - 总变差距离：压缩后在原始bin上的分布与原分布的总变差距离不超过maxDistance。
+ *   先把计数相同的连续bin合并为游程，再按合并代价从小到大自底向上合并相邻bucket，直到预算用完。
+ *   每个候选的代价要遍历合并后bucket的所有游程（绝对偏差没有前缀和形式），
+ *   因此游程数为L时最坏O(L²)（如合并成少数几个大bucket），游程较少或预算较小时接近O(L log L)。
+ *
+ * 查询对bucket边界二分，代价O(log bucket数)。
+ */
+class CompactHistogram {
+public:
+    /**
+     * @brief 按分位（秩）误差上界压缩
+     * @param hist 直方图
+     * @param maxRankError CDF的最大绝对误差（0-1）
+     * @param optimal true用动态规划求最少的bucket数（最坏O(L²)），false用贪心（通常接近最优）
+     * @return 压缩结果
+     */
+    static CompactHistogram compactByQuantileError(const Histogram& hist, double maxRankError,
+                                                   bool optimal = false);
+
+    /**
+     * @brief 按总变差距离上界压缩
+     * @param hist 直方图
+     * @param maxDistance 与原分布的最大总变差距离（0-1）
+     * @return 压缩结果
+     */
+    static CompactHistogram compactByTotalVariation(const Histogram& hist, double maxDistance);
+
+    /**
+     * @brief 获取bucket数量
+     * @return bucket数量
+     */
+    size_t getResolution() const { return counts_.size(); }
+
+    /**
+     * @brief 获取原直方图的bin数量
+     * @return 原始bin数量
+     */
+    size_t getOriginalResolution() const { return originalResolution_; }
+
+    /**
+     * @brief 获取指定bucket的计数值
+     * @param bucket bucket索引
+     * @return 计数值
+     */
+    size_t getBucketCount(size_t bucket) const;
+
+    /**
+     * @brief 获取指定bucket的值范围
+     * @param bucket bucket索引
+     * @return 值范围对 (min, max)
+     */
+    std::pair<float, float> getBucketRange(size_t bucket) const;
+
+    /**
+     * @brief 获取bucket边界（以原始bin索引表示，长度为bucket数+1）
+     * @return 边界数组，第k个bucket覆盖原始bin [edges[k], edges[k + 1])
+     */
+    const std::vector<size_t>& getEdges() const { return edges_; }
+
+    /**
+     * @brief 获取最小值
+     * @return 最小值
+     */
+    float getMin() const { return min_; }
+
+    /**
+     * @brief 获取最大值
+     * @return 最大值
+     */
+    float getMax() const { return max_; }
+
+    /**
+     * @brief 获取总数据点数
+     * @return 总数据点数
+     */
+    size_t getTotalCount() const { return totalCount_; }
+
+    /**
+     * @brief 获取指定值的累计概率（bucket内线性插值）
+     * @param value 数据值
+     * @return 累计概率
+     */
+    double getCumulativeProbability(float value) const;
+
+    /**
+     * @brief 获取指定百分位的值
+     * @param percentile 百分位 [0, 100]
+     * @return 对应的数据值
+     */
+    float getPercentile(float percentile) const;
+
+    /**
+     * @brief 展开为原分辨率的直方图，每个bucket的计数尽量均匀地分到其中的bin
+     * @return 直方图
+     */
+    Histogram toHistogram() const;
+
+    /**
+     * @brief 序列化为紧凑的二进制格式（追加到output）
+     * @param output 输出字符串
+     *
+     * 格式："HSTC"、版本号、最小值和最大值（小端float），随后是LEB128变长编码的原始bin数、
+     * 总数据点数、bucket数，以及每个bucket的宽度（bin数）和计数。
+     */
+    void serialize(std::string& output) const;
+
+    /**
+     * @brief 从serialize()的输出构造
+     * @param data 序列化数据
+     * @param size 数据字节数
+     * @return 压缩直方图
+     */
+    static CompactHistogram deserialize(const char* data, size_t size);
+
+private:
+    CompactHistogram(const Histogram& hist, std::vector<size_t> edges);
+    CompactHistogram() = default;
+
+    /**
+     * @brief 原始bin边界对应的数据值，与Histogram::getBinRange相同的计算方式
+     * @param bin 原始bin边界索引 [0, originalResolution_]
+     * @return 数据值
+     */
+    float edgeValue(size_t bin) const;
+
+    /**
+     * @brief 由计数重新计算累计计数
+     */
+    void computeCumulative();
+
+    float min_ = 0.0f;                 // 最小值
+    float max_ = 0.0f;                 // 最大值
+    size_t originalResolution_ = 0;    // 原始bin数量
+    size_t totalCount_ = 0;            // 总数据点数
+    std::vector<size_t> edges_;        // bucket边界（原始bin索引）
+    std::vector<size_t> counts_;       // 各bucket的计数
+    std::vector<size_t> cumulative_;   // 前k个bucket的累计计数，长度为bucket数+1
+};
+
+} // namespace histogram
+
+#endif // COMPACT_HISTOGRAM_HPP
@@ -0,0 +1,286 @@
+#include "FFTConvolver.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace histogram {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// 最小FFT长度（实数变换需要至少两个复数点）
+constexpr size_t kMinFFTSize = 4;
+
+size_t nextPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+size_t log2OfPowerOfTwo(size_t value) {
+    size_t result = 0;
+    while ((size_t(1) << result) < value) {
+        ++result;
+    }
+    return result;
+}
+
+// 手工展开的复数乘法，避免std::complex为处理inf/NaN而调用的慢速路径
+inline std::complex<double> multiply(const std::complex<double>& a, const std::complex<double>& b) {
+    return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+}
+
+} // namespace
+
+/**
+ * @brief 长度为size的实数FFT计划，内部使用size/2点复数FFT
+ */
+struct FFTConvolver::Plan {
+    size_t size;                                     // 实数FFT长度N
+    size_t half;                                     // 复数FFT长度N/2
+    std::vector<uint32_t> bitReverse;                // 复数FFT的位反转表
+    std::vector<std::complex<double>> twiddles;      // exp(-2πik/half), k < half/2
+    std::vector<std::complex<double>> realTwiddles;  // exp(-2πik/N), k <= half
+
+    explicit Plan(size_t n) : size(n), half(n / 2) {
+        size_t bits = log2OfPowerOfTwo(half);
+        bitReverse.resize(half);
+        for (size_t i = 0; i < half; ++i) {
+            size_t reversed = 0;
+            for (size_t b = 0; b < bits; ++b) {
+                reversed |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            bitReverse[i] = static_cast<uint32_t>(reversed);
+        }
+
+        twiddles.resize(std::max<size_t>(half / 2, 1));
+        for (size_t k = 0; k < twiddles.size(); ++k) {
+            twiddles[k] = std::polar(1.0, -2.0 * kPi * k / half);
+        }
+
+        realTwiddles.resize(half + 1);
+        for (size_t k = 0; k <= half; ++k) {
+            realTwiddles[k] = std::polar(1.0, -2.0 * kPi * k / n);
+        }
+    }
+
+    /**
+     * @brief 原地复数FFT（基2，按时间抽取）；逆变换不做1/half缩放
+     */
+    void complexTransform(std::complex<double>* data, bool inverse) const {
+        for (size_t i = 0; i < half; ++i) {
+            size_t j = bitReverse[i];
+            if (i < j) {
+                std::swap(data[i], data[j]);
+            }
+        }
+
+        for (size_t length = 2; length <= half; length <<= 1) {
+            size_t step = half / length;
+            size_t halfLength = length / 2;
+            for (size_t start = 0; start < half; start += length) {
+                for (size_t k = 0; k < halfLength; ++k) {
+                    std::complex<double> w = twiddles[k * step];
+                    if (inverse) {
+                        w = std::conj(w);
+                    }
+                    std::complex<double> u = data[start + k];
+                    std::complex<double> v = multiply(data[start + k + halfLength], w);
+                    data[start + k] = u + v;
+                    data[start + k + halfLength] = u - v;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief 实数正变换：input[N] -> spectrum[N/2 + 1]
+     */
+    void forwardReal(const double* input, std::complex<double>* spectrum,
+                     std::complex<double>* work) const {
+        // 把偶数/奇数样本打包为复数序列 z[k] = x[2k] + i·x[2k+1]
+        for (size_t k = 0; k < half; ++k) {
+            work[k] = std::complex<double>(input[2 * k], input[2 * k + 1]);
+        }
+        complexTransform(work, false);
+
+        // X[k] = E[k] + W^k·O[k]，其中 E = (Z[k] + conj(Z[half-k]))/2，O = (Z[k] - conj(Z[half-k]))/(2i)
+        for (size_t k = 0; k <= half; ++k) {
+            std::complex<double> z = work[k % half];
+            std::complex<double> zc = std::conj(work[(half - k) % half]);
+            std::complex<double> even = 0.5 * (z + zc);
+            std::complex<double> diff = z - zc;
+            std::complex<double> odd(0.5 * diff.imag(), -0.5 * diff.real());
+            spectrum[k] = even + multiply(realTwiddles[k], odd);
+        }
+    }
+
+    /**
+     * @brief 实数逆变换：spectrum[N/2 + 1] -> output[N]（含1/N缩放）
+     */
+    void inverseReal(const std::complex<double>* spectrum, double* output,
+                     std::complex<double>* work) const {
+        // E[k] = (X[k] + conj(X[half-k]))/2，O[k] = (X[k] - conj(X[half-k]))/2·conj(W^k)，Z = E + i·O
+        for (size_t k = 0; k < half; ++k) {
+            std::complex<double> x = spectrum[k];
+            std::complex<double> xc = std::conj(spectrum[half - k]);
+            std::complex<double> even = 0.5 * (x + xc);
+            std::complex<double> odd = multiply(0.5 * (x - xc), std::conj(realTwiddles[k]));
+            work[k] = even + std::complex<double>(-odd.imag(), odd.real());
+        }
+        complexTransform(work, true);
+
+        const double scale = 1.0 / static_cast<double>(half);
+        for (size_t k = 0; k < half; ++k) {
+            output[2 * k] = work[k].real() * scale;
+            output[2 * k + 1] = work[k].imag() * scale;
+        }
+    }
+};
+
+std::shared_ptr<const FFTConvolver::Plan> FFTConvolver::getPlan(size_t size) {
+    static std::mutex mutex;
+    static std::map<size_t, std::shared_ptr<const Plan>> plans;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& plan = plans[size];
+    if (!plan) {
+        plan = std::make_shared<const Plan>(size);
+    }
+    return plan;
+}
+
+double FFTConvolver::estimateCostPerSample(size_t kernelSize, size_t size) {
+    size_t fftSize = chooseFFTSize(kernelSize, size);
+    size_t block = fftSize - kernelSize + 1;
+    // 每块一次正变换和一次逆变换，各约 (N/2)·log2(N/2) 次复数蝶形运算，再加频域逐点乘法
+    double half = static_cast<double>(fftSize / 2);
+    double perBlock = 2.0 * half * std::log2(half) + 2.0 * half;
+    return perBlock / static_cast<double>(std::min(block, std::max<size_t>(size, 1)));
+}
+
+size_t FFTConvolver::chooseFFTSize(size_t kernelSize, size_t size) {
+    if (kernelSize == 0) {
+        throw std::invalid_argument("Kernel must not be empty");
+    }
+
+    // 单块即可覆盖整个输入时的长度，作为上限
+    size_t single = std::max(nextPowerOfTwo(size + kernelSize - 1), kMinFFTSize);
+
+    // 在核长度的2~64倍之间选择每个输出代价最小的FFT长度
+    size_t best = single;
+    double bestCost = std::numeric_limits<double>::infinity();
+    size_t largest = std::min(single, 64 * nextPowerOfTwo(kernelSize));
+    for (size_t n = std::max(nextPowerOfTwo(2 * kernelSize), kMinFFTSize); n <= largest; n <<= 1) {
+        double half = static_cast<double>(n / 2);
+        double cost = (2.0 * half * std::log2(std::max(half, 2.0)) + 2.0 * half)
+                    / static_cast<double>(std::min(n - kernelSize + 1, std::max<size_t>(size, 1)));
+        if (cost < bestCost) {
+            best = n;
+            bestCost = cost;
+        }
+    }
+    return best;
+}
+
+FFTConvolver::FFTConvolver(const std::vector<float>& kernel, size_t blockSize)
+    : kernelSize_(kernel.size()) {
+    if (kernel.empty()) {
+        throw std::invalid_argument("Kernel must not be empty");
+    }
+
+    if (blockSize == 0) {
+        // 未指定时按长输入选择；短输入在convolve中仍然正确，只是多做一些补零
+        fftSize_ = chooseFFTSize(kernelSize_, 64 * nextPowerOfTwo(kernelSize_));
+    } else {
+        fftSize_ = std::max(nextPowerOfTwo(blockSize + kernelSize_ - 1), kMinFFTSize);
+    }
+    blockSize_ = fftSize_ - kernelSize_ + 1;
+    plan_ = getPlan(fftSize_);
+
+    // 核补零到FFT长度后的频谱
+    std::vector<double> padded(fftSize_, 0.0);
+    std::copy(kernel.begin(), kernel.end(), padded.begin());
+    std::vector<std::complex<double>> work(fftSize_ / 2);
+    kernelSpectrum_.resize(fftSize_ / 2 + 1);
+    plan_->forwardReal(padded.data(), kernelSpectrum_.data(), work.data());
+}
+
+void FFTConvolver::convolve(const float* input, float* output, size_t size) const {
+    convolveImpl(input, output, size, 0, size);
+}
+
+void FFTConvolver::convolve(const size_t* input, float* output, size_t size) const {
+    convolveImpl(input, output, size, 0, size);
+}
+
+void FFTConvolver::convolve(const float* input, float* output, size_t size,
+                            size_t begin, size_t end) const {
+    convolveImpl(input, output, size, begin, std::min(end, size));
+}
+
+void FFTConvolver::convolve(const size_t* input, float* output, size_t size,
+                            size_t begin, size_t end) const {
+    convolveImpl(input, output, size, begin, std::min(end, size));
+}
+
+template <typename T>
+void FFTConvolver::convolveImpl(const T* input, float* output, size_t size,
+                                size_t begin, size_t end) const {
+    if (begin >= end) {
+        return;
+    }
+    const Plan& plan = *plan_;
+    const size_t center = kernelSize_ / 2;
+    const size_t outputsPerBlock = blockSize_ + kernelSize_ - 1;
+
+    thread_local std::vector<double> signal;
+    thread_local std::vector<std::complex<double>> spectrum;
+    thread_local std::vector<std::complex<double>> work;
+    detail::ScratchRelease<double> releaseSignal(signal);
+    detail::ScratchRelease<std::complex<double>> releaseSpectrum(spectrum);
+    detail::ScratchRelease<std::complex<double>> releaseWork(work);
+    signal.resize(std::max(signal.size(), fftSize_));
+    spectrum.resize(std::max(spectrum.size(), fftSize_ / 2 + 1));
+    work.resize(std::max(work.size(), fftSize_ / 2));
+
+    std::fill(output + begin, output + end, 0.0f);
+
+    // 重叠相加：第b块的完整线性卷积结果第m项对应输出索引 blockStart + m - center。
+    // 只处理输出落在[begin, end)内的块，跳过的块对该范围没有贡献，累加顺序不变
+    size_t firstBlock = 0;
+    if (begin + center >= outputsPerBlock) {
+        firstBlock = (begin + center - outputsPerBlock) / blockSize_;
+    }
+    for (size_t blockStart = firstBlock * blockSize_; blockStart < size && blockStart < end + center;
+         blockStart += blockSize_) {
+        size_t length = std::min(blockSize_, size - blockStart);
+        for (size_t i = 0; i < length; ++i) {
+            signal[i] = static_cast<double>(input[blockStart + i]);
+        }
+        std::fill(signal.begin() + length, signal.begin() + fftSize_, 0.0);
+
+        plan.forwardReal(signal.data(), spectrum.data(), work.data());
+        for (size_t k = 0; k <= fftSize_ / 2; ++k) {
+            spectrum[k] = multiply(spectrum[k], kernelSpectrum_[k]);
+        }
+        plan.inverseReal(spectrum.data(), signal.data(), work.data());
+
+        size_t mBegin = begin + center > blockStart ? begin + center - blockStart : 0;
+        size_t mEnd = std::min(std::min(length + kernelSize_ - 1, outputsPerBlock),
+                               end + center - blockStart);
+        for (size_t m = mBegin; m < mEnd; ++m) {
+            output[blockStart + m - center] += static_cast<float>(signal[m]);
+        }
+    }
+}
+
+} // namespace histogram
@@ -0,0 +1,109 @@
+#ifndef FFT_CONVOLVER_HPP
+#define FFT_CONVOLVER_HPP
+
+#include <complex>
+#include <memory>
+#include <vector>
+
+namespace histogram {
+
+/**
+ * @brief 基于FFT的一维卷积（不依赖外部库）
+ *
+ * 使用实数到复数的基2变换和重叠相加（overlap-add）处理任意长度的输入。
+ * 同一长度的FFT计划（位反转表和旋转因子）在进程内缓存并共享，
+ * 卷积核的频谱在构造时计算一次。
+ */
+class FFTConvolver {
+public:
+    /**
+     * @brief 构造函数
+     * @param kernel 卷积核，中心位于kernel.size() / 2
+     * @param blockSize 每块输入长度（0表示根据核长度自动选择）
+     */
+    explicit FFTConvolver(const std::vector<float>& kernel, size_t blockSize = 0);
+
+    /**
+     * @brief 计算与输入等长的居中卷积（数组外视为0）
+     * @param input 输入数据
+     * @param output 输出缓冲区，长度不小于size，且不能与input重叠
+     * @param size 数据长度
+     */
+    void convolve(const float* input, float* output, size_t size) const;
+
+    /**
+     * @brief 计算与输入等长的居中卷积（数组外视为0）
+     * @param input 输入计数
+     * @param output 输出缓冲区，长度不小于size
+     * @param size 数据长度
+     */
+    void convolve(const size_t* input, float* output, size_t size) const;
+
+    /**
+     * @brief 只计算[begin, end)范围内的输出，结果与完整卷积中对应位置逐位相同
+     * @param input 完整输入数据
+     * @param output 完整输出缓冲区，只写入[begin, end)
+     * @param size 数据长度
+     * @param begin 输出起始索引
+     * @param end 输出结束索引
+     *
+     * 只处理与该范围有关的块，并按与完整卷积相同的块顺序累加，可用于分块并行。
+     */
+    void convolve(const float* input, float* output, size_t size, size_t begin, size_t end) const;
+
+    /**
+     * @brief 只计算[begin, end)范围内的输出（计数输入）
+     */
+    void convolve(const size_t* input, float* output, size_t size, size_t begin, size_t end) const;
+
+    /**
+     * @brief 获取FFT长度
+     * @return FFT长度（2的幂）
+     */
+    size_t getFFTSize() const { return fftSize_; }
+
+    /**
+     * @brief 获取每块输入长度
+     * @return 块长度
+     */
+    size_t getBlockSize() const { return blockSize_; }
+
+    /**
+     * @brief 估计处理每个输出样本的相对代价（用于在不同滤波方法间选择）
+     * @param kernelSize 核长度
+     * @param size 数据长度
+     * @return 每个样本的蝶形运算数
+     */
+    static double estimateCostPerSample(size_t kernelSize, size_t size);
+
+    /**
+     * @brief 选择FFT长度
+     * @param kernelSize 核长度
+     * @param size 数据长度
+     * @return FFT长度（2的幂）
+     */
+    static size_t chooseFFTSize(size_t kernelSize, size_t size);
+
+private:
+    struct Plan;
+
+    /**
+     * @brief 获取（必要时创建）指定长度的FFT计划
+     * @param size FFT长度（2的幂）
+     * @return 共享的FFT计划
+     */
+    static std::shared_ptr<const Plan> getPlan(size_t size);
+
+    template <typename T>
+    void convolveImpl(const T* input, float* output, size_t size, size_t begin, size_t end) const;
+
+    size_t kernelSize_;                                  // 核长度
+    size_t fftSize_;                                     // FFT长度
+    size_t blockSize_;                                   // 每块输入长度
+    std::shared_ptr<const Plan> plan_;                   // FFT计划
+    std::vector<std::complex<double>> kernelSpectrum_;   // 核频谱（fftSize_/2 + 1个复数）
+};
+
+} // namespace histogram
+
+#endif // FFT_CONVOLVER_HPP
@@ -1,24 +1,102 @@
 #ifndef GAUSSIAN_FILTER_HPP
 #define GAUSSIAN_FILTER_HPP
 
+#include <array>
+#include <memory>
 #include <vector>
 #include <cmath>
 
 namespace histogram {
 
+class FFTConvolver;
+
 class GaussianFilter {
 public:
+    /**
+     * @brief 滤波方法
+     */
+    enum class Method {
+        Direct,    // 直接卷积，代价O(n·sigma)
+        Recursive, // Young–van Vliet递归近似，代价O(n)，与sigma无关
+        FFT,       // FFT重叠相加卷积，代价O(n·log(sigma))，结果与直接卷积一致
+        Auto       // 按代价模型在以上三种方法中自动选择
+    };
+
     /**
      * @brief 构造函数
      * @param sigma 高斯核的标准差
+     * @param method 滤波方法
      */
-    GaussianFilter(float sigma = 1.0f);
+    GaussianFilter(float sigma = 1.0f, Method method = Method::Direct);
     
     /**
      * @brief 设置高斯核的标准差
      * @param sigma 标准差
      */
     void setSigma(float sigma);
+
+    /**
+     * @brief 获取高斯核的标准差
+     * @return 标准差
+     */
+    float getSigma() const { return sigma_; }
+
+    /**
+     * @brief 获取预计算的归一化高斯核
+     * @return 高斯核（长度为2 * radius + 1）
+     */
+    const std::vector<float>& getKernel() const { return kernel_; }
+
+    /**
+     * @brief 设置滤波方法
+     * @param method 滤波方法
+     *
+     * Recursive方法需要sigma >= 0.5，更小的sigma自动使用直接卷积；
+     * 中间结果保存在按线程复用的缓冲区中。递归滤波的系数和边界归一化表（O(sigma)）
+     * 只在Recursive或Auto可能选中递归滤波时计算，Direct和FFT不付出这部分代价。
+     */
+    void setMethod(Method method);
+
+    /**
+     * @brief 获取滤波方法
+     * @return 滤波方法
+     */
+    Method getMethod() const { return method_; }
+
+    /**
+     * @brief 获取对指定长度的数据实际使用的滤波方法（Auto按代价模型解析）
+     * @param size 数据长度
+     * @return 实际使用的滤波方法（不会返回Auto）
+     */
+    Method selectMethod(size_t size) const;
+
+    /**
+     * @brief 设置单条数据滤波（filter/filterCounts）使用的线程数
+     * @param threads 线程数（0表示使用硬件并发数，默认为1）
+     *
+     * 多线程时把输出划分为连续块，每个线程读取块两侧各radius个样本的输入（halo），
+     * 结果与单线程逐位相同。直接卷积和FFT按块并行；递归滤波存在跨样本的依赖，始终单线程执行，
+     * 因此Auto在多线程时按并行后的代价比较各方法。
+     */
+    void setThreads(unsigned threads) { threads_ = threads; }
+
+    /**
+     * @brief 获取线程数设置
+     * @return 线程数（0表示使用硬件并发数）
+     */
+    unsigned getThreads() const { return threads_; }
+
+    /**
+     * @brief 设置多线程滤波时每块的输出样本数
+     * @param chunkSize 块大小（0表示按数据长度和线程数自动选择）
+     */
+    void setChunkSize(size_t chunkSize) { chunkSize_ = chunkSize; }
+
+    /**
+     * @brief 获取块大小设置
+     * @return 块大小（0表示自动选择）
+     */
+    size_t getChunkSize() const { return chunkSize_; }
     
     /**
      * @brief 对一维数据进行高斯滤波
@@ -34,6 +112,78 @@ public:
      */
     std::vector<float> filterCounts(const std::vector<size_t>& counts) const;
 
+    /**
+     * @brief 对一维数据进行高斯滤波，结果写入调用方提供的缓冲区（直接卷积时不分配内存）
+     * @param input 输入数据
+     * @param output 输出缓冲区，长度不小于size，且不能与input重叠
+     * @param size 数据长度
+     */
+    void filter(const float* input, float* output, size_t size) const;
+
+    /**
+     * @brief 对直方图计数进行高斯滤波，结果写入调用方提供的缓冲区（直接卷积时不分配内存）
+     * @param counts 直方图计数
+     * @param output 输出缓冲区，长度不小于size
+     * @param size 数据长度
+     */
+    void filterCounts(const size_t* counts, float* output, size_t size) const;
+
+    /**
+     * @brief 对按行连续存放的多条数据（每行一个直方图）使用同一个核批量滤波
+     * @param input 输入矩阵，rows行cols列，行主序
+     * @param output 输出矩阵，rows行cols列，不能与input重叠
+     * @param rows 行数
+     * @param cols 每行长度
+     * @param threads 线程数（0表示使用硬件并发数）
+     *
+     * 每行的结果与对该行调用filter相同。直接卷积且行长不超过核长度的4倍时，
+     * 把每16行转置为交错布局、跨行向量化；其余情况按行并行。
+     */
+    void filterRows(const float* input, float* output, size_t rows, size_t cols,
+                    unsigned threads = 0) const;
+
+    /**
+     * @brief 对按行连续存放的多个直方图计数批量滤波
+     * @param counts 计数矩阵，rows行cols列，行主序
+     * @param output 输出矩阵，rows行cols列
+     * @param rows 行数
+     * @param cols 每行长度
+     * @param threads 线程数（0表示使用硬件并发数）
+     */
+    void filterCountsRows(const size_t* counts, float* output, size_t rows, size_t cols,
+                          unsigned threads = 0) const;
+
+    /**
+     * @brief 用三次滑动求和盒式滤波近似高斯，对整数计数做平滑（循环中没有浮点运算）
+     * @param counts 直方图计数
+     * @return 平滑后的计数（四舍五入到整数）
+     */
+    std::vector<size_t> filterCountsBox(const std::vector<size_t>& counts) const;
+
+    /**
+     * @brief 用三次滑动求和盒式滤波近似高斯，结果写入调用方提供的缓冲区
+     * @param counts 直方图计数，每个计数乘以盒宽之积后不能超过size_t范围
+     * @param output 输出缓冲区，长度不小于size，可以与counts相同
+     * @param size 数据长度
+     *
+     * 代价O(n)且与sigma无关，边界处与直接卷积一样按落在数组内的权重重新归一化，
+     * 常数输入的结果保持不变。适用于SVG显示和波峰检测前的预处理等对精度要求不高的场合。
+     */
+    void filterCountsBox(const size_t* counts, size_t* output, size_t size) const;
+
+    /**
+     * @brief 获取盒式滤波三次使用的宽度
+     * @return 三个奇数宽度
+     */
+    const std::array<size_t, 3>& getBoxWidths() const { return boxWidths_; }
+
+    /**
+     * @brief 按sigma选择三次盒式滤波的宽度，使总方差最接近sigma²
+     * @param sigma 标准差
+     * @return 三个奇数宽度（非递减）
+     */
+    static std::array<size_t, 3> computeBoxWidths(float sigma);
+
 private:
     /**
      * @brief 生成高斯核
@@ -41,8 +191,114 @@ private:
      * @return 高斯核
      */
     std::vector<float> generateKernel(int kernelSize) const;
+
+    /**
+     * @brief 使用缓存的高斯核做卷积，边界处按有效权重重新归一化
+     * @param input 输入数据
+     * @param output 输出缓冲区
+     * @param size 数据长度
+     */
+    template <typename T>
+    void convolve(const T* input, float* output, size_t size) const;
+
+    /**
+     * @brief 只计算[begin, end)范围内的输出（边界与内部分别处理）
+     * @param input 完整输入数据
+     * @param output 完整输出缓冲区
+     * @param size 数据长度
+     * @param begin 输出起始索引
+     * @param end 输出结束索引
+     */
+    template <typename T>
+    void convolveRange(const T* input, float* output, size_t size, size_t begin, size_t end) const;
+
+    /**
+     * @brief 递归高斯滤波，边界处理与直接卷积一致（按有效权重重新归一化）
+     * @param input 输入数据
+     * @param output 输出缓冲区
+     * @param size 数据长度
+     */
+    template <typename T>
+    void recursiveFilter(const T* input, float* output, size_t size) const;
+
+    /**
+     * @brief FFT卷积，边界部分与直接卷积相同地重新归一化
+     * @param input 输入数据
+     * @param output 输出缓冲区
+     * @param size 数据长度
+     */
+    template <typename T>
+    void fftFilter(const T* input, float* output, size_t size) const;
+
+    /**
+     * @brief 使用已构造的FFT卷积器滤波（批量滤波时在各行之间共享）
+     */
+    template <typename T>
+    void fftFilter(const T* input, float* output, size_t size, const FFTConvolver& convolver) const;
+
+    /**
+     * @brief 获取给定数据长度所需的FFT卷积器，按FFT长度缓存，长度相同时复用核频谱
+     * @param size 数据长度
+     * @return 共享的卷积器（只读，可被多个线程同时使用）
+     */
+    std::shared_ptr<const FFTConvolver> getFFTConvolver(size_t size) const;
+
+    /**
+     * @brief 批量滤波的实现
+     */
+    template <typename T>
+    void filterRowsImpl(const T* input, float* output, size_t rows, size_t cols, unsigned threads) const;
+
+    /**
+     * @brief 按块并行计算直接卷积或FFT卷积
+     * @param input 输入数据
+     * @param output 输出缓冲区
+     * @param size 数据长度
+     * @param method 已选定的方法（Direct或FFT）
+     * @param threads 实际线程数
+     */
+    template <typename T>
+    void filterChunked(const T* input, float* output, size_t size, Method method, unsigned threads) const;
+
+    /**
+     * @brief 按选定方法分派
+     * @param input 输入数据
+     * @param output 输出缓冲区
+     * @param size 数据长度
+     */
+    template <typename T>
+    void dispatch(const T* input, float* output, size_t size) const;
     
+    /**
+     * @brief 计算递归高斯滤波系数
+     * @param sigma 标准差
+     * @return 系数 {B, a1, a2, a3}，y[n] = B·x[n] + a1·y[n-1] + a2·y[n-2] + a3·y[n-3]
+     */
+    static std::array<double, 4> computeRecursiveCoefficients(float sigma);
+
+    /**
+     * @brief 计算递归滤波脉冲响应的单侧尾部质量，用于边界归一化
+     * @param coefficients 递归滤波系数
+     * @param sigma 标准差
+     * @return tail[d]为距中心超过d的单侧响应质量
+     */
+    static std::vector<double> computeRecursiveTail(const std::array<double, 4>& coefficients,
+                                                    float sigma);
+
+    /**
+     * @brief 当前方法可能选中递归滤波且尚未计算时，计算递归系数和边界归一化表
+     */
+    void prepareRecursive();
+
     float sigma_; // 高斯核标准差
+    std::vector<float> kernel_; // 预计算的高斯核
+    mutable std::shared_ptr<const FFTConvolver> fftConvolver_; // 最近使用的FFT卷积器（按FFT长度复用，setSigma时清除）
+    std::array<double, 4> recursive_; // 递归滤波系数（仅在可能选中递归滤波时计算）
+    std::vector<double> recursiveTail_; // 递归滤波边界归一化表（为空表示尚未计算）
+    std::array<size_t, 3> boxWidths_; // 盒式滤波宽度
+    Method method_; // 滤波方法
+    unsigned threads_; // 单条数据滤波的线程数
+    size_t chunkSize_; // 并行滤波的块大小
 };
 
 } // namespace histogram
@@ -0,0 +1,296 @@
+#include "GaussianMixture.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace histogram {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// 归约时的独立累加器个数（一个AVX-512向量的double个数），使求和循环可以向量化且结果与平台无关
+constexpr size_t kLanes = 8;
+
+/**
+ * @brief x ≤ 0 时的exp，只用算术和位运算，便于编译器向量化（相对误差约1e-15）
+ */
+inline double expNonPositive(double x) {
+    constexpr double kLog2e = 1.4426950408889634;
+    constexpr double kLn2High = 0.6931471803691238;
+    constexpr double kLn2Low = 1.9082149292705877e-10;
+    constexpr double kShift = 6755399441055744.0; // 1.5·2^52，加上后低位即为四舍五入的整数
+    x = x < -700.0 ? -700.0 : x;
+
+    // x = n·ln2 + r，|r| ≤ ln2/2
+    double shifted = x * kLog2e + kShift;
+    double n = shifted - kShift;
+    double r = (x - n * kLn2High) - n * kLn2Low;
+
+    // exp(r)的11阶泰勒展开
+    double p = 1.0 / 39916800.0;
+    p = p * r + 1.0 / 3628800.0;
+    p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;
+    p = p * r + 1.0 / 5040.0;
+    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;
+    p = p * r + 1.0 / 24.0;
+    p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+
+    // 2^n：由shifted的位模式得到整数n，再拼出指数位
+    int64_t shiftedBits;
+    int64_t shiftBits;
+    std::memcpy(&shiftedBits, &shifted, sizeof(shiftedBits));
+    std::memcpy(&shiftBits, &kShift, sizeof(shiftBits));
+    int64_t scaleBits = (shiftedBits - shiftBits + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &scaleBits, sizeof(scale));
+    return p * scale;
+}
+
+/**
+ * @brief 非零bin的中心和计数
+ */
+struct Bins {
+    std::vector<double> x; // bin中心
+    std::vector<double> w; // 计数
+    double total = 0.0;    // 总计数
+};
+
+Bins collectBins(const Histogram& hist) {
+    Bins bins;
+    const auto& counts = hist.getBinCounts();
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (counts[i] > 0) {
+            bins.x.push_back(hist.getMin() + (static_cast<double>(i) + 0.5) * hist.getBinWidth());
+            bins.w.push_back(static_cast<double>(counts[i]));
+            bins.total += static_cast<double>(counts[i]);
+        }
+    }
+    return bins;
+}
+
+/**
+ * @brief 由波峰bin初始化分量：均值为bin中心，标准差由半高宽估计，权重正比于峰高
+ */
+std::vector<GaussianMixture::Component> initialComponents(const Histogram& hist, const Bins& bins,
+                                                          const std::vector<size_t>& peaks) {
+    const auto& counts = hist.getBinCounts();
+    const double binWidth = hist.getBinWidth();
+    std::vector<GaussianMixture::Component> components;
+
+    if (peaks.empty()) {
+        // 单个分量：整体均值和方差
+        double mean = 0.0;
+        for (size_t i = 0; i < bins.x.size(); ++i) {
+            mean += bins.w[i] * bins.x[i];
+        }
+        mean /= bins.total;
+        double variance = 0.0;
+        for (size_t i = 0; i < bins.x.size(); ++i) {
+            variance += bins.w[i] * (bins.x[i] - mean) * (bins.x[i] - mean);
+        }
+        components.push_back({1.0, mean, std::max(variance / bins.total, binWidth * binWidth)});
+        return components;
+    }
+
+    double heightSum = 0.0;
+    for (size_t peak : peaks) {
+        if (peak >= counts.size()) {
+            throw std::out_of_range("Peak index out of range");
+        }
+        const size_t half = counts[peak] / 2;
+        size_t lo = peak;
+        while (lo > 0 && counts[lo - 1] > half) {
+            --lo;
+        }
+        size_t hi = peak;
+        while (hi + 1 < counts.size() && counts[hi + 1] > half) {
+            ++hi;
+        }
+        // 半高全宽 = 2.355·sigma
+        double sigma = std::max(static_cast<double>(hi - lo + 1) * binWidth / 2.35482, binWidth);
+        double mean = hist.getMin() + (static_cast<double>(peak) + 0.5) * binWidth;
+        components.push_back({static_cast<double>(counts[peak]), mean, sigma * sigma});
+        heightSum += static_cast<double>(counts[peak]);
+    }
+    for (auto& component : components) {
+        component.weight = heightSum > 0.0 ? component.weight / heightSum : 1.0 / components.size();
+    }
+    return components;
+}
+
+} // namespace
+
+GaussianMixture::GaussianMixture(size_t maxIterations, double tolerance)
+    : maxIterations_(maxIterations), tolerance_(tolerance), minProminence_(0.1f) {
+    if (maxIterations == 0) {
+        throw std::invalid_argument("maxIterations must be greater than 0");
+    }
+    if (!(tolerance >= 0.0)) {
+        throw std::invalid_argument("tolerance must not be negative");
+    }
+}
+
+void GaussianMixture::setMaxIterations(size_t maxIterations) {
+    if (maxIterations == 0) {
+        throw std::invalid_argument("maxIterations must be greater than 0");
+    }
+    maxIterations_ = maxIterations;
+}
+
+void GaussianMixture::setTolerance(double tolerance) {
+    if (!(tolerance >= 0.0)) {
+        throw std::invalid_argument("tolerance must not be negative");
+    }
+    tolerance_ = tolerance;
+}
+
+GaussianMixture::Result GaussianMixture::fit(const Histogram& hist) const {
+    return fit(hist, hist.findPeaks(minProminence_));
+}
+
+std::vector<GaussianMixture::Result> GaussianMixture::fitAll(const std::vector<Histogram>& hists,
+                                                             unsigned threads) const {
+    std::vector<Result> results(hists.size());
+    detail::parallelFor(hists.size(), 1, threads, [&](size_t begin, size_t end) {
+        for (size_t h = begin; h < end; ++h) {
+            results[h] = fit(hists[h]);
+        }
+    });
+    return results;
+}
+
+GaussianMixture::Result GaussianMixture::fit(const Histogram& hist, const std::vector<size_t>& peaks) const {
+    Result result;
+    result.iterations = 0;
+    result.converged = false;
+    result.logLikelihood = 0.0;
+    result.improvement = 0.0;
+
+    const Bins bins = collectBins(hist);
+    if (bins.x.empty()) {
+        return result; // 空直方图没有分量
+    }
+    std::vector<Component> components = initialComponents(hist, bins, peaks);
+
+    const size_t m = bins.x.size();
+    const size_t k = components.size();
+    const double binWidth = hist.getBinWidth();
+    // 方差下限，防止某个分量收缩到单个bin上
+    const double minVariance = binWidth * binWidth / 4.0;
+    const double logBinWidth = std::log(binWidth);
+
+    // e[c·m + i]为第c个分量在第i个bin上的对数密度，随后原地变为未归一化的责任值
+    std::vector<double> e(k * m);
+    std::vector<double> peak(m);
+    std::vector<double> scale(m);
+    const double* x = bins.x.data();
+    const double* w = bins.w.data();
+    double previous = -std::numeric_limits<double>::infinity();
+
+    for (size_t iteration = 0; iteration < maxIterations_; ++iteration) {
+        // E步：log(π·N(x; μ, σ²)·h) = a - (x - μ)²/(2σ²)
+        std::fill(peak.begin(), peak.end(), -std::numeric_limits<double>::infinity());
+        for (size_t c = 0; c < k; ++c) {
+            const Component& component = components[c];
+            const double a = std::log(std::max(component.weight, 1e-300))
+                           - 0.5 * std::log(2.0 * kPi * component.variance) + logBinWidth;
+            const double b = -0.5 / component.variance;
+            const double mean = component.mean;
+            double* row = e.data() + c * m;
+            for (size_t i = 0; i < m; ++i) {
+                const double d = x[i] - mean;
+                row[i] = a + b * d * d;
+                peak[i] = std::max(peak[i], row[i]);
+            }
+        }
+        std::fill(scale.begin(), scale.end(), 0.0);
+        for (size_t c = 0; c < k; ++c) {
+            double* row = e.data() + c * m;
+            for (size_t i = 0; i < m; ++i) {
+                row[i] = expNonPositive(row[i] - peak[i]);
+                scale[i] += row[i];
+            }
+        }
+
+        // 对数似然 Σ w·log Σ_c p_c；scale变为 w / Σ_c p_c，使 row[i]·scale[i] 为加权责任值
+        double logLikelihood = 0.0;
+        for (size_t i = 0; i < m; ++i) {
+            logLikelihood += w[i] * (peak[i] + std::log(scale[i]));
+            scale[i] = w[i] / scale[i];
+        }
+
+        // M步：以旧均值为中心累加一阶、二阶矩，数值上更稳定
+        for (size_t c = 0; c < k; ++c) {
+            Component& component = components[c];
+            const double* row = e.data() + c * m;
+            const double center = component.mean;
+            double n[kLanes] = {};
+            double s[kLanes] = {};
+            double q[kLanes] = {};
+            size_t i = 0;
+            for (; i + kLanes <= m; i += kLanes) {
+                for (size_t lane = 0; lane < kLanes; ++lane) {
+                    const double r = row[i + lane] * scale[i + lane];
+                    const double d = x[i + lane] - center;
+                    n[lane] += r;
+                    s[lane] += r * d;
+                    q[lane] += r * d * d;
+                }
+            }
+            for (size_t lane = 0; i < m; ++i, ++lane) {
+                const double r = row[i] * scale[i];
+                const double d = x[i] - center;
+                n[lane] += r;
+                s[lane] += r * d;
+                q[lane] += r * d * d;
+            }
+            double mass = 0.0, first = 0.0, second = 0.0;
+            for (size_t lane = 0; lane < kLanes; ++lane) {
+                mass += n[lane];
+                first += s[lane];
+                second += q[lane];
+            }
+
+            if (mass <= 0.0) {
+                component.weight = 0.0; // 分量失去所有数据，保留位置
+                continue;
+            }
+            const double shift = first / mass;
+            component.weight = mass / bins.total;
+            component.mean = center + shift;
+            component.variance = std::max(second / mass - shift * shift, minVariance);
+        }
+
+        result.history.push_back(logLikelihood);
+        result.iterations = iteration + 1;
+        result.logLikelihood = logLikelihood;
+        result.improvement = logLikelihood - previous;
+        if (std::abs(result.improvement) <= tolerance_ * std::abs(logLikelihood)) {
+            result.converged = true;
+            break;
+        }
+        previous = logLikelihood;
+    }
+
+    // Sheppard修正：分箱使方差增加约binWidth²/12
+    const double sheppard = binWidth * binWidth / 12.0;
+    for (auto& component : components) {
+        component.variance = std::max(component.variance - sheppard, sheppard);
+    }
+    std::sort(components.begin(), components.end(),
+              [](const Component& a, const Component& b) { return a.mean < b.mean; });
+    result.components = std::move(components);
+    return result;
+}
+
+} // namespace histogram
@@ -0,0 +1,115 @@
+#ifndef GAUSSIAN_MIXTURE_HPP
+#define GAUSSIAN_MIXTURE_HPP
+
+#include "Histogram.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace histogram {
+
+/**
+ * @brief 直接在直方图bin上做EM的一维高斯混合拟合
+ *
+ * 每个非零bin视为位于bin中心、权重为计数的一组样本，每次迭代的代价为O(非零bin数 × 分量数)，
+ * 与原始样本数无关。分量由findPeaks的结果初始化（均值取波峰bin中心，标准差由半高宽估计）。
+ * E步按分量遍历连续存放的bin，指数和累加都写成无分支的逐元素循环，可被编译器向量化。
+ * 输出的方差做了Sheppard修正（减去binWidth²/12），以抵消分箱带来的方差膨胀。
+ */
+class GaussianMixture {
+public:
+    /**
+     * @brief 混合分量
+     */
+    struct Component {
+        double weight;   // 混合权重（各分量之和为1）
+        double mean;     // 均值（数据值）
+        double variance; // 方差（数据值单位的平方）
+    };
+
+    /**
+     * @brief 拟合结果及收敛统计
+     */
+    struct Result {
+        std::vector<Component> components;  // 按均值升序的分量
+        size_t iterations;                  // 实际迭代次数
+        bool converged;                     // 对数似然的相对变化是否已小于容差
+        double logLikelihood;               // 最终对数似然（以bin为单位的离散概率）
+        double improvement;                 // 最后一次迭代的对数似然增量
+        std::vector<double> history;        // 每次迭代后的对数似然
+    };
+
+    /**
+     * @brief 构造函数
+     * @param maxIterations 最大迭代次数
+     * @param tolerance 对数似然相对变化的收敛容差
+     */
+    explicit GaussianMixture(size_t maxIterations = 200, double tolerance = 1e-8);
+
+    /**
+     * @brief 设置最大迭代次数
+     * @param maxIterations 最大迭代次数
+     */
+    void setMaxIterations(size_t maxIterations);
+
+    /**
+     * @brief 设置收敛容差
+     * @param tolerance 对数似然相对变化的收敛容差
+     */
+    void setTolerance(double tolerance);
+
+    /**
+     * @brief 设置由findPeaks选择初始分量时使用的最小突出度
+     * @param minProminence 最小突出度阈值（相对于最大bin的百分比，0-1）
+     */
+    void setMinProminence(float minProminence) { minProminence_ = minProminence; }
+
+    /**
+     * @brief 获取最大迭代次数
+     * @return 最大迭代次数
+     */
+    size_t getMaxIterations() const { return maxIterations_; }
+
+    /**
+     * @brief 获取收敛容差
+     * @return 收敛容差
+     */
+    double getTolerance() const { return tolerance_; }
+
+    /**
+     * @brief 获取初始化使用的最小突出度
+     * @return 最小突出度
+     */
+    float getMinProminence() const { return minProminence_; }
+
+    /**
+     * @brief 以findPeaks检测到的波峰为初始分量拟合（没有波峰时使用单个分量）
+     * @param hist 直方图
+     * @return 拟合结果
+     */
+    Result fit(const Histogram& hist) const;
+
+    /**
+     * @brief 以给定的波峰bin为初始分量拟合
+     * @param hist 直方图
+     * @param peaks 初始分量所在的bin（为空时使用单个分量）
+     * @return 拟合结果
+     */
+    Result fit(const Histogram& hist, const std::vector<size_t>& peaks) const;
+
+    /**
+     * @brief 并行拟合多个直方图，每个直方图由各自的findPeaks结果初始化
+     * @param hists 直方图列表
+     * @param threads 线程数（0表示使用硬件并发数）
+     * @return 与输入顺序一致的拟合结果
+     */
+    std::vector<Result> fitAll(const std::vector<Histogram>& hists, unsigned threads = 0) const;
+
+private:
+    size_t maxIterations_; // 最大迭代次数
+    double tolerance_;     // 收敛容差
+    float minProminence_;  // 初始化时findPeaks的最小突出度
+};
+
+} // namespace histogram
+
+#endif // GAUSSIAN_MIXTURE_HPP
@@ -1,10 +1,192 @@
 #include "Histogram.hpp"
+#include "ByteIO.hpp"
+#include "Parallel.hpp"
 #include <cmath>
 #include <algorithm>
+#include <limits>
 #include <stdexcept>
+#include <mutex>
 
 namespace histogram {
 
+namespace {
+
+// 多线程批量添加时每个线程的最小数据量，小于该规模时私有计数数组的开销大于收益
+constexpr size_t kMinShardedBatch = size_t(1) << 18;
+
+constexpr char kMagic[4] = {'H', 'S', 'T', 'B'};
+constexpr uint8_t kFormatVersion = 1;
+constexpr uint8_t kDeltaFlag = 0x01;
+
+// 序列化格式支持的最大bin数（稠密计数数组2 GiB）；反序列化前据此拒绝伪造的bin数，避免按头部直接分配
+constexpr uint64_t kMaxSerializedResolution = uint64_t(1) << 28;
+
+/**
+ * @brief 序列化数据的头部
+ */
+struct SerializedHeader {
+    float min;
+    float max;
+    uint64_t resolution;
+    uint64_t totalCount;
+    bool delta;
+};
+
+SerializedHeader readHeader(detail::ByteReader& reader) {
+    if (!std::equal(kMagic, kMagic + sizeof(kMagic), reader.readBytes(sizeof(kMagic)))) {
+        throw std::runtime_error("Invalid Histogram data");
+    }
+    if (reader.readLittleEndian<uint8_t>() != kFormatVersion) {
+        throw std::runtime_error("Unsupported Histogram data version");
+    }
+    const uint8_t flags = reader.readLittleEndian<uint8_t>();
+    if (flags & ~kDeltaFlag) {
+        throw std::runtime_error("Invalid Histogram data");
+    }
+    SerializedHeader header;
+    header.delta = (flags & kDeltaFlag) != 0;
+    header.min = reader.readLittleEndian<float>();
+    header.max = reader.readLittleEndian<float>();
+    header.resolution = reader.readVarint();
+    header.totalCount = reader.readVarint();
+    if (!(header.min < header.max) || header.resolution == 0 || header.resolution > kMaxSerializedResolution) {
+        throw std::runtime_error("Invalid Histogram data");
+    }
+    return header;
+}
+
+/**
+ * @brief 逐个解码非零bin，visit(index, count)；游程越界、计数为0或有多余字节时抛出std::runtime_error
+ */
+template <typename Visit>
+void decodeBins(detail::ByteReader& reader, const SerializedHeader& header, Visit visit) {
+    uint64_t index = 0;
+    uint64_t previous = 0;
+    while (index < header.resolution) {
+        const uint64_t zeros = reader.readVarint();
+        const uint64_t nonzeros = reader.readVarint();
+        if (zeros > header.resolution - index || nonzeros > header.resolution - index - zeros) {
+            throw std::runtime_error("Invalid Histogram data");
+        }
+        index += zeros;
+        for (uint64_t k = 0; k < nonzeros; ++k, ++index) {
+            const uint64_t raw = reader.readVarint();
+            const uint64_t count = header.delta ? previous + static_cast<uint64_t>(detail::zigZagDecode(raw)) : raw;
+            if (count == 0) {
+                throw std::runtime_error("Invalid Histogram data");
+            }
+            visit(static_cast<size_t>(index), static_cast<size_t>(count));
+            previous = count;
+        }
+    }
+    if (reader.remaining() != 0) {
+        throw std::runtime_error("Invalid Histogram data");
+    }
+}
+
+/**
+ * @brief 完整校验一遍编码的bin（不修改reader），计数之和必须等于头部的总计数
+ * @return 计数之和
+ */
+uint64_t validateBins(detail::ByteReader reader, const SerializedHeader& header) {
+    uint64_t total = 0;
+    decodeBins(reader, header, [&total](size_t, size_t count) {
+        if (count > std::numeric_limits<uint64_t>::max() - total) {
+            throw std::runtime_error("Invalid Histogram data");
+        }
+        total += count;
+    });
+    if (total != header.totalCount) {
+        throw std::runtime_error("Invalid Histogram data");
+    }
+    return total;
+}
+
+/**
+ * @brief 计算所有波峰的持久度
+ * @param counts bin计数
+ * @param size bin数量
+ * @return (波峰索引, 持久度)，按持久度从大到小排序，持久度相同时按索引排序
+ */
+std::vector<std::pair<size_t, size_t>> computePersistence(const size_t* counts, size_t size) {
+    std::vector<std::pair<size_t, size_t>> peaks;
+    if (size == 0) {
+        return peaks;
+    }
+
+    // 按计数从高到低、索引从小到大排序；计数范围不大时用计数排序，整体为O(n·α(n))
+    std::vector<size_t> order(size);
+    const size_t maxCount = *std::max_element(counts, counts + size);
+    const size_t minCount = *std::min_element(counts, counts + size);
+    if (maxCount - minCount <= 4 * size) {
+        std::vector<size_t> offsets(maxCount - minCount + 2, 0);
+        for (size_t i = 0; i < size; ++i) {
+            ++offsets[maxCount - counts[i] + 1];
+        }
+        for (size_t k = 1; k < offsets.size(); ++k) {
+            offsets[k] += offsets[k - 1];
+        }
+        for (size_t i = 0; i < size; ++i) {
+            order[offsets[maxCount - counts[i]]++] = i;
+        }
+    } else {
+        for (size_t i = 0; i < size; ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [counts](size_t a, size_t b) {
+            return counts[a] != counts[b] ? counts[a] > counts[b] : a < b;
+        });
+    }
+
+    // 并查集：parent为kNone表示bin尚未加入；birth[root]为分量的峰值bin（先加入者）
+    constexpr size_t kNone = static_cast<size_t>(-1);
+    std::vector<size_t> parent(size, kNone);
+    std::vector<size_t> birth(size);
+    auto find = [&parent](size_t i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]]; // 路径减半
+            i = parent[i];
+        }
+        return i;
+    };
+
+    for (size_t i : order) {
+        parent[i] = i;
+        birth[i] = i;
+        for (size_t neighbor : {i - 1, i + 1}) {
+            if (neighbor >= size || parent[neighbor] == kNone) {
+                continue;
+            }
+            size_t a = find(i);
+            size_t b = find(neighbor);
+            if (a == b) {
+                continue;
+            }
+            // 先加入的峰值更高（或同高而更靠左），保留；另一个分量在当前高度消亡
+            size_t elder = counts[birth[a]] > counts[birth[b]]
+                        || (counts[birth[a]] == counts[birth[b]] && birth[a] < birth[b]) ? a : b;
+            size_t younger = (elder == a) ? b : a;
+            size_t persistence = counts[birth[younger]] - counts[i];
+            if (birth[younger] != i && persistence > 0) {
+                peaks.emplace_back(birth[younger], persistence);
+            }
+            parent[younger] = elder;
+        }
+    }
+
+    // 最高峰从不消亡，持久度取最大计数与最小计数之差
+    if (maxCount > minCount) {
+        peaks.emplace_back(birth[find(order.front())], maxCount - minCount);
+    }
+
+    std::sort(peaks.begin(), peaks.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    return peaks;
+}
+
+} // namespace
+
 Histogram::Histogram(float min, float max, size_t resolution)
     : min_(min), max_(max), resolution_(resolution), totalCount_(0) {
     
@@ -28,6 +210,14 @@ void Histogram::addData(float value) {
     // 忽略超出范围的值
 }
 
+void Histogram::addBinCount(size_t binIndex, size_t count) {
+    if (binIndex >= resolution_) {
+        throw std::out_of_range("binIndex out of range");
+    }
+    bins_[binIndex] += count;
+    totalCount_ += count;
+}
+
 size_t Histogram::getBinCount(size_t binIndex) const {
     if (binIndex >= resolution_) {
         throw std::out_of_range("binIndex out of range");
@@ -35,6 +225,44 @@ size_t Histogram::getBinCount(size_t binIndex) const {
     return bins_[binIndex];
 }
 
+void Histogram::addData(const float* values, size_t count, unsigned threads) {
+    const float minValue = min_;
+    const float maxValue = max_;
+    const float binWidth = binWidth_;
+    const size_t lastIndex = resolution_ - 1;
+    // 与getBinIndex相同的除法和截断，保证与逐个添加的结果一致
+    auto accumulate = [=](const float* data, size_t size, size_t* bins) {
+        size_t added = 0;
+        for (size_t i = 0; i < size; ++i) {
+            const float value = data[i];
+            if (!(value >= minValue && value <= maxValue)) {
+                continue;
+            }
+            const size_t index = value == maxValue ? lastIndex
+                : std::min(static_cast<size_t>((value - minValue) / binWidth), lastIndex);
+            ++bins[index];
+            ++added;
+        }
+        return added;
+    };
+
+    if (detail::resolveThreadCount(threads) <= 1 || count < kMinShardedBatch) {
+        totalCount_ += accumulate(values, count, bins_.data());
+        return;
+    }
+
+    std::mutex mutex;
+    detail::parallelFor(count, kMinShardedBatch, threads, [&](size_t begin, size_t end) {
+        std::vector<size_t> shard(resolution_, 0);
+        const size_t added = accumulate(values + begin, end - begin, shard.data());
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < resolution_; ++i) {
+            bins_[i] += shard[i];
+        }
+        totalCount_ += added;
+    });
+}
+
 std::pair<float, float> Histogram::getBinRange(size_t binIndex) const {
     if (binIndex >= resolution_) {
         throw std::out_of_range("binIndex out of range");
@@ -162,30 +390,35 @@ void Histogram::merge(const Histogram& other) {
 }
 
 std::vector<size_t> Histogram::findPeaks(float minProminence) const {
+    return findPeaks(bins_.data(), resolution_, totalCount_, minProminence);
+}
+
+std::vector<size_t> Histogram::findPeaks(const size_t* counts, size_t resolution, size_t totalCount,
+                                         float minProminence) {
     std::vector<size_t> peaks;
     
-    if (bins_.empty() || resolution_ < 3) {
+    if (resolution < 3) {
         return peaks; // 数据不足，无法检测波峰
     }
     
     // 计算最小突出度阈值
-    size_t maxCount = getMaxBinCount();
+    size_t maxCount = *std::max_element(counts, counts + resolution);
     size_t prominenceThreshold = static_cast<size_t>(maxCount * minProminence);
     
     // 计算平均计数，用于噪声过滤
-    double averageCount = static_cast<double>(totalCount_) / resolution_;
+    double averageCount = static_cast<double>(totalCount) / resolution;
     
     // 检测波峰：一个点比左右邻居都高
-    for (size_t i = 1; i < resolution_ - 1; ++i) {
-        if (bins_[i] > bins_[i-1] && bins_[i] > bins_[i+1]) {
+    for (size_t i = 1; i < resolution - 1; ++i) {
+        if (counts[i] > counts[i-1] && counts[i] > counts[i+1]) {
             // 检查突出度是否满足阈值
-            if (bins_[i] >= prominenceThreshold) {
+            if (counts[i] >= prominenceThreshold) {
                 // 额外的检查：确保这不是噪声
                 // 波峰应该显著高于周围的值（至少比两侧的平均值高10%）
-                double neighborAverage = (bins_[i-1] + bins_[i+1]) / 2.0;
-                if (bins_[i] > neighborAverage * 1.1) {
+                double neighborAverage = (counts[i-1] + counts[i+1]) / 2.0;
+                if (counts[i] > neighborAverage * 1.1) {
                     // 同时检查波峰计数应该高于整体平均值
-                    if (bins_[i] > averageCount * 1.5) {
+                    if (counts[i] > averageCount * 1.5) {
                         peaks.push_back(i);
                     }
                 }
@@ -209,4 +442,90 @@ std::vector<std::tuple<size_t, size_t, std::pair<float, float>>> Histogram::getP
     return peaksInfo;
 }
 
-} // namespace histogram
\ No newline at end of file
+std::vector<size_t> Histogram::findPersistentPeaks(float minPersistence) const {
+    std::vector<size_t> peaks;
+    for (const auto& info : getPersistentPeaksInfo(minPersistence)) {
+        peaks.push_back(std::get<0>(info));
+    }
+    return peaks;
+}
+
+std::vector<std::tuple<size_t, size_t, std::pair<float, float>, size_t>>
+Histogram::getPersistentPeaksInfo(float minPersistence) const {
+    std::vector<std::tuple<size_t, size_t, std::pair<float, float>, size_t>> peaksInfo;
+    const double threshold = getMaxBinCount() * static_cast<double>(minPersistence);
+    for (const auto& peak : computePersistence(bins_.data(), resolution_)) {
+        if (peak.second >= threshold) {
+            peaksInfo.emplace_back(peak.first, bins_[peak.first], getBinRange(peak.first), peak.second);
+        }
+    }
+    return peaksInfo;
+}
+
+void Histogram::serialize(std::string& output, bool delta) const {
+    if (resolution_ > kMaxSerializedResolution) {
+        throw std::runtime_error("Histogram resolution exceeds serialization format limit");
+    }
+    // 头部的总计数取各bin之和（merge重新分箱时totalCount_可能包含范围外的计数），与反序列化的校验一致
+    size_t binTotal = 0;
+    for (size_t count : bins_) {
+        binTotal += count;
+    }
+    output.append(kMagic, sizeof(kMagic));
+    detail::appendLittleEndian(output, kFormatVersion);
+    detail::appendLittleEndian(output, static_cast<uint8_t>(delta ? kDeltaFlag : 0));
+    detail::appendLittleEndian(output, min_);
+    detail::appendLittleEndian(output, max_);
+    detail::appendVarint(output, resolution_);
+    detail::appendVarint(output, binTotal);
+
+    size_t previous = 0;
+    size_t i = 0;
+    while (i < resolution_) {
+        const size_t zeroStart = i;
+        while (i < resolution_ && bins_[i] == 0) {
+            ++i;
+        }
+        const size_t runStart = i;
+        while (i < resolution_ && bins_[i] != 0) {
+            ++i;
+        }
+        detail::appendVarint(output, runStart - zeroStart);
+        detail::appendVarint(output, i - runStart);
+        for (size_t k = runStart; k < i; ++k) {
+            if (delta) {
+                detail::appendVarint(output, detail::zigZagEncode(
+                    static_cast<int64_t>(static_cast<uint64_t>(bins_[k]) - static_cast<uint64_t>(previous))));
+            } else {
+                detail::appendVarint(output, bins_[k]);
+            }
+            previous = bins_[k];
+        }
+    }
+}
+
+Histogram Histogram::deserialize(const char* data, size_t size) {
+    detail::ByteReader reader(data, size);
+    const SerializedHeader header = readHeader(reader);
+    // 先校验再按头部的bin数分配
+    const uint64_t total = validateBins(reader, header);
+    Histogram hist(header.min, header.max, static_cast<size_t>(header.resolution));
+    decodeBins(reader, header, [&hist](size_t index, size_t count) { hist.bins_[index] = count; });
+    hist.totalCount_ = static_cast<size_t>(total);
+    return hist;
+}
+
+void Histogram::mergeFromSerialized(const char* data, size_t size) {
+    detail::ByteReader reader(data, size);
+    const SerializedHeader header = readHeader(reader);
+    if (header.min != min_ || header.max != max_ || header.resolution != resolution_) {
+        throw std::invalid_argument("Serialized histogram has a different range or resolution");
+    }
+
+    // 先完整校验一遍，保证数据无效时不留下部分合并的结果
+    const uint64_t total = validateBins(reader, header);
+    decodeBins(reader, header, [this](size_t index, size_t count) { bins_[index] += count; });
+    totalCount_ += static_cast<size_t>(total);
+}
+
+} // namespace histogram
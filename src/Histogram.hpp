@@ -2,6 +2,8 @@
 #define HISTOGRAM_HPP
 
 #include <stdexcept>
+#include <string>
+#include <tuple>
 #include <vector>
 
 namespace histogram {
@@ -22,6 +24,24 @@ public:
      */
     void addData(float value);
 
+    /**
+     * @brief 批量添加数据点（超出范围的值和NaN被忽略）
+     * @param values 数据数组
+     * @param count 数据个数
+     * @param threads 线程数（0表示使用硬件并发数）
+     *
+     * bin的判定与addData(float)逐位一致。多线程时每个线程先累加到私有的计数数组
+     * （每线程额外占用resolution个计数的内存），结束后加锁合并。
+     */
+    void addData(const float* values, size_t count, unsigned threads = 1);
+
+    /**
+     * @brief 直接向指定bin累加计数
+     * @param binIndex bin索引
+     * @param count 累加的计数值
+     */
+    void addBinCount(size_t binIndex, size_t count);
+
     /**
      * @brief 获取指定bin的计数值
      * @param binIndex bin索引
@@ -109,6 +129,17 @@ public:
      */
     std::vector<size_t> findPeaks(float minProminence = 0.1f) const;
 
+    /**
+     * @brief 在计数数组上检测波峰，判据与findPeaks相同（供不持有bins的视图使用，如MappedHistogram）
+     * @param counts bin计数
+     * @param resolution bin数量
+     * @param totalCount 总数据点数（用于噪声过滤的平均计数）
+     * @param minProminence 最小突出度阈值（相对于最大bin的百分比，0-1）
+     * @return 波峰索引向量
+     */
+    static std::vector<size_t> findPeaks(const size_t* counts, size_t resolution, size_t totalCount,
+                                         float minProminence = 0.1f);
+
     /**
      * @brief 获取波峰的详细信息
      * @param minProminence 最小突出度阈值（相对于最大bin的百分比，0-1）
@@ -116,8 +147,60 @@ public:
      */
     std::vector<std::tuple<size_t, size_t, std::pair<float, float>>> getPeaksInfo(float minProminence = 0.1f) const;
 
+    /**
+     * @brief 按0维持久同调检测波峰，结果对噪声稳定
+     * @param minPersistence 最小持久度阈值（相对于最大bin的百分比，0-1）
+     * @return 波峰索引向量，按持久度从大到小排序
+     *
+     * 按计数从高到低依次加入bin，用并查集合并相邻的分量；两个分量相遇时较年轻（峰值较低）的
+     * 分量消亡，其持久度为峰值减去相遇处的计数。最高峰的持久度为最大计数减去最小计数。
+     * 与findPeaks不同，两端的bin也可以是波峰；平台的波峰位于平台最左侧的bin。
+     */
+    std::vector<size_t> findPersistentPeaks(float minPersistence = 0.1f) const;
+
+    /**
+     * @brief 获取按持久度排序的波峰详细信息
+     * @param minPersistence 最小持久度阈值（相对于最大bin的百分比，0-1）
+     * @return 波峰信息向量（索引，计数值，值范围，持久度），按持久度从大到小排序
+     */
+    std::vector<std::tuple<size_t, size_t, std::pair<float, float>, size_t>>
+    getPersistentPeaksInfo(float minPersistence = 0.1f) const;
+
     void merge(const Histogram& other);
 
+    /**
+     * @brief 序列化为紧凑的二进制格式（追加到output）
+     * @param output 输出字符串
+     * @param delta 是否对相邻非零bin的计数做差分编码（平滑的直方图更短）
+     *
+     * 格式：魔数"HSTB"、版本、标志、min、max（小端float）、bin数和总计数（LEB128），
+     * 之后为交替的（零bin游程长度，非零bin游程长度，各非零计数）记录，全部为LEB128变长整数；
+     * 差分模式下计数改为与前一个非零bin之差的zigzag编码。
+     * 总计数写各bin计数之和；格式最多支持2^28个bin，超过时抛出std::runtime_error。
+     */
+    void serialize(std::string& output, bool delta = false) const;
+
+    /**
+     * @brief 从二进制数据反序列化
+     * @param data 数据指针
+     * @param size 数据字节数
+     * @return 直方图对象
+     *
+     * 分配计数数组前先完整校验数据：bin数超过格式上限、游程越界、计数之和与头部总计数不符
+     * 或有多余字节时抛出std::runtime_error。
+     */
+    static Histogram deserialize(const char* data, size_t size);
+
+    /**
+     * @brief 把序列化的直方图直接累加到当前直方图，不构造中间的稠密直方图
+     * @param data 数据指针
+     * @param size 数据字节数
+     *
+     * 两者的范围和bin数必须相同，否则抛出std::invalid_argument；数据无效（校验规则同deserialize）时
+     * 抛出std::runtime_error，当前直方图保持不变。
+     */
+    void mergeFromSerialized(const char* data, size_t size);
+
 private:
     float min_; // 最小值
     float max_; // 最大值
@@ -0,0 +1,207 @@
+#include "HistogramTransform.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace histogram {
+
+namespace {
+
+// 每个并行块的最小元素数
+constexpr size_t kApplyChunkSize = size_t(1) << 16;
+
+/**
+ * @brief 在bin边界查找表上对一段浮点数据做分段线性插值
+ */
+void applyLookup(const float* lut, size_t resolution,
+                 float minValue, float binWidth,
+                 const float* input, float* output, size_t count) {
+    const size_t lastIndex = resolution - 1;
+    const float upper = static_cast<float>(resolution);
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    if (resolution < static_cast<size_t>(INT32_MAX)) {
+        const __m256 vMin = _mm256_set1_ps(minValue);
+        const __m256 vBinWidth = _mm256_set1_ps(binWidth);
+        const __m256 vUpper = _mm256_set1_ps(upper);
+        const __m256 vZero = _mm256_setzero_ps();
+        const __m256 vOne = _mm256_set1_ps(1.0f);
+        const __m256i vLast = _mm256_set1_epi32(static_cast<int>(lastIndex));
+        const __m256i vIntOne = _mm256_set1_epi32(1);
+
+        for (; i + 8 <= count; i += 8) {
+            __m256 t = _mm256_div_ps(_mm256_sub_ps(_mm256_loadu_ps(input + i), vMin), vBinWidth);
+            t = _mm256_min_ps(_mm256_max_ps(t, vZero), vUpper);
+            __m256i idx = _mm256_min_epi32(_mm256_cvttps_epi32(t), vLast);
+            __m256 lo = _mm256_i32gather_ps(lut, idx, 4);
+            __m256 hi = _mm256_i32gather_ps(lut, _mm256_add_epi32(idx, vIntOne), 4);
+            __m256 frac = _mm256_min_ps(_mm256_sub_ps(t, _mm256_cvtepi32_ps(idx)), vOne);
+            _mm256_storeu_ps(output + i, _mm256_add_ps(lo, _mm256_mul_ps(frac, _mm256_sub_ps(hi, lo))));
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        float t = (input[i] - minValue) / binWidth;
+        t = t > 0.0f ? t : 0.0f;
+        t = t < upper ? t : upper;
+        size_t idx = std::min(static_cast<size_t>(t), lastIndex);
+        float frac = std::min(t - static_cast<float>(idx), 1.0f);
+        output[i] = lut[idx] + frac * (lut[idx + 1] - lut[idx]);
+    }
+}
+
+/**
+ * @brief 整数查表
+ */
+template <typename T>
+void applyIntegerLookup(const std::vector<T>& table, const T* input, T* output,
+                        size_t count, unsigned threads) {
+    const T* lut = table.data();
+    detail::parallelFor(count, kApplyChunkSize, threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            output[i] = lut[input[i]];
+        }
+    });
+}
+
+/**
+ * @brief 将浮点值四舍五入并截断到整数类型范围
+ */
+template <typename T>
+T roundToInteger(float value) {
+    float maxValue = static_cast<float>(std::numeric_limits<T>::max());
+    float rounded = std::round(value);
+    rounded = rounded > 0.0f ? rounded : 0.0f;
+    rounded = rounded < maxValue ? rounded : maxValue;
+    return static_cast<T>(rounded);
+}
+
+} // namespace
+
+HistogramTransform::HistogramTransform(const CDF& source) {
+    std::vector<float> probabilities = edgeProbabilities(source);
+
+    // 均衡化：y = min + F(x) * (max - min)
+    lut_.resize(probabilities.size());
+    for (size_t k = 0; k < probabilities.size(); ++k) {
+        lut_[k] = min_ + probabilities[k] * (max_ - min_);
+    }
+
+    buildIntegerTables();
+}
+
+HistogramTransform::HistogramTransform(const CDF& source, const CDF& target) {
+    std::vector<float> probabilities = edgeProbabilities(source);
+
+    const auto& targetCDF = target.getCDFValues();
+    if (targetCDF.empty()) {
+        throw std::runtime_error("Target CDF not computed");
+    }
+
+    // 匹配：y = Q_target(F_source(x))，Q与CDF::getPercentile使用相同的bin内线性插值。
+    // 节点概率单调不减，因此只需单调地推进目标bin指针，并跳过空bin保证结果单调。
+    const size_t targetResolution = targetCDF.size();
+    const float targetMin = target.getMin();
+    const float targetMax = target.getMax();
+    const float targetBinWidth = target.getBinWidth();
+
+    lut_.resize(probabilities.size());
+    size_t bin = 0;
+    float prevCDF = 0.0f;
+    for (size_t k = 0; k < probabilities.size(); ++k) {
+        float p = probabilities[k];
+        while (bin < targetResolution &&
+               (targetCDF[bin] < p || targetCDF[bin] <= prevCDF)) {
+            prevCDF = std::max(prevCDF, targetCDF[bin]);
+            ++bin;
+        }
+
+        if (bin >= targetResolution) {
+            lut_[k] = targetMax;
+            continue;
+        }
+
+        float binMin = targetMin + bin * targetBinWidth;
+        float fraction = (p - prevCDF) / (targetCDF[bin] - prevCDF);
+        fraction = std::min(std::max(fraction, 0.0f), 1.0f);
+        lut_[k] = std::min(binMin + fraction * targetBinWidth, targetMax);
+    }
+
+    // 浮点误差可能产生极小的逆序，这里强制单调
+    for (size_t k = 1; k < lut_.size(); ++k) {
+        lut_[k] = std::max(lut_[k], lut_[k - 1]);
+    }
+
+    buildIntegerTables();
+}
+
+std::vector<float> HistogramTransform::edgeProbabilities(const CDF& source) {
+    const auto& cdf = source.getCDFValues();
+    if (cdf.empty()) {
+        throw std::runtime_error("Source CDF not computed");
+    }
+
+    min_ = source.getMin();
+    max_ = source.getMax();
+    binWidth_ = source.getBinWidth();
+    resolution_ = cdf.size();
+
+    // 节点k对应bin k的下边界，F(下边界) = cdf[k - 1]
+    std::vector<float> probabilities(resolution_ + 1);
+    probabilities[0] = 0.0f;
+    for (size_t k = 1; k <= resolution_; ++k) {
+        float p = std::min(std::max(cdf[k - 1], 0.0f), 1.0f);
+        probabilities[k] = std::max(p, probabilities[k - 1]);
+    }
+    probabilities[resolution_] = 1.0f;
+
+    return probabilities;
+}
+
+void HistogramTransform::buildIntegerTables() {
+    lut8_.resize(size_t(1) << 8);
+    for (size_t i = 0; i < lut8_.size(); ++i) {
+        lut8_[i] = roundToInteger<uint8_t>(map(static_cast<float>(i)));
+    }
+
+    lut16_.resize(size_t(1) << 16);
+    std::vector<float> values(lut16_.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = static_cast<float>(i);
+    }
+    applyLookup(lut_.data(), resolution_, min_, binWidth_, values.data(), values.data(), values.size());
+    for (size_t i = 0; i < lut16_.size(); ++i) {
+        lut16_[i] = roundToInteger<uint16_t>(values[i]);
+    }
+}
+
+float HistogramTransform::map(float value) const {
+    float result;
+    applyLookup(lut_.data(), resolution_, min_, binWidth_, &value, &result, 1);
+    return result;
+}
+
+void HistogramTransform::apply(const float* input, float* output, size_t count, unsigned threads) const {
+    detail::parallelFor(count, kApplyChunkSize, threads, [&](size_t begin, size_t end) {
+        applyLookup(lut_.data(), resolution_, min_, binWidth_,
+                    input + begin, output + begin, end - begin);
+    });
+}
+
+void HistogramTransform::apply(const uint8_t* input, uint8_t* output, size_t count, unsigned threads) const {
+    applyIntegerLookup(lut8_, input, output, count, threads);
+}
+
+void HistogramTransform::apply(const uint16_t* input, uint16_t* output, size_t count, unsigned threads) const {
+    applyIntegerLookup(lut16_, input, output, count, threads);
+}
+
+} // namespace histogram
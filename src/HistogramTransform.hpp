@@ -0,0 +1,96 @@
+#ifndef HISTOGRAM_TRANSFORM_HPP
+#define HISTOGRAM_TRANSFORM_HPP
+
+#include "CDF.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace histogram {
+
+/**
+ * @brief 直方图均衡化/直方图匹配变换
+ *
+ * 构造时在bin分辨率上预计算单调查找表（共resolution+1个节点，对应各bin边界），
+ * 浮点数据在节点间线性插值；8/16位整数数据使用按整数值精确计算的完整查找表，
+ * 应用阶段只是一次查表。
+ */
+class HistogramTransform {
+public:
+    /**
+     * @brief 构造直方图均衡化变换，将源分布映射为[min, max]上的均匀分布
+     * @param source 源数据的CDF
+     */
+    explicit HistogramTransform(const CDF& source);
+
+    /**
+     * @brief 构造直方图匹配变换，将源分布映射为目标分布
+     * @param source 源数据的CDF
+     * @param target 目标分布的CDF
+     */
+    HistogramTransform(const CDF& source, const CDF& target);
+
+    /**
+     * @brief 变换单个值
+     * @param value 输入值
+     * @return 变换后的值
+     */
+    float map(float value) const;
+
+    /**
+     * @brief 批量变换浮点数据（允许input与output相同以原地变换）
+     * @param input 输入数组
+     * @param output 输出数组
+     * @param count 数据个数
+     * @param threads 线程数（0表示使用硬件并发数）
+     */
+    void apply(const float* input, float* output, size_t count, unsigned threads = 0) const;
+
+    /**
+     * @brief 批量变换8位数据（查表，允许原地变换）
+     * @param input 输入数组
+     * @param output 输出数组
+     * @param count 数据个数
+     * @param threads 线程数（0表示使用硬件并发数）
+     */
+    void apply(const uint8_t* input, uint8_t* output, size_t count, unsigned threads = 0) const;
+
+    /**
+     * @brief 批量变换16位数据（查表，允许原地变换）
+     * @param input 输入数组
+     * @param output 输出数组
+     * @param count 数据个数
+     * @param threads 线程数（0表示使用硬件并发数）
+     */
+    void apply(const uint16_t* input, uint16_t* output, size_t count, unsigned threads = 0) const;
+
+    /**
+     * @brief 获取bin边界上的查找表
+     * @return 查找表（resolution+1个单调不减的节点值）
+     */
+    const std::vector<float>& getLookupTable() const { return lut_; }
+
+private:
+    /**
+     * @brief 从源CDF计算各bin边界上的累计概率（保证单调且位于[0, 1]）
+     * @param source 源CDF
+     * @return 累计概率节点
+     */
+    std::vector<float> edgeProbabilities(const CDF& source);
+
+    /**
+     * @brief 生成8位和16位整数查找表
+     */
+    void buildIntegerTables();
+
+    float min_;                    // 源数据最小值
+    float max_;                    // 源数据最大值
+    float binWidth_;               // 源数据bin宽度
+    size_t resolution_;            // 源数据bin数量
+    std::vector<float> lut_;       // bin边界查找表
+    std::vector<uint8_t> lut8_;    // 8位精确查找表
+    std::vector<uint16_t> lut16_;  // 16位精确查找表
+};
+
+} // namespace histogram
+
+#endif // HISTOGRAM_TRANSFORM_HPP
@@ -0,0 +1,274 @@
+#include "Ingestor.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace histogram {
+
+namespace {
+
+// 自动选择时的块大小。parallelFor把块静态地分成每线程一段连续范围，每个线程一个私有直方图，
+// 所以块大小不影响负载均衡，只决定切分粒度：少于线程数个块的输入只用相应数量的线程
+constexpr size_t kDefaultChunkSize = size_t(8) << 20;
+// 解析结果攒满一批后再写入直方图
+constexpr size_t kBatchSize = 4096;
+
+bool isLittleEndian() {
+    const uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+/**
+ * @brief 解析一个字段：去掉两侧空白和前导'+'后用from_chars解析，整个字段都被消耗才算成功
+ */
+bool parseField(const char* begin, const char* end, float& value) {
+    while (begin < end && (*begin == ' ' || *begin == '\t')) {
+        ++begin;
+    }
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) {
+        --end;
+    }
+    if (begin < end && *begin == '+') {
+        ++begin;
+    }
+    if (begin == end) {
+        return false;
+    }
+    auto result = std::from_chars(begin, end, value);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+/**
+ * @brief 是否为空行（只含空白）
+ */
+bool isBlank(const char* begin, const char* end) {
+    return std::all_of(begin, end, [](char ch) { return ch == ' ' || ch == '\t' || ch == '\r'; });
+}
+
+/**
+ * @brief 分批写入私有直方图的缓冲区，同时统计有限值的最小、最大值
+ */
+class Batch {
+public:
+    Batch(Histogram* hist, Ingestor::Stats& stats) : hist_(hist), stats_(stats), size_(0) {}
+
+    void push(float value) {
+        values_[size_++] = value;
+        if (size_ == kBatchSize) {
+            flush();
+        }
+    }
+
+    void flush() {
+        float minValue = stats_.minValue;
+        float maxValue = stats_.maxValue;
+        for (size_t i = 0; i < size_; ++i) {
+            const float value = values_[i];
+            const bool finite = value >= -std::numeric_limits<float>::max() &&
+                                value <= std::numeric_limits<float>::max();
+            minValue = finite && value < minValue ? value : minValue;
+            maxValue = finite && value > maxValue ? value : maxValue;
+        }
+        stats_.minValue = minValue;
+        stats_.maxValue = maxValue;
+        if (hist_ != nullptr) {
+            hist_->addData(values_, size_);
+        }
+        size_ = 0;
+    }
+
+private:
+    Histogram* hist_;
+    Ingestor::Stats& stats_;
+    float values_[kBatchSize];
+    size_t size_;
+};
+
+/**
+ * @brief 内存映射的只读文件
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename) : data_(nullptr), size_(0) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open file: " + filename);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot open file: " + filename);
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        if (size_ > 0) {
+            void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Cannot map file: " + filename);
+            }
+            ::madvise(mapping, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(mapping);
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if (data_ != nullptr) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_;
+    size_t size_;
+};
+
+} // namespace
+
+Ingestor::Ingestor(Format format, unsigned threads)
+    : format_(format), threads_(threads), delimiter_(','), column_(0), chunkSize_(0) {}
+
+Ingestor::Stats Ingestor::ingestFile(const std::string& filename, Histogram& hist) const {
+    MappedFile file(filename);
+    return ingest(file.data(), file.size(), hist);
+}
+
+Ingestor::Stats Ingestor::ingest(const char* data, size_t size, Histogram& hist) const {
+    return run(data, size, &hist);
+}
+
+Ingestor::Stats Ingestor::scanFile(const std::string& filename) const {
+    MappedFile file(filename);
+    return scan(file.data(), file.size());
+}
+
+Ingestor::Stats Ingestor::scan(const char* data, size_t size) const {
+    return run(data, size, nullptr);
+}
+
+Ingestor::Stats Ingestor::run(const char* data, size_t size, Histogram* hist) const {
+    Stats stats;
+    stats.bytes = size;
+    const size_t valueSize = format_ == Format::Float32 ? 4 : format_ == Format::Float64 ? 8 : 1;
+    if (size % valueSize != 0) {
+        throw std::runtime_error("Binary input size is not a multiple of the value size");
+    }
+
+    // 块大小按值的字节数对齐，使二进制块不会切开一个值
+    size_t chunkSize = chunkSize_ > 0 ? chunkSize_ : kDefaultChunkSize;
+    chunkSize = std::max(chunkSize / valueSize, size_t(1)) * valueSize;
+    const size_t chunks = (size + chunkSize - 1) / chunkSize;
+    const bool littleEndian = isLittleEndian();
+
+    std::mutex mutex;
+    detail::parallelFor(chunks, 1, threads_, [&](size_t firstChunk, size_t lastChunk) {
+        std::unique_ptr<Histogram> local;
+        if (hist != nullptr) {
+            local.reset(new Histogram(hist->getMin(), hist->getMax(), hist->getResolution()));
+        }
+        Stats localStats;
+        {
+            Batch batch(local.get(), localStats);
+            const size_t chunkBegin = firstChunk * chunkSize;
+            const size_t chunkEnd = std::min(lastChunk * chunkSize, size);
+
+            if (format_ == Format::Text) {
+                // 起始位置不在行首时跳过残行，它属于上一块
+                size_t pos = chunkBegin;
+                if (pos > 0 && data[pos - 1] != '\n') {
+                    const void* newline = std::memchr(data + pos, '\n', size - pos);
+                    pos = newline ? static_cast<size_t>(static_cast<const char*>(newline) - data) + 1 : size;
+                }
+                while (pos < chunkEnd) {
+                    const char* line = data + pos;
+                    const void* newline = std::memchr(line, '\n', size - pos);
+                    const char* lineEnd = newline ? static_cast<const char*>(newline) : data + size;
+                    pos = static_cast<size_t>(lineEnd - data) + 1;
+
+                    const char* field = line;
+                    for (size_t c = 0; c < column_ && field <= lineEnd; ++c) {
+                        const void* next = std::memchr(field, delimiter_, static_cast<size_t>(lineEnd - field));
+                        field = next ? static_cast<const char*>(next) + 1 : lineEnd + 1;
+                    }
+                    if (field > lineEnd) {
+                        localStats.skipped += isBlank(line, lineEnd) ? 0 : 1; // 列数不足
+                        continue;
+                    }
+                    const void* next = std::memchr(field, delimiter_, static_cast<size_t>(lineEnd - field));
+                    const char* fieldEnd = next ? static_cast<const char*>(next) : lineEnd;
+
+                    float value;
+                    if (parseField(field, fieldEnd, value)) {
+                        batch.push(value);
+                        ++localStats.values;
+                    } else if (!isBlank(line, lineEnd)) {
+                        ++localStats.skipped; // 空行不计入
+                    }
+                }
+            } else {
+                for (size_t offset = chunkBegin; offset < chunkEnd; offset += valueSize) {
+                    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data + offset);
+                    float value;
+                    if (format_ == Format::Float32) {
+                        uint32_t bits;
+                        std::memcpy(&bits, bytes, 4);
+                        if (!littleEndian) {
+                            bits = 0;
+                            for (int b = 3; b >= 0; --b) {
+                                bits = (bits << 8) | bytes[b];
+                            }
+                        }
+                        std::memcpy(&value, &bits, 4);
+                    } else {
+                        uint64_t bits;
+                        std::memcpy(&bits, bytes, 8);
+                        if (!littleEndian) {
+                            bits = 0;
+                            for (int b = 7; b >= 0; --b) {
+                                bits = (bits << 8) | bytes[b];
+                            }
+                        }
+                        double wide;
+                        std::memcpy(&wide, &bits, 8);
+                        value = static_cast<float>(wide);
+                    }
+                    batch.push(value);
+                }
+                localStats.values += (chunkEnd - chunkBegin) / valueSize;
+            }
+            batch.flush();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (hist != nullptr) {
+            hist->merge(*local);
+        }
+        stats.values += localStats.values;
+        stats.skipped += localStats.skipped;
+        stats.minValue = std::min(stats.minValue, localStats.minValue);
+        stats.maxValue = std::max(stats.maxValue, localStats.maxValue);
+    });
+    return stats;
+}
+
+} // namespace histogram
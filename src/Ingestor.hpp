@@ -0,0 +1,155 @@
+#ifndef INGESTOR_HPP
+#define INGESTOR_HPP
+
+#include "Histogram.hpp"
+#include <cstddef>
+#include <limits>
+#include <string>
+
+namespace histogram {
+
+/**
+ * @brief 从文本或二进制文件高速读入数据到直方图
+ *
+ * 文件整体内存映射后按块划分给多个线程。文本格式每行一条记录，字段以分隔符分开，
+ * 取指定列用std::from_chars解析；每块只处理起始位置落在块内的记录（块首的残行属于上一块，
+ * 块尾的记录读到换行为止），因此结果与块的划分无关。二进制格式为连续的小端float32或float64。
+ * 每个线程把解析结果分批写入私有的直方图，结束后合并到目标直方图。
+ */
+class Ingestor {
+public:
+    /**
+     * @brief 输入格式
+     */
+    enum class Format {
+        Text,    // 换行分隔的文本，可为CSV（见setDelimiter/setColumn）
+        Float32, // 小端float32数组
+        Float64  // 小端float64数组（转换为float后分箱）
+    };
+
+    /**
+     * @brief 读入统计
+     */
+    struct Stats {
+        size_t bytes = 0;   // 输入字节数
+        size_t values = 0;  // 成功解析的数值个数（包括超出直方图范围的）
+        size_t skipped = 0; // 无法解析的非空记录数（如表头）
+        float minValue = std::numeric_limits<float>::infinity();  // 有限数值的最小值（没有时为+inf）
+        float maxValue = -std::numeric_limits<float>::infinity(); // 有限数值的最大值（没有时为-inf）
+    };
+
+    /**
+     * @brief 构造函数
+     * @param format 输入格式
+     * @param threads 线程数（0表示使用硬件并发数）
+     */
+    explicit Ingestor(Format format = Format::Text, unsigned threads = 0);
+
+    /**
+     * @brief 设置输入格式
+     * @param format 输入格式
+     */
+    void setFormat(Format format) { format_ = format; }
+
+    /**
+     * @brief 获取输入格式
+     * @return 输入格式
+     */
+    Format getFormat() const { return format_; }
+
+    /**
+     * @brief 设置线程数
+     * @param threads 线程数（0表示使用硬件并发数）
+     */
+    void setThreads(unsigned threads) { threads_ = threads; }
+
+    /**
+     * @brief 获取线程数设置
+     * @return 线程数（0表示使用硬件并发数）
+     */
+    unsigned getThreads() const { return threads_; }
+
+    /**
+     * @brief 设置文本记录的字段分隔符
+     * @param delimiter 分隔符（默认','）
+     */
+    void setDelimiter(char delimiter) { delimiter_ = delimiter; }
+
+    /**
+     * @brief 获取字段分隔符
+     * @return 分隔符
+     */
+    char getDelimiter() const { return delimiter_; }
+
+    /**
+     * @brief 设置文本记录中读取的列
+     * @param column 列索引（从0开始，默认0）
+     */
+    void setColumn(size_t column) { column_ = column; }
+
+    /**
+     * @brief 获取读取的列
+     * @return 列索引
+     */
+    size_t getColumn() const { return column_; }
+
+    /**
+     * @brief 设置每块的字节数
+     * @param chunkSize 块大小（0表示自动选择，8 MiB）
+     *
+     * 各线程分得连续的、块数相同的一段输入，块大小只决定切分粒度和可用的线程数，
+     * 不做动态负载均衡。
+     */
+    void setChunkSize(size_t chunkSize) { chunkSize_ = chunkSize; }
+
+    /**
+     * @brief 获取块大小设置
+     * @return 块大小（0表示自动选择）
+     */
+    size_t getChunkSize() const { return chunkSize_; }
+
+    /**
+     * @brief 读入文件到直方图
+     * @param filename 文件名
+     * @param hist 目标直方图（在已有计数上累加）
+     * @return 读入统计
+     */
+    Stats ingestFile(const std::string& filename, Histogram& hist) const;
+
+    /**
+     * @brief 读入内存中的数据到直方图
+     * @param data 数据指针
+     * @param size 字节数
+     * @param hist 目标直方图（在已有计数上累加）
+     * @return 读入统计
+     */
+    Stats ingest(const char* data, size_t size, Histogram& hist) const;
+
+    /**
+     * @brief 只解析文件，不写入直方图（用于自动确定范围）
+     * @param filename 文件名
+     * @return 读入统计，包括数值的最小、最大值
+     */
+    Stats scanFile(const std::string& filename) const;
+
+    /**
+     * @brief 只解析内存中的数据，不写入直方图
+     * @param data 数据指针
+     * @param size 字节数
+     * @return 读入统计，包括数值的最小、最大值
+     */
+    Stats scan(const char* data, size_t size) const;
+
+private:
+    Stats run(const char* data, size_t size, Histogram* hist) const;
+
+    Format format_;    // 输入格式
+    unsigned threads_; // 线程数
+    char delimiter_;   // 字段分隔符
+    size_t column_;    // 读取的列
+    size_t chunkSize_; // 每块字节数
+};
+
+} // namespace histogram
+
+#endif // INGESTOR_HPP
@@ -0,0 +1,225 @@
+#include "MappedHistogram.hpp"
+#include "ByteIO.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace histogram {
+
+namespace {
+
+constexpr char kMagic[4] = {'H', 'S', 'T', 'M'};
+constexpr uint32_t kFormatVersion = 1;
+constexpr uint32_t kCounterBytes = 8;
+// 头部占满一页，计数数组从页对齐的偏移开始；页大小按4096字节计，与平台无关
+constexpr uint64_t kCountsOffset = 4096;
+
+bool isLittleEndian() {
+    const uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+} // namespace
+
+void MappedHistogram::write(const Histogram& hist, const std::string& filename) {
+    // 头部的总计数取各bin之和（merge重新分箱时totalCount_可能包含范围外的计数），与computeCDF的核对一致
+    const auto& counts = hist.getBinCounts();
+    uint64_t binTotal = 0;
+    for (size_t count : counts) {
+        binTotal += count;
+    }
+
+    std::string header;
+    header.append(kMagic, sizeof(kMagic));
+    detail::appendLittleEndian(header, kFormatVersion);
+    detail::appendLittleEndian(header, kCounterBytes);
+    detail::appendLittleEndian(header, uint32_t(0)); // 保留
+    detail::appendLittleEndian(header, hist.getMin());
+    detail::appendLittleEndian(header, hist.getMax());
+    detail::appendLittleEndian(header, static_cast<uint64_t>(hist.getResolution()));
+    detail::appendLittleEndian(header, binTotal);
+    detail::appendLittleEndian(header, kCountsOffset);
+    header.resize(kCountsOffset, '\0');
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+    if (isLittleEndian() && sizeof(size_t) == kCounterBytes) {
+        file.write(reinterpret_cast<const char*>(counts.data()),
+                   static_cast<std::streamsize>(counts.size() * sizeof(size_t)));
+    } else {
+        std::string buffer;
+        for (size_t count : counts) {
+            detail::appendLittleEndian(buffer, static_cast<uint64_t>(count));
+        }
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+
+    if (!file) {
+        throw std::runtime_error("Failed to write file: " + filename);
+    }
+}
+
+MappedHistogram::MappedHistogram(const std::string& filename)
+    : mapping_(nullptr), mappingSize_(0), counts_(nullptr), resolution_(0), totalCount_(0),
+      min_(0.0f), max_(0.0f), binWidth_(0.0f) {
+    if (!isLittleEndian() || sizeof(size_t) != kCounterBytes) {
+        throw std::runtime_error("MappedHistogram requires a 64-bit little-endian platform");
+    }
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(kCountsOffset)) {
+        ::close(fd);
+        throw std::runtime_error("Invalid MappedHistogram file: " + filename);
+    }
+    mappingSize_ = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, mappingSize_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // 映射保持有效
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map file: " + filename + ": " + std::strerror(errno));
+    }
+    mapping_ = mapping;
+
+    try {
+        detail::ByteReader reader(static_cast<const char*>(mapping_), kCountsOffset);
+        if (!std::equal(kMagic, kMagic + sizeof(kMagic), reader.readBytes(sizeof(kMagic))) ||
+            reader.readLittleEndian<uint32_t>() != kFormatVersion ||
+            reader.readLittleEndian<uint32_t>() != kCounterBytes) {
+            throw std::runtime_error("Invalid MappedHistogram file: " + filename);
+        }
+        reader.readLittleEndian<uint32_t>(); // 保留
+        min_ = reader.readLittleEndian<float>();
+        max_ = reader.readLittleEndian<float>();
+        const uint64_t resolution = reader.readLittleEndian<uint64_t>();
+        const uint64_t totalCount = reader.readLittleEndian<uint64_t>();
+        const uint64_t offset = reader.readLittleEndian<uint64_t>();
+        // 计数数组不能与头部重叠，且必须页对齐
+        if (!(min_ < max_) || resolution == 0 || offset < kCountsOffset || offset % kCountsOffset != 0 ||
+            offset > mappingSize_ || resolution > (mappingSize_ - offset) / kCounterBytes) {
+            throw std::runtime_error("Invalid MappedHistogram file: " + filename);
+        }
+        resolution_ = static_cast<size_t>(resolution);
+        totalCount_ = static_cast<size_t>(totalCount);
+        binWidth_ = (max_ - min_) / resolution_;
+        counts_ = reinterpret_cast<const size_t*>(static_cast<const char*>(mapping_) + offset);
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+MappedHistogram::~MappedHistogram() {
+    release();
+}
+
+MappedHistogram::MappedHistogram(MappedHistogram&& other) noexcept
+    : mapping_(other.mapping_), mappingSize_(other.mappingSize_), counts_(other.counts_),
+      resolution_(other.resolution_), totalCount_(other.totalCount_), min_(other.min_), max_(other.max_),
+      binWidth_(other.binWidth_) {
+    other.mapping_ = nullptr;
+    other.mappingSize_ = 0;
+    other.counts_ = nullptr;
+    other.resolution_ = 0;
+}
+
+MappedHistogram& MappedHistogram::operator=(MappedHistogram&& other) noexcept {
+    if (this != &other) {
+        release();
+        mapping_ = other.mapping_;
+        mappingSize_ = other.mappingSize_;
+        counts_ = other.counts_;
+        resolution_ = other.resolution_;
+        totalCount_ = other.totalCount_;
+        min_ = other.min_;
+        max_ = other.max_;
+        binWidth_ = other.binWidth_;
+        other.mapping_ = nullptr;
+        other.mappingSize_ = 0;
+        other.counts_ = nullptr;
+        other.resolution_ = 0;
+    }
+    return *this;
+}
+
+void MappedHistogram::release() {
+    if (mapping_ != nullptr) {
+        ::munmap(mapping_, mappingSize_);
+        mapping_ = nullptr;
+    }
+}
+
+size_t MappedHistogram::getBinCount(size_t binIndex) const {
+    if (binIndex >= resolution_) {
+        throw std::out_of_range("binIndex out of range");
+    }
+    return counts_[binIndex];
+}
+
+std::pair<float, float> MappedHistogram::getBinRange(size_t binIndex) const {
+    if (binIndex >= resolution_) {
+        throw std::out_of_range("binIndex out of range");
+    }
+    float binMin = min_ + binIndex * binWidth_;
+    float binMax = (binIndex == resolution_ - 1) ? max_ : binMin + binWidth_;
+    return {binMin, binMax};
+}
+
+std::pair<size_t, size_t> MappedHistogram::getMaxBin() const {
+    size_t maxCount = 0;
+    size_t maxIndex = 0;
+    for (size_t i = 0; i < resolution_; ++i) {
+        if (counts_[i] > maxCount) {
+            maxCount = counts_[i];
+            maxIndex = i;
+        }
+    }
+    return {maxCount, maxIndex};
+}
+
+std::vector<size_t> MappedHistogram::findPeaks(float minProminence) const {
+    return Histogram::findPeaks(counts_, resolution_, totalCount_, minProminence);
+}
+
+void MappedHistogram::computeCDF(CDF& cdf) const {
+    // 打开时不校验头部的总计数（需要读入整个计数数组）；CDF本来就要扫描全部计数，在这里核对
+    size_t sum = 0;
+    for (size_t i = 0; i < resolution_; ++i) {
+        if (counts_[i] > totalCount_ - sum) {
+            throw std::runtime_error("MappedHistogram bin counts exceed the total count");
+        }
+        sum += counts_[i];
+    }
+    if (sum != totalCount_) {
+        throw std::runtime_error("MappedHistogram total count does not match the bin counts");
+    }
+    cdf.computeFromCounts(counts_, resolution_, totalCount_, min_, max_);
+}
+
+Histogram MappedHistogram::toHistogram() const {
+    Histogram hist(min_, max_, resolution_);
+    for (size_t i = 0; i < resolution_; ++i) {
+        if (counts_[i] > 0) {
+            hist.addBinCount(i, counts_[i]);
+        }
+    }
+    return hist;
+}
+
+} // namespace histogram
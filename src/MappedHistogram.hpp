@@ -0,0 +1,138 @@
+#ifndef MAPPED_HISTOGRAM_HPP
+#define MAPPED_HISTOGRAM_HPP
+
+#include "Histogram.hpp"
+#include "CDF.hpp"
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace histogram {
+
+/**
+ * @brief 内存映射的只读直方图视图
+ *
+ * 文件格式：第一页（4096字节）为固定头部——魔数"HSTM"、版本、计数器字节数（8）、min、max、
+ * bin数、总计数（各bin计数之和）和计数数组的偏移（小端）；计数数组从页对齐的偏移开始，为小端uint64。
+ * 打开时只映射文件并校验头部，不复制计数；各查询直接读映射内存，只有访问到的页才会被载入。
+ * 头部中的总计数在打开时不与计数数组核对（那需要读入整个数组），getTotalCount()和findPeaks()
+ * 直接使用它；computeCDF()扫描全部计数时核对，不一致则抛出std::runtime_error。
+ * 零拷贝访问要求64位小端平台，其他平台打开时抛出std::runtime_error。
+ *
+ * 视图不可复制，可移动；映射在析构时释放。
+ */
+class MappedHistogram {
+public:
+    /**
+     * @brief 把直方图写为可映射的文件
+     * @param hist 直方图
+     * @param filename 文件名
+     */
+    static void write(const Histogram& hist, const std::string& filename);
+
+    /**
+     * @brief 映射文件并校验头部
+     * @param filename 文件名
+     */
+    explicit MappedHistogram(const std::string& filename);
+
+    ~MappedHistogram();
+
+    MappedHistogram(const MappedHistogram&) = delete;
+    MappedHistogram& operator=(const MappedHistogram&) = delete;
+    MappedHistogram(MappedHistogram&& other) noexcept;
+    MappedHistogram& operator=(MappedHistogram&& other) noexcept;
+
+    /**
+     * @brief 获取指定bin的计数值
+     * @param binIndex bin索引
+     * @return bin的计数值
+     */
+    size_t getBinCount(size_t binIndex) const;
+
+    /**
+     * @brief 获取指定bin的值范围
+     * @param binIndex bin索引
+     * @return bin的值范围（最小值，最大值）
+     */
+    std::pair<float, float> getBinRange(size_t binIndex) const;
+
+    /**
+     * @brief 获取映射的计数数组
+     * @return 指向resolution个计数的指针
+     */
+    const size_t* getBinCounts() const { return counts_; }
+
+    /**
+     * @brief 获取bin数量
+     * @return bin数量
+     */
+    size_t getResolution() const { return resolution_; }
+
+    /**
+     * @brief 获取最小值
+     * @return 最小值
+     */
+    float getMin() const { return min_; }
+
+    /**
+     * @brief 获取最大值
+     * @return 最大值
+     */
+    float getMax() const { return max_; }
+
+    /**
+     * @brief 获取bin宽度
+     * @return bin宽度
+     */
+    float getBinWidth() const { return binWidth_; }
+
+    /**
+     * @brief 获取总数据点数（取自文件头部，未与计数数组核对）
+     * @return 总数据点数
+     */
+    size_t getTotalCount() const { return totalCount_; }
+
+    /**
+     * @brief 获取最大bin的计数值和索引（扫描整个计数数组）
+     * @return pair(最大计数值, bin索引)
+     */
+    std::pair<size_t, size_t> getMaxBin() const;
+
+    /**
+     * @brief 检测波峰，结果与Histogram::findPeaks相同
+     * @param minProminence 最小突出度阈值（相对于最大bin的百分比，0-1）
+     * @return 波峰索引向量
+     */
+    std::vector<size_t> findPeaks(float minProminence = 0.1f) const;
+
+    /**
+     * @brief 直接从映射的计数计算CDF
+     * @param cdf 输出的CDF
+     * @throws std::runtime_error 计数之和与头部的总计数不一致
+     */
+    void computeCDF(CDF& cdf) const;
+
+    /**
+     * @brief 复制为可修改的直方图（总数据点数取各bin计数之和）
+     * @return 直方图对象
+     */
+    Histogram toHistogram() const;
+
+private:
+    void release();
+
+    void* mapping_;        // 映射起始地址
+    size_t mappingSize_;   // 映射字节数
+    const size_t* counts_; // 映射中的计数数组
+    size_t resolution_;    // bin数量
+    size_t totalCount_;    // 总数据点数
+    float min_;            // 最小值
+    float max_;            // 最大值
+    float binWidth_;       // bin宽度
+};
+
+} // namespace histogram
+
+#endif // MAPPED_HISTOGRAM_HPP
@@ -0,0 +1,245 @@
+#include "OpenMetricsExporter.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace histogram {
+
+namespace {
+
+// 计数和浮点数的最大文本长度（size_t最多20位，double最短表示最多24个字符）
+constexpr size_t kMaxCountChars = 20;
+constexpr size_t kMaxDoubleChars = 32;
+
+bool isNameChar(char c, bool first, bool allowColon) {
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (allowColon && c == ':')) {
+        return true;
+    }
+    return !first && c >= '0' && c <= '9';
+}
+
+bool isName(const std::string& name, bool allowColon) {
+    if (name.empty()) {
+        return false;
+    }
+    for (size_t i = 0; i < name.size(); ++i) {
+        if (!isNameChar(name[i], i == 0, allowColon)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 按OpenMetrics的规则转义标签值和帮助文本中的反斜杠、双引号和换行
+ */
+void appendEscaped(std::string& output, const std::string& text) {
+    for (char c : text) {
+        if (c == '\\') {
+            output += "\\\\";
+        } else if (c == '"') {
+            output += "\\\"";
+        } else if (c == '\n') {
+            output += "\\n";
+        } else {
+            output += c;
+        }
+    }
+}
+
+void appendFloat(std::string& output, float value) {
+    char buffer[kMaxDoubleChars];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    output.append(buffer, result.ptr);
+}
+
+char* append(char* out, const std::string& text) {
+    std::memcpy(out, text.data(), text.size());
+    return out + text.size();
+}
+
+} // namespace
+
+OpenMetricsExporter::OpenMetricsExporter(const std::string& name, const std::string& help)
+    : name_(name), help_(help), prepared_(false), cachedMin_(0.0f), cachedMax_(0.0f),
+      cachedResolution_(0), writeSum_(true) {
+    if (!isName(name, true)) {
+        throw std::invalid_argument("Invalid metric name: " + name);
+    }
+}
+
+void OpenMetricsExporter::setBuckets(const std::vector<float>& bounds) {
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        if (!std::isfinite(bounds[i])) {
+            throw std::invalid_argument("Bucket bounds must be finite");
+        }
+        if (i > 0 && !(bounds[i - 1] < bounds[i])) {
+            throw std::invalid_argument("Bucket bounds must be strictly increasing");
+        }
+    }
+    bounds_ = bounds;
+    prepared_ = false;
+}
+
+size_t OpenMetricsExporter::addSeries(const Labels& labels) {
+    std::string text;
+    for (const auto& label : labels) {
+        if (!isName(label.first, false) || label.first == "le") {
+            throw std::invalid_argument("Invalid label name: " + label.first);
+        }
+        if (!text.empty()) {
+            text += ',';
+        }
+        text += label.first;
+        text += "=\"";
+        appendEscaped(text, label.second);
+        text += '"';
+    }
+
+    Series series;
+    series.bucketPrefix = name_ + "_bucket{" + text + (text.empty() ? "" : ",") + "le=\"";
+    const std::string braced = text.empty() ? std::string() : "{" + text + "}";
+    series.sumPrefix = name_ + "_sum" + braced + " ";
+    series.countPrefix = name_ + "_count" + braced + " ";
+    series_.push_back(std::move(series));
+    return series_.size() - 1;
+}
+
+void OpenMetricsExporter::writeHeader(std::string& output) const {
+    output += "# TYPE ";
+    output += name_;
+    output += " histogram\n";
+    if (!help_.empty()) {
+        output += "# HELP ";
+        output += name_;
+        output += ' ';
+        appendEscaped(output, help_);
+        output += '\n';
+    }
+}
+
+void OpenMetricsExporter::prepare(const Histogram& hist) {
+    const float minValue = hist.getMin();
+    const float maxValue = hist.getMax();
+    const size_t resolution = hist.getResolution();
+    if (prepared_ && cachedMin_ == minValue && cachedMax_ == maxValue && cachedResolution_ == resolution) {
+        return;
+    }
+
+    // 与Histogram::getBinRange相同的计算方式
+    const float binWidth = hist.getBinWidth();
+    auto upperEdge = [&](size_t i) {
+        return (i == resolution - 1) ? maxValue : minValue + i * binWidth + binWidth;
+    };
+
+    std::vector<float> les;
+    cuts_.clear();
+    if (bounds_.empty()) {
+        les.resize(resolution);
+        cuts_.resize(resolution);
+        for (size_t i = 0; i < resolution; ++i) {
+            les[i] = upperEdge(i);
+            cuts_[i] = i + 1;
+        }
+    } else {
+        // 上边界不超过le的bin个数，上边界单调递增，二分查找
+        les = bounds_;
+        cuts_.resize(bounds_.size());
+        for (size_t k = 0; k < bounds_.size(); ++k) {
+            size_t low = 0;
+            size_t high = resolution;
+            while (low < high) {
+                const size_t mid = low + (high - low) / 2;
+                if (upperEdge(mid) <= bounds_[k]) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            cuts_[k] = low;
+        }
+    }
+
+    leText_.clear();
+    leOffsets_.assign(1, 0);
+    for (float le : les) {
+        appendFloat(leText_, le);
+        leText_ += "\"} ";
+        leOffsets_.push_back(leText_.size());
+    }
+    leText_ += "+Inf\"} ";
+    leOffsets_.push_back(leText_.size());
+
+    // 有负值或负的le时_sum不再单调，OpenMetrics规定此时不输出_sum
+    writeSum_ = minValue >= 0.0f && (les.empty() || les.front() >= 0.0f);
+
+    prepared_ = true;
+    cachedMin_ = minValue;
+    cachedMax_ = maxValue;
+    cachedResolution_ = resolution;
+}
+
+void OpenMetricsExporter::writeSeries(size_t series, const Histogram& hist, std::string& output) {
+    const Series& prefixes = series_.at(series);
+    prepare(hist);
+
+    const size_t buckets = leOffsets_.size() - 1;
+    const size_t bound = buckets * (prefixes.bucketPrefix.size() + kMaxCountChars + 1) + leText_.size() +
+                         prefixes.sumPrefix.size() + kMaxDoubleChars + 1 +
+                         prefixes.countPrefix.size() + kMaxCountChars + 1;
+    const size_t start = output.size();
+    output.resize(start + bound);
+    char* out = &output[start];
+    char* last = out + bound;
+
+    const auto& counts = hist.getBinCounts();
+    const size_t resolution = counts.size();
+    size_t cumulative = 0;
+    size_t runningTotal = 0; // 各bin累计计数之和，用于求_sum，避免逐bin的乘法和浮点转换
+    size_t bin = 0;
+    for (size_t k = 0; k < buckets; ++k) {
+        const size_t cut = (k < cuts_.size()) ? cuts_[k] : resolution;
+        for (; bin < cut; ++bin) {
+            cumulative += counts[bin];
+            runningTotal += cumulative;
+        }
+        out = append(out, prefixes.bucketPrefix);
+        const size_t leSize = leOffsets_[k + 1] - leOffsets_[k];
+        std::memcpy(out, leText_.data() + leOffsets_[k], leSize);
+        out = std::to_chars(out + leSize, last, cumulative).ptr;
+        *out++ = '\n';
+    }
+
+    if (writeSum_) {
+        // Σ counts[i]·(min + (i + 0.5)·binWidth)，其中Σ i·counts[i] = resolution·count - Σ各bin的累计计数
+        const size_t weighted = resolution * cumulative - runningTotal;
+        const double binWidth = (static_cast<double>(hist.getMax()) - hist.getMin()) / resolution;
+        const double sum = static_cast<double>(cumulative) * hist.getMin() +
+                           binWidth * (static_cast<double>(weighted) + 0.5 * static_cast<double>(cumulative));
+        out = append(out, prefixes.sumPrefix);
+        out = std::to_chars(out, last, sum).ptr;
+        *out++ = '\n';
+    }
+    out = append(out, prefixes.countPrefix);
+    out = std::to_chars(out, last, cumulative).ptr;
+    *out++ = '\n';
+
+    output.resize(static_cast<size_t>(out - output.data()));
+}
+
+void OpenMetricsExporter::write(const std::vector<const Histogram*>& hists, std::string& output) {
+    if (hists.size() != series_.size()) {
+        throw std::invalid_argument("Number of histograms does not match number of series");
+    }
+    writeHeader(output);
+    for (size_t i = 0; i < hists.size(); ++i) {
+        writeSeries(i, *hists[i], output);
+    }
+}
+
+void OpenMetricsExporter::writeEOF(std::string& output) {
+    output += "# EOF\n";
+}
+
+} // namespace histogram
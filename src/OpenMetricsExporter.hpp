@@ -0,0 +1,135 @@
+#ifndef OPEN_METRICS_EXPORTER_HPP
+#define OPEN_METRICS_EXPORTER_HPP
+
+#include "Histogram.hpp"
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace histogram {
+
+/**
+ * @brief 以OpenMetrics/Prometheus文本格式导出直方图（累计的_bucket、_sum和_count）
+ *
+ * 一个导出器对应一个指标族，每组标签注册为一个序列。注册时把各行的前缀
+ * （如`name_bucket{job="a",le="`）拼好缓存，le的文本和bucket边界对应的bin区间按直方图几何缓存，
+ * 每次导出只用std::to_chars写计数，直接写进调用方复用的字符串，容量足够时不分配内存。
+ *
+ * 未设置bucket边界时每个bin对应一个bucket，le为bin的上边界；设置边界后把bin合并到这些边界，
+ * 只有上边界不超过le的bin计入该bucket（跨越边界的bin计入下一个bucket）。
+ * 直方图不记录原始值，_sum按bin中心估计。直方图最小值为负或有负的le时，_sum不再随观测单调，
+ * 按OpenMetrics的规定不输出_sum（只输出bucket和_count）。导出器不是线程安全的。
+ */
+class OpenMetricsExporter {
+public:
+    /**
+     * @brief 标签列表（名称，未转义的值）
+     */
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    /**
+     * @brief 构造函数
+     * @param name 指标名（[a-zA-Z_:][a-zA-Z0-9_:]*）
+     * @param help 帮助文本（为空时不输出# HELP）
+     */
+    explicit OpenMetricsExporter(const std::string& name, const std::string& help = "");
+
+    /**
+     * @brief 设置bucket边界（le），用于把bin合并为较少的bucket
+     * @param bounds 严格递增的有限边界（为空表示每个bin一个bucket）；+Inf总是自动追加
+     */
+    void setBuckets(const std::vector<float>& bounds);
+
+    /**
+     * @brief 获取bucket边界
+     * @return bucket边界（为空表示每个bin一个bucket）
+     */
+    const std::vector<float>& getBuckets() const { return bounds_; }
+
+    /**
+     * @brief 获取指标名
+     * @return 指标名
+     */
+    const std::string& getName() const { return name_; }
+
+    /**
+     * @brief 获取帮助文本
+     * @return 帮助文本
+     */
+    const std::string& getHelp() const { return help_; }
+
+    /**
+     * @brief 注册一个序列并缓存其各行前缀
+     * @param labels 标签（名称须为[a-zA-Z_][a-zA-Z0-9_]*，且不能为le）
+     * @return 序列编号，从0开始连续分配
+     */
+    size_t addSeries(const Labels& labels = Labels());
+
+    /**
+     * @brief 获取已注册的序列数
+     * @return 序列数
+     */
+    size_t getSeriesCount() const { return series_.size(); }
+
+    /**
+     * @brief 写出指标族的# TYPE和# HELP行
+     * @param output 输出字符串（追加写入）
+     */
+    void writeHeader(std::string& output) const;
+
+    /**
+     * @brief 写出一个序列的所有bucket以及_sum（最小值或le为负时省略）、_count行
+     * @param series 序列编号
+     * @param hist 直方图
+     * @param output 输出字符串（追加写入）
+     */
+    void writeSeries(size_t series, const Histogram& hist, std::string& output);
+
+    /**
+     * @brief 写出整个指标族：头部，然后第i个序列对应hists[i]
+     * @param hists 直方图，数量须与序列数相同
+     * @param output 输出字符串（追加写入）
+     */
+    void write(const std::vector<const Histogram*>& hists, std::string& output);
+
+    /**
+     * @brief 写出OpenMetrics要求的结束标记# EOF（所有指标族之后调用一次）
+     * @param output 输出字符串（追加写入）
+     */
+    static void writeEOF(std::string& output);
+
+private:
+    /**
+     * @brief 一个序列缓存的行前缀
+     */
+    struct Series {
+        std::string bucketPrefix; // name_bucket{labels,le="
+        std::string sumPrefix;    // name_sum{labels}加空格
+        std::string countPrefix;  // name_count{labels}加空格
+    };
+
+    /**
+     * @brief 直方图几何变化时重新计算le文本和bucket对应的bin区间
+     * @param hist 直方图
+     */
+    void prepare(const Histogram& hist);
+
+    std::string name_;                // 指标名
+    std::string help_;                // 帮助文本
+    std::vector<float> bounds_;       // bucket边界（为空表示每个bin一个bucket）
+    std::vector<Series> series_;      // 各序列的行前缀
+
+    bool prepared_;                   // 以下缓存是否对应cachedMin_等记录的几何
+    float cachedMin_;                 // 缓存对应的直方图最小值
+    float cachedMax_;                 // 缓存对应的直方图最大值
+    size_t cachedResolution_;         // 缓存对应的直方图分辨率
+    std::string leText_;              // 各bucket的le文本（含结尾的`"} `），依次拼接，最后为+Inf
+    std::vector<size_t> leOffsets_;   // 第k个le文本位于[leOffsets_[k], leOffsets_[k + 1])
+    std::vector<size_t> cuts_;        // 第k个有限bucket包含下标小于cuts_[k]的bin
+    bool writeSum_;                   // 是否输出_sum（最小值和所有le均非负）
+};
+
+} // namespace histogram
+
+#endif // OPEN_METRICS_EXPORTER_HPP
@@ -0,0 +1,111 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace histogram {
+namespace detail {
+
+/**
+ * @brief 解析线程数
+ * @param threads 期望线程数（0表示使用硬件并发数）
+ * @return 实际使用的线程数（至少为1）
+ */
+inline unsigned resolveThreadCount(unsigned threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    return threads == 0 ? 1u : threads;
+}
+
+/**
+ * @brief 将区间[0, count)切分为连续块并行处理
+ * @param count 元素总数
+ * @param minChunk 每个块的最小元素数，小于该规模的输入直接在当前线程处理
+ * @param threads 线程数（0表示使用硬件并发数）
+ * @param func 块处理函数，签名为 void(size_t begin, size_t end)
+ *
+ * 块按顺序分配且互不重叠；任一块抛出的异常会在所有线程结束后重新抛出。
+ */
+template <typename Func>
+void parallelFor(size_t count, size_t minChunk, unsigned threads, Func&& func) {
+    if (count == 0) {
+        return;
+    }
+
+    minChunk = std::max<size_t>(minChunk, 1);
+    size_t maxChunks = (count + minChunk - 1) / minChunk;
+    size_t chunks = std::min<size_t>(resolveThreadCount(threads), maxChunks);
+    if (chunks <= 1) {
+        func(size_t(0), count);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    std::vector<std::exception_ptr> errors(chunks);
+    workers.reserve(chunks - 1);
+
+    size_t chunkSize = count / chunks;
+    size_t remainder = count % chunks;
+    size_t begin = 0;
+    for (size_t c = 0; c < chunks; ++c) {
+        size_t end = begin + chunkSize + (c < remainder ? 1 : 0);
+        auto task = [&func, &errors, c, begin, end]() {
+            try {
+                func(begin, end);
+            } catch (...) {
+                errors[c] = std::current_exception();
+            }
+        };
+        if (c + 1 == chunks) {
+            task(); // 最后一块在调用线程执行
+        } else {
+            workers.emplace_back(task);
+        }
+        begin = end;
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+/**
+ * @brief 线程局部缓冲区保留的最大字节数，超过时在使用结束后释放
+ */
+constexpr size_t kMaxRetainedScratchBytes = size_t(1) << 20;
+
+/**
+ * @brief 线程局部缓冲区的作用域守卫：析构时若容量超过kMaxRetainedScratchBytes则释放内存
+ *
+ * 小缓冲区在同一线程的多次调用间复用；偶尔一次大输入不会让线程永久占用同等大小的内存。
+ */
+template <typename T>
+class ScratchRelease {
+public:
+    explicit ScratchRelease(std::vector<T>& buffer) : buffer_(buffer) {}
+    ~ScratchRelease() {
+        if (buffer_.capacity() * sizeof(T) > kMaxRetainedScratchBytes) {
+            std::vector<T>().swap(buffer_);
+        }
+    }
+    ScratchRelease(const ScratchRelease&) = delete;
+    ScratchRelease& operator=(const ScratchRelease&) = delete;
+
+private:
+    std::vector<T>& buffer_;
+};
+
+} // namespace detail
+} // namespace histogram
+
+#endif // PARALLEL_HPP
@@ -0,0 +1,240 @@
+#include "PeakFinder.hpp"
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+namespace histogram {
+
+namespace {
+
+/**
+ * @brief 波峰一侧的基底：值和位置
+ */
+struct Base {
+    double value;
+    size_t index;
+};
+
+/**
+ * @brief 用单调栈求每个波峰一侧的基底
+ * @param x 输入数据
+ * @param size 数据长度
+ * @param peaks 按位置升序的波峰索引
+ * @param reverse false求左侧基底，true求右侧基底
+ * @param bases 输出，bases[k]为第k个波峰的基底
+ *
+ * 左侧基底是(第一个严格更高的点, 波峰]区间内的最小值，取值相同时取最靠近波峰的位置，
+ * 与scipy逐个向左扫描的结果一致。栈中保存严格递减的样本，每个元素同时记录它与栈中
+ * 下一个元素之间（不含两端）的最小值，出栈时合并，因此每个样本只入栈、出栈一次。
+ */
+template <typename T>
+void findBases(const T* x, size_t size, const std::vector<size_t>& peaks, bool reverse,
+               std::vector<Base>& bases) {
+    struct Entry {
+        size_t index; // 样本位置
+        Base gap;     // 与下一个栈元素（或当前样本）之间的最小值
+    };
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<Entry> stack;
+    Base outer{inf, 0}; // 栈底元素之前（不含栈底）的最小值
+    bases.resize(peaks.size());
+
+    size_t next = reverse ? peaks.size() : 0; // 下一个待记录的波峰
+    for (size_t step = 0; step < size; ++step) {
+        const size_t i = reverse ? size - 1 - step : step;
+        const double value = static_cast<double>(x[i]);
+
+        // 新合并进来的候选离i更远，只有严格更小时才替换
+        Base region{inf, i};
+        while (!stack.empty() && static_cast<double>(x[stack.back().index]) <= value) {
+            const Entry& top = stack.back();
+            if (top.gap.value < region.value) {
+                region = top.gap;
+            }
+            const double topValue = static_cast<double>(x[top.index]);
+            if (topValue < region.value) {
+                region = {topValue, top.index};
+            }
+            stack.pop_back();
+        }
+        Base& gap = stack.empty() ? outer : stack.back().gap;
+        if (gap.value < region.value) {
+            region = gap;
+        }
+        gap = region;
+
+        if (reverse ? (next > 0 && peaks[next - 1] == i) : (next < peaks.size() && peaks[next] == i)) {
+            const size_t k = reverse ? --next : next++;
+            bases[k] = (region.value < value) ? region : Base{value, i};
+        }
+        stack.push_back({i, {inf, i}});
+    }
+}
+
+} // namespace
+
+PeakFinder::PeakFinder()
+    : height_(-std::numeric_limits<double>::infinity()), threshold_(0.0), distance_(1),
+      prominence_(0.0), width_(0.0), relHeight_(0.5) {}
+
+void PeakFinder::setDistance(size_t distance) {
+    if (distance == 0) {
+        throw std::invalid_argument("Distance must be at least 1");
+    }
+    distance_ = distance;
+}
+
+void PeakFinder::setRelHeight(double relHeight) {
+    if (!(relHeight >= 0.0)) {
+        throw std::invalid_argument("relHeight must not be negative");
+    }
+    relHeight_ = relHeight;
+}
+
+PeakFinder::Result PeakFinder::find(const float* values, size_t size) const {
+    return findImpl(values, size);
+}
+
+PeakFinder::Result PeakFinder::find(const size_t* counts, size_t size) const {
+    return findImpl(counts, size);
+}
+
+PeakFinder::Result PeakFinder::find(const std::vector<float>& values) const {
+    return findImpl(values.data(), values.size());
+}
+
+PeakFinder::Result PeakFinder::find(const std::vector<size_t>& counts) const {
+    return findImpl(counts.data(), counts.size());
+}
+
+PeakFinder::Result PeakFinder::find(const Histogram& hist) const {
+    const auto& counts = hist.getBinCounts();
+    return findImpl(counts.data(), counts.size());
+}
+
+template <typename T>
+PeakFinder::Result PeakFinder::findImpl(const T* x, size_t size) const {
+    Result result;
+    if (size < 3) {
+        return result;
+    }
+    auto at = [x](size_t i) { return static_cast<double>(x[i]); };
+
+    // 局部极大值：左邻严格更低，向右越过相等的平台后右邻严格更低，取平台中点
+    std::vector<size_t> peaks;
+    for (size_t i = 1; i + 1 < size; ++i) {
+        if (!(at(i - 1) < at(i))) {
+            continue;
+        }
+        size_t ahead = i + 1;
+        while (ahead + 1 < size && at(ahead) == at(i)) {
+            ++ahead;
+        }
+        if (at(ahead) < at(i)) {
+            peaks.push_back((i + ahead - 1) / 2);
+            i = ahead;
+        }
+    }
+
+    // 高度和阈值
+    peaks.erase(std::remove_if(peaks.begin(), peaks.end(), [&](size_t p) {
+        const double value = at(p);
+        return value < height_ || std::min(value - at(p - 1), value - at(p + 1)) < threshold_;
+    }), peaks.end());
+
+    // 最小间距：按高度从高到低（高度相同时靠右优先，与scipy一致）取出波峰，删除其间距内尚未取出的波峰
+    if (distance_ > 1 && peaks.size() > 1) {
+        const size_t count = peaks.size();
+        std::priority_queue<std::pair<double, size_t>> queue;
+        for (size_t k = 0; k < count; ++k) {
+            queue.emplace(at(peaks[k]), k);
+        }
+        std::vector<char> keep(count, 1);
+        while (!queue.empty()) {
+            const size_t k = queue.top().second;
+            queue.pop();
+            if (!keep[k]) {
+                continue;
+            }
+            for (size_t j = k; j-- > 0 && peaks[k] - peaks[j] < distance_;) {
+                keep[j] = 0;
+            }
+            for (size_t j = k + 1; j < count && peaks[j] - peaks[k] < distance_; ++j) {
+                keep[j] = 0;
+            }
+        }
+        size_t kept = 0;
+        for (size_t k = 0; k < count; ++k) {
+            if (keep[k]) {
+                peaks[kept++] = peaks[k];
+            }
+        }
+        peaks.resize(kept);
+    }
+
+    // 突出度：两侧基底在完整数据上求得
+    std::vector<Base> leftBases;
+    std::vector<Base> rightBases;
+    findBases(x, size, peaks, false, leftBases);
+    findBases(x, size, peaks, true, rightBases);
+
+    const size_t count = peaks.size();
+    result.peaks.reserve(count);
+    result.heights.reserve(count);
+    result.prominences.reserve(count);
+    result.leftBases.reserve(count);
+    result.rightBases.reserve(count);
+    result.widths.reserve(count);
+    result.widthHeights.reserve(count);
+    result.leftIps.reserve(count);
+    result.rightIps.reserve(count);
+
+    for (size_t k = 0; k < count; ++k) {
+        const size_t peak = peaks[k];
+        const double value = at(peak);
+        const double prominence = value - std::max(leftBases[k].value, rightBases[k].value);
+        if (prominence < prominence_) {
+            continue;
+        }
+
+        // 在 value - prominence·relHeight 处向两侧走到第一个不高于该高度的点（不越过基底），线性插值
+        const double widthHeight = value - prominence * relHeight_;
+        const size_t leftBase = leftBases[k].index;
+        const size_t rightBase = rightBases[k].index;
+        size_t i = peak;
+        while (leftBase < i && widthHeight < at(i)) {
+            --i;
+        }
+        double leftIp = static_cast<double>(i);
+        if (at(i) < widthHeight) {
+            leftIp += (widthHeight - at(i)) / (at(i + 1) - at(i));
+        }
+        i = peak;
+        while (i < rightBase && widthHeight < at(i)) {
+            ++i;
+        }
+        double rightIp = static_cast<double>(i);
+        if (at(i) < widthHeight) {
+            rightIp -= (widthHeight - at(i)) / (at(i - 1) - at(i));
+        }
+        const double width = rightIp - leftIp;
+        if (width < width_) {
+            continue;
+        }
+
+        result.peaks.push_back(peak);
+        result.heights.push_back(static_cast<float>(value));
+        result.prominences.push_back(static_cast<float>(prominence));
+        result.leftBases.push_back(leftBase);
+        result.rightBases.push_back(rightBase);
+        result.widths.push_back(static_cast<float>(width));
+        result.widthHeights.push_back(static_cast<float>(widthHeight));
+        result.leftIps.push_back(static_cast<float>(leftIp));
+        result.rightIps.push_back(static_cast<float>(rightIp));
+    }
+    return result;
+}
+
+} // namespace histogram
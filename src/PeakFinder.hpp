@@ -0,0 +1,178 @@
+#ifndef PEAK_FINDER_HPP
+#define PEAK_FINDER_HPP
+
+#include "Histogram.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace histogram {
+
+/**
+ * @brief 一维波峰检测，语义与scipy.signal.find_peaks一致
+ *
+ * 局部极大值包含平台（取平台中点，两端点不算波峰）；突出度为波峰高度减去两侧
+ * 基底中较高者，基底是向两侧走到第一个更高的点之前的最小值，用单调栈在O(n)内求得；
+ * 宽度在 height - prominence·relHeight 处测量并做线性插值；最小间距按高度从高到低
+ * 依次保留波峰，删除其间距内的较低波峰。
+ *
+ * 过滤顺序与scipy相同：高度、阈值、间距、突出度、宽度。突出度和宽度总是在完整数据上计算，
+ * 不受先前过滤的影响。
+ */
+class PeakFinder {
+public:
+    /**
+     * @brief 检测结果，按列存放，第k个波峰的各项属性位于各数组的第k个元素，按位置升序
+     */
+    struct Result {
+        std::vector<size_t> peaks;        // 波峰索引（平台取中点）
+        std::vector<float> heights;       // 波峰高度
+        std::vector<float> prominences;   // 突出度
+        std::vector<size_t> leftBases;    // 左侧基底索引
+        std::vector<size_t> rightBases;   // 右侧基底索引
+        std::vector<float> widths;        // 在widthHeights处测得的宽度（样本单位）
+        std::vector<float> widthHeights;  // 测量宽度的高度
+        std::vector<float> leftIps;       // 宽度左端的插值位置
+        std::vector<float> rightIps;      // 宽度右端的插值位置
+
+        /**
+         * @brief 波峰个数
+         */
+        size_t size() const { return peaks.size(); }
+
+        /**
+         * @brief 是否没有波峰
+         */
+        bool empty() const { return peaks.empty(); }
+    };
+
+    /**
+     * @brief 构造函数，默认不做任何过滤（返回全部局部极大值）
+     */
+    PeakFinder();
+
+    /**
+     * @brief 设置最小波峰高度
+     * @param height 最小高度（默认-inf，不过滤）
+     */
+    void setHeight(double height) { height_ = height; }
+
+    /**
+     * @brief 设置波峰与相邻样本的最小高度差
+     * @param threshold 最小高度差（默认0，不过滤）
+     */
+    void setThreshold(double threshold) { threshold_ = threshold; }
+
+    /**
+     * @brief 设置相邻波峰的最小间距
+     * @param distance 最小间距（样本数，默认1，不过滤）
+     *
+     * 按高度从高到低保留波峰并删除其间距内的其余波峰；高度相同时先保留靠右的，与scipy.signal.find_peaks一致。
+     */
+    void setDistance(size_t distance);
+
+    /**
+     * @brief 设置最小突出度
+     * @param prominence 最小突出度（默认0，不过滤）
+     */
+    void setProminence(double prominence) { prominence_ = prominence; }
+
+    /**
+     * @brief 设置最小宽度
+     * @param width 最小宽度（样本数，默认0，不过滤）
+     */
+    void setWidth(double width) { width_ = width; }
+
+    /**
+     * @brief 设置测量宽度的相对高度
+     * @param relHeight 相对突出度的比例（默认0.5，即半突出度处的宽度）
+     */
+    void setRelHeight(double relHeight);
+
+    /**
+     * @brief 获取最小高度
+     * @return 最小高度
+     */
+    double getHeight() const { return height_; }
+
+    /**
+     * @brief 获取与相邻样本的最小高度差
+     * @return 与相邻样本的最小高度差
+     */
+    double getThreshold() const { return threshold_; }
+
+    /**
+     * @brief 获取最小间距
+     * @return 最小间距
+     */
+    size_t getDistance() const { return distance_; }
+
+    /**
+     * @brief 获取最小突出度
+     * @return 最小突出度
+     */
+    double getProminence() const { return prominence_; }
+
+    /**
+     * @brief 获取最小宽度
+     * @return 最小宽度
+     */
+    double getWidth() const { return width_; }
+
+    /**
+     * @brief 获取测量宽度的相对高度
+     * @return 测量宽度的相对高度
+     */
+    double getRelHeight() const { return relHeight_; }
+
+    /**
+     * @brief 检测一维数据（如GaussianFilter的输出）中的波峰
+     * @param values 输入数据
+     * @param size 数据长度
+     * @return 检测结果
+     */
+    Result find(const float* values, size_t size) const;
+
+    /**
+     * @brief 检测直方图计数中的波峰
+     * @param counts 计数
+     * @param size 数据长度
+     * @return 检测结果
+     */
+    Result find(const size_t* counts, size_t size) const;
+
+    /**
+     * @brief 检测一维数据中的波峰
+     * @param values 输入数据
+     * @return 检测结果
+     */
+    Result find(const std::vector<float>& values) const;
+
+    /**
+     * @brief 检测直方图计数中的波峰
+     * @param counts 计数
+     * @return 检测结果
+     */
+    Result find(const std::vector<size_t>& counts) const;
+
+    /**
+     * @brief 检测直方图中的波峰
+     * @param hist 直方图
+     * @return 检测结果
+     */
+    Result find(const Histogram& hist) const;
+
+private:
+    template <typename T>
+    Result findImpl(const T* x, size_t size) const;
+
+    double height_;     // 最小高度
+    double threshold_;  // 与相邻样本的最小高度差
+    size_t distance_;   // 最小间距
+    double prominence_; // 最小突出度
+    double width_;      // 最小宽度
+    double relHeight_;  // 测量宽度的相对高度
+};
+
+} // namespace histogram
+
+#endif // PEAK_FINDER_HPP
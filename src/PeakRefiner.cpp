@@ -0,0 +1,170 @@
+#include "PeakRefiner.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace histogram {
+
+namespace {
+
+// 高斯的半高全宽与sigma之比 2·sqrt(2·ln2)
+constexpr float kFWHMPerSigma = 2.35482004503f;
+
+/**
+ * @brief 在半高处向两侧线性插值得到的宽度（样本单位）
+ */
+template <typename T>
+float halfMaximumWidth(const T* values, size_t size, size_t peak, float height) {
+    const float half = 0.5f * height;
+    auto at = [values](size_t i) { return static_cast<float>(values[i]); };
+
+    size_t i = peak;
+    while (i > 0 && at(i) >= half) {
+        --i;
+    }
+    float left = static_cast<float>(i);
+    if (i < peak && at(i) < half) {
+        left += (half - at(i)) / (at(i + 1) - at(i));
+    }
+
+    i = peak;
+    while (i + 1 < size && at(i) >= half) {
+        ++i;
+    }
+    float right = static_cast<float>(i);
+    if (i > peak && at(i) < half) {
+        right -= (half - at(i)) / (at(i - 1) - at(i));
+    }
+    return right - left;
+}
+
+} // namespace
+
+PeakRefiner::Result PeakRefiner::refine(const size_t* counts, size_t size,
+                                        const std::vector<size_t>& peaks) const {
+    return refineImpl(counts, size, peaks);
+}
+
+PeakRefiner::Result PeakRefiner::refine(const float* values, size_t size,
+                                        const std::vector<size_t>& peaks) const {
+    return refineImpl(values, size, peaks);
+}
+
+PeakRefiner::Result PeakRefiner::refine(const Histogram& hist, const std::vector<size_t>& peaks) const {
+    Result result = refineImpl(hist.getBinCounts().data(), hist.getResolution(), peaks);
+    // bin坐标i对应第i个bin的中心
+    const float binWidth = hist.getBinWidth();
+    for (size_t k = 0; k < result.size(); ++k) {
+        result.positions[k] = hist.getMin() + (result.positions[k] + 0.5f) * binWidth;
+        result.fwhms[k] *= binWidth;
+    }
+    return result;
+}
+
+template <typename T>
+PeakRefiner::Result PeakRefiner::refineImpl(const T* values, size_t size,
+                                            const std::vector<size_t>& peaks) const {
+    const size_t count = peaks.size();
+    Result result;
+    result.positions.resize(count);
+    result.heights.resize(count);
+    result.fwhms.resize(count);
+
+    for (size_t peak : peaks) {
+        if (peak >= size) {
+            throw std::out_of_range("Peak index out of range");
+        }
+    }
+
+    if (method_ == Method::Centroid) {
+        // 支撑区间：从波峰向两侧单调下降且不低于半高的bin；权重减去半高，
+        // 使支撑边缘的权重连续地趋于0，减小区间按整bin截断带来的偏差
+        for (size_t k = 0; k < count; ++k) {
+            const size_t peak = peaks[k];
+            const double height = static_cast<double>(values[peak]);
+            size_t lo = peak;
+            while (lo > 0 && values[lo - 1] >= 0.5 * height && values[lo - 1] <= values[lo]) {
+                --lo;
+            }
+            size_t hi = peak;
+            while (hi + 1 < size && values[hi + 1] >= 0.5 * height && values[hi + 1] <= values[hi]) {
+                ++hi;
+            }
+            double weight = 0.0;
+            double moment = 0.0;
+            for (size_t i = lo; i <= hi; ++i) {
+                double w = static_cast<double>(values[i]) - 0.5 * height;
+                weight += w;
+                moment += static_cast<double>(i) * w;
+            }
+            result.positions[k] = static_cast<float>(weight > 0.0 ? moment / weight : peak);
+            result.heights[k] = static_cast<float>(height);
+            result.fwhms[k] = halfMaximumWidth(values, size, peak, static_cast<float>(height));
+        }
+        return result;
+    }
+
+    // 收集三点值，端点处按镜像补齐
+    std::vector<float> left(count);
+    std::vector<float> center(count);
+    std::vector<float> right(count);
+    for (size_t k = 0; k < count; ++k) {
+        const size_t peak = peaks[k];
+        center[k] = static_cast<float>(values[peak]);
+        float l = peak > 0 ? static_cast<float>(values[peak - 1]) : center[k];
+        float r = peak + 1 < size ? static_cast<float>(values[peak + 1]) : center[k];
+        left[k] = peak > 0 ? l : r;
+        right[k] = peak + 1 < size ? r : l;
+    }
+
+    // 无分支的拟合循环：抛物线 y = c + (l - r)/2·x + (l - 2c + r)/2·x²，
+    // 高斯拟合在对数域使用同样的公式；曲率不为负时偏移为0，宽度留给下面的修正
+    const bool gaussian = method_ == Method::Gaussian;
+    float* positions = result.positions.data();
+    float* heights = result.heights.data();
+    float* fwhms = result.fwhms.data();
+    for (size_t k = 0; k < count; ++k) {
+        const float l = left[k];
+        const float c = center[k];
+        const float r = right[k];
+
+        const float curvature = l - 2.0f * c + r;
+        const bool peaked = curvature < 0.0f;
+        const float safe = peaked ? curvature : -1.0f;
+        float offset = peaked ? 0.5f * (l - r) / safe : 0.0f;
+        offset = std::min(std::max(offset, -0.5f), 0.5f);
+        float height = c - 0.25f * (l - r) * offset;
+        float fwhm = peaked ? 2.0f * std::sqrt(std::max(height, 0.0f) / -safe) : 0.0f;
+
+        if (gaussian) {
+            const bool positive = l > 0.0f && c > 0.0f && r > 0.0f;
+            const float ll = std::log(std::max(l, 1e-30f));
+            const float lc = std::log(std::max(c, 1e-30f));
+            const float lr = std::log(std::max(r, 1e-30f));
+            const float logCurvature = ll - 2.0f * lc + lr;
+            const bool logPeaked = positive && logCurvature < 0.0f;
+            const float logSafe = logPeaked ? logCurvature : -1.0f;
+            float logOffset = std::min(std::max(0.5f * (ll - lr) / logSafe, -0.5f), 0.5f);
+            // 高斯 exp(lc + (ll - lr)/2·x + logCurvature/2·x²)，sigma² = -1/logCurvature
+            float logHeight = std::exp(lc - 0.25f * (ll - lr) * logOffset);
+            float logFwhm = kFWHMPerSigma * std::sqrt(-1.0f / logSafe);
+            offset = logPeaked ? logOffset : offset;
+            height = logPeaked ? logHeight : height;
+            fwhm = logPeaked ? logFwhm : fwhm;
+        }
+
+        positions[k] = static_cast<float>(peaks[k]) + offset;
+        heights[k] = height;
+        fwhms[k] = fwhm;
+    }
+
+    // 平顶等无法由三点确定宽度的波峰改用半高处的插值宽度
+    for (size_t k = 0; k < count; ++k) {
+        if (!(fwhms[k] > 0.0f)) {
+            fwhms[k] = halfMaximumWidth(values, size, peaks[k], heights[k]);
+        }
+    }
+    return result;
+}
+
+} // namespace histogram
@@ -0,0 +1,95 @@
+#ifndef PEAK_REFINER_HPP
+#define PEAK_REFINER_HPP
+
+#include "Histogram.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace histogram {
+
+/**
+ * @brief 波峰的亚bin定位：由波峰bin及其邻居估计连续的位置、高度和半高全宽
+ *
+ * 先把所有波峰的三点值收集到连续数组中，再在一个无分支的循环里计算全部波峰的拟合结果
+ * （抛物线拟合可被编译器自动向量化）；曲率不为负的少数波峰（平顶、端点处）随后改用半高处线性插值的宽度。
+ * 两端的波峰按镜像补齐缺失的邻居，位置不做偏移。
+ */
+class PeakRefiner {
+public:
+    /**
+     * @brief 拟合方法
+     */
+    enum class Method {
+        Parabolic, // 三点抛物线插值
+        Gaussian,  // 对数域三点抛物线（高斯）插值，对高斯形波峰无偏；有非正计数时退化为Parabolic
+        Centroid   // 半高以上、单调下降的支撑区间内以超出半高的部分加权的质心，宽度按半高处线性插值
+    };
+
+    /**
+     * @brief 定位结果，按列存放，第k个元素对应输入的第k个波峰
+     */
+    struct Result {
+        std::vector<float> positions; // 位置（bin坐标：整数i为第i个bin的中心；直方图版本为数据值）
+        std::vector<float> heights;   // 拟合的峰值高度
+        std::vector<float> fwhms;     // 半高全宽（bin数；直方图版本为数据值单位）
+
+        /**
+         * @brief 波峰个数
+         */
+        size_t size() const { return positions.size(); }
+    };
+
+    /**
+     * @brief 构造函数
+     * @param method 拟合方法
+     */
+    explicit PeakRefiner(Method method = Method::Gaussian) : method_(method) {}
+
+    /**
+     * @brief 设置拟合方法
+     * @param method 拟合方法
+     */
+    void setMethod(Method method) { method_ = method; }
+
+    /**
+     * @brief 获取拟合方法
+     * @return 拟合方法
+     */
+    Method getMethod() const { return method_; }
+
+    /**
+     * @brief 对计数数组中的波峰做亚bin定位
+     * @param counts 计数
+     * @param size 数据长度
+     * @param peaks 波峰所在的bin（如findPeaks或PeakFinder的结果）
+     * @return 定位结果（bin坐标）
+     */
+    Result refine(const size_t* counts, size_t size, const std::vector<size_t>& peaks) const;
+
+    /**
+     * @brief 对一维数据（如GaussianFilter的输出）中的波峰做亚bin定位
+     * @param values 输入数据
+     * @param size 数据长度
+     * @param peaks 波峰所在的索引
+     * @return 定位结果（样本坐标）
+     */
+    Result refine(const float* values, size_t size, const std::vector<size_t>& peaks) const;
+
+    /**
+     * @brief 对直方图中的波峰做亚bin定位
+     * @param hist 直方图
+     * @param peaks 波峰所在的bin
+     * @return 定位结果，位置和半高全宽换算为数据值
+     */
+    Result refine(const Histogram& hist, const std::vector<size_t>& peaks) const;
+
+private:
+    template <typename T>
+    Result refineImpl(const T* values, size_t size, const std::vector<size_t>& peaks) const;
+
+    Method method_; // 拟合方法
+};
+
+} // namespace histogram
+
+#endif // PEAK_REFINER_HPP
@@ -0,0 +1,89 @@
+#include "PeakTracker.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace histogram {
+
+PeakTracker::PeakTracker(Histogram& hist, size_t minCount)
+    : hist_(hist), minCount_(minCount), peakFlags_(hist.getResolution(), 0) {
+    rescan();
+}
+
+void PeakTracker::addData(float value) {
+    int binIndex = hist_.getBinIndex(value);
+    if (binIndex < 0 || binIndex >= static_cast<int>(hist_.getResolution())) {
+        return; // 与Histogram::addData一样忽略超出范围的值
+    }
+    hist_.addBinCount(static_cast<size_t>(binIndex), 1);
+    updateAround(static_cast<size_t>(binIndex));
+}
+
+void PeakTracker::addBinCount(size_t binIndex, size_t count) {
+    hist_.addBinCount(binIndex, count);
+    updateAround(binIndex);
+}
+
+void PeakTracker::rescan() {
+    for (size_t i = 0; i < hist_.getResolution(); ++i) {
+        update(i);
+    }
+}
+
+std::vector<std::tuple<size_t, size_t, std::pair<float, float>>> PeakTracker::getPeaksInfo() const {
+    std::vector<std::tuple<size_t, size_t, std::pair<float, float>>> peaksInfo;
+    const auto& counts = hist_.getBinCounts();
+    for (size_t peakIndex : peaks_) {
+        peaksInfo.emplace_back(peakIndex, counts[peakIndex], hist_.getBinRange(peakIndex));
+    }
+    return peaksInfo;
+}
+
+bool PeakTracker::isPeak(size_t binIndex) const {
+    if (binIndex >= peakFlags_.size()) {
+        throw std::out_of_range("binIndex out of range");
+    }
+    return peakFlags_[binIndex] != 0;
+}
+
+void PeakTracker::updateAround(size_t binIndex) {
+    // 计数变化只影响该bin和左右邻居是否严格大于各自的邻居
+    if (binIndex > 0) {
+        update(binIndex - 1);
+    }
+    update(binIndex);
+    if (binIndex + 1 < peakFlags_.size()) {
+        update(binIndex + 1);
+    }
+}
+
+void PeakTracker::update(size_t binIndex) {
+    const bool wasPeak = peakFlags_[binIndex] != 0;
+    const bool nowPeak = evaluate(binIndex);
+    if (wasPeak == nowPeak) {
+        return;
+    }
+
+    // 波峰的出现和消失远少于更新次数，在有序数组中插入/删除即可保持查询无需排序
+    auto position = std::lower_bound(peaks_.begin(), peaks_.end(), binIndex);
+    if (nowPeak) {
+        peaks_.insert(position, binIndex);
+    } else {
+        peaks_.erase(position);
+    }
+    peakFlags_[binIndex] = nowPeak ? 1 : 0;
+
+    if (callback_) {
+        callback_(binIndex, nowPeak);
+    }
+}
+
+bool PeakTracker::evaluate(size_t binIndex) const {
+    const auto& counts = hist_.getBinCounts();
+    if (binIndex == 0 || binIndex + 1 >= counts.size()) {
+        return false;
+    }
+    const size_t count = counts[binIndex];
+    return count > counts[binIndex - 1] && count > counts[binIndex + 1] && count >= minCount_;
+}
+
+} // namespace histogram
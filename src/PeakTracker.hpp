@@ -0,0 +1,127 @@
+#ifndef PEAK_TRACKER_HPP
+#define PEAK_TRACKER_HPP
+
+#include "Histogram.hpp"
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace histogram {
+
+/**
+ * @brief 在实时更新的直方图上增量维护局部极大值
+ *
+ * 注意：跟踪器只能看到经由tracker.addData()/tracker.addBinCount()的更新，看不到直接对Histogram的修改。
+ * 直接调用Histogram的addData（包括批量版本）、addBinCount、merge、mergeFromSerialized、clear，
+ * 或用Ingestor写入同一个直方图后，波峰集合会过期，必须调用rescan()（O(bin数)）。
+ *
+ * 一次计数增加只会改变该bin及其左右邻居是否为局部极大值，因此每次更新只重新判断三个bin，
+ * 而不是重新扫描整个直方图。局部极大值的定义与Histogram::findPeaks的基本判据相同：
+ * 不在两端，且计数严格大于左右邻居（另外可要求计数不小于minCount）。
+ *
+ * 波峰按bin索引有序保存：判断是否为波峰的更新为O(1)，只有波峰出现或消失时才在有序数组中
+ * 二分查找并插入/删除（O(log p + p)，p为波峰数）。查询不修改任何状态，没有更新时可从多个线程同时查询。
+ * 跟踪器持有直方图的引用，直方图的生命周期必须长于跟踪器。
+ */
+class PeakTracker {
+public:
+    /**
+     * @brief 波峰变化回调
+     * @param bin bin索引
+     * @param appeared true表示该bin成为波峰，false表示不再是波峰
+     */
+    using Callback = std::function<void(size_t bin, bool appeared)>;
+
+    /**
+     * @brief 构造函数，附加到直方图并扫描一次当前的局部极大值
+     * @param hist 被跟踪的直方图
+     * @param minCount 波峰的最小计数（0表示不限制）
+     */
+    explicit PeakTracker(Histogram& hist, size_t minCount = 0);
+
+    /**
+     * @brief 添加数据点并更新波峰
+     * @param value 数据值（超出范围时忽略）
+     */
+    void addData(float value);
+
+    /**
+     * @brief 直接向指定bin累加计数并更新波峰
+     * @param binIndex bin索引
+     * @param count 累加的计数值
+     */
+    void addBinCount(size_t binIndex, size_t count);
+
+    /**
+     * @brief 重新扫描整个直方图（直方图被直接修改或清空后调用），变化的波峰同样触发回调
+     */
+    void rescan();
+
+    /**
+     * @brief 设置波峰出现或消失时的回调
+     * @param callback 回调函数（为空表示不回调）
+     */
+    void setCallback(Callback callback) { callback_ = std::move(callback); }
+
+    /**
+     * @brief 获取当前的波峰
+     * @return 按bin索引升序的波峰
+     */
+    const std::vector<size_t>& getPeaks() const { return peaks_; }
+
+    /**
+     * @brief 获取当前波峰的详细信息
+     * @return 波峰信息向量（索引，计数值，值范围），与Histogram::getPeaksInfo形式相同
+     */
+    std::vector<std::tuple<size_t, size_t, std::pair<float, float>>> getPeaksInfo() const;
+
+    /**
+     * @brief 获取当前波峰数量
+     * @return 波峰数量
+     */
+    size_t getPeakCount() const { return peaks_.size(); }
+
+    /**
+     * @brief 判断指定bin当前是否为波峰
+     * @param binIndex bin索引
+     * @return 是否为波峰
+     */
+    bool isPeak(size_t binIndex) const;
+
+    /**
+     * @brief 获取被跟踪的直方图
+     * @return 直方图
+     */
+    const Histogram& getHistogram() const { return hist_; }
+
+private:
+    /**
+     * @brief 重新判断计数发生变化的bin及其左右邻居
+     * @param binIndex 计数发生变化的bin
+     */
+    void updateAround(size_t binIndex);
+
+    /**
+     * @brief 重新判断一个bin，状态变化时更新集合并回调
+     * @param binIndex bin索引
+     */
+    void update(size_t binIndex);
+
+    /**
+     * @brief 按当前计数判断一个bin是否为波峰
+     * @param binIndex bin索引
+     * @return 是否为波峰
+     */
+    bool evaluate(size_t binIndex) const;
+
+    Histogram& hist_;               // 被跟踪的直方图
+    size_t minCount_;               // 波峰的最小计数
+    std::vector<char> peakFlags_;   // peakFlags_[bin]表示该bin是否为波峰
+    std::vector<size_t> peaks_;     // 当前波峰，按bin索引升序
+    Callback callback_;             // 波峰变化回调
+};
+
+} // namespace histogram
+
+#endif // PEAK_TRACKER_HPP
@@ -0,0 +1,297 @@
+#include "ScaleSpace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace histogram {
+
+namespace {
+
+// 抽取后数据至少保留的样本数
+constexpr size_t kMinDownsampledSize = 16;
+
+/**
+ * @brief 单层上检测到的局部极大值
+ */
+struct LevelPeak {
+    float position; // 原始bin坐标
+    float response; // -σ²·L''
+    float height;   // 平滑后的计数
+};
+
+/**
+ * @brief 三点抛物线插值求极值位置的偏移（-0.5 ~ 0.5个样本）
+ */
+float parabolicOffset(float left, float center, float right) {
+    float denominator = left - 2.0f * center + right;
+    if (denominator >= 0.0f) {
+        return 0.0f;
+    }
+    return std::min(std::max(0.5f * (left - right) / denominator, -0.5f), 0.5f);
+}
+
+} // namespace
+
+ScaleSpace::ScaleSpace(float minSigma, float maxSigma, size_t levelsPerOctave, bool downsample)
+    : minSigma_(minSigma), maxSigma_(maxSigma), levelsPerOctave_(levelsPerOctave),
+      downsample_(downsample), baseFilter_(minSigma > 0 ? minSigma : 1.0f), levelCount_(0) {
+    if (minSigma <= 0) {
+        throw std::invalid_argument("Sigma must be greater than 0");
+    }
+    if (maxSigma < minSigma) {
+        throw std::invalid_argument("maxSigma must not be less than minSigma");
+    }
+    if (levelsPerOctave == 0) {
+        throw std::invalid_argument("levelsPerOctave must be greater than 0");
+    }
+
+    // 倍频程内第m层（m = 1..levelsPerOctave）由上一层得到：以当前层采样间隔为单位，
+    // σ_inc = minSigma·2^(m/L)·sqrt(1 - 2^(-2/L))，与所在倍频程无关
+    const double ratio = std::sqrt(1.0 - std::pow(2.0, -2.0 / levelsPerOctave));
+    for (size_t m = 1; m <= levelsPerOctave; ++m) {
+        double sigma = minSigma * std::pow(2.0, static_cast<double>(m) / levelsPerOctave) * ratio;
+        stepFilters_.emplace_back(static_cast<float>(sigma));
+    }
+}
+
+void ScaleSpace::build(const size_t* counts, size_t size) {
+    levelCount_ = 0;
+    if (size == 0) {
+        return;
+    }
+    Level& base = prepareLevel(0, minSigma_, 1, size);
+    baseFilter_.filterCounts(counts, base.values.data(), size);
+    buildLevels();
+}
+
+void ScaleSpace::build(const float* values, size_t size) {
+    levelCount_ = 0;
+    if (size == 0) {
+        return;
+    }
+    Level& base = prepareLevel(0, minSigma_, 1, size);
+    baseFilter_.filter(values, base.values.data(), size);
+    buildLevels();
+}
+
+void ScaleSpace::build(const Histogram& hist) {
+    build(hist.getBinCounts().data(), hist.getResolution());
+}
+
+ScaleSpace::Level& ScaleSpace::prepareLevel(size_t index, float sigma, size_t step, size_t size) {
+    // 重复构建时复用各层已分配的缓冲区
+    if (levels_.size() <= index) {
+        levels_.resize(index + 1);
+    }
+    Level& level = levels_[index];
+    level.sigma = sigma;
+    level.step = step;
+    level.values.resize(size);
+    levelCount_ = index + 1;
+    return level;
+}
+
+void ScaleSpace::buildLevels() {
+    computeDerivatives(levels_.front());
+
+    for (size_t k = 1;; ++k) {
+        double sigma = minSigma_ * std::pow(2.0, static_cast<double>(k) / levelsPerOctave_);
+        if (sigma > maxSigma_ * (1.0 + 1e-6)) {
+            break;
+        }
+
+        const size_t m = (k - 1) % levelsPerOctave_ + 1;
+        const float previousSigma = levels_[k - 1].sigma;
+        const size_t previousStep = levels_[k - 1].step;
+        const size_t previousSize = levels_[k - 1].values.size();
+
+        // 在上一层的网格上做增量滤波，增量sigma以上一层的采样间隔为单位；
+        // 每倍频程都抽取时与预计算的滤波器一致，否则（不抽取或数据太短）临时构造
+        double increment = std::sqrt(sigma * sigma - static_cast<double>(previousSigma) * previousSigma)
+                         / previousStep;
+        const GaussianFilter* filter = &stepFilters_[m - 1];
+        GaussianFilter adjusted;
+        if (std::abs(increment - filter->getSigma()) > 1e-4 * increment) {
+            adjusted.setSigma(static_cast<float>(increment));
+            filter = &adjusted;
+        }
+
+        // sigma达到新的倍频程时隔点抽取：先在上一层网格上滤波到临时缓冲区，再取偶数样本
+        const bool decimate = downsample_ && m == levelsPerOctave_ && previousSize / 2 >= kMinDownsampledSize;
+        Level& level = prepareLevel(k, static_cast<float>(sigma), decimate ? previousStep * 2 : previousStep,
+                                    decimate ? (previousSize + 1) / 2 : previousSize);
+        const Level& previous = levels_[k - 1];
+        if (decimate) {
+            scratch_.resize(previousSize);
+            filter->filter(previous.values.data(), scratch_.data(), previousSize);
+            for (size_t i = 0; i < level.values.size(); ++i) {
+                level.values[i] = scratch_[2 * i];
+            }
+        } else {
+            filter->filter(previous.values.data(), level.values.data(), previousSize);
+        }
+
+        computeDerivatives(level);
+    }
+}
+
+void ScaleSpace::computeDerivatives(Level& level) {
+    const std::vector<float>& v = level.values;
+    const size_t n = v.size();
+    const float step = static_cast<float>(level.step);
+    level.first.resize(n);
+    level.second.resize(n);
+    if (n < 3) {
+        std::fill(level.first.begin(), level.first.end(), 0.0f);
+        std::fill(level.second.begin(), level.second.end(), 0.0f);
+        return;
+    }
+
+    for (size_t i = 1; i + 1 < n; ++i) {
+        level.first[i] = (v[i + 1] - v[i - 1]) / (2.0f * step);
+        level.second[i] = (v[i + 1] - 2.0f * v[i] + v[i - 1]) / (step * step);
+    }
+    // 两端使用单侧差分
+    level.first[0] = (v[1] - v[0]) / step;
+    level.first[n - 1] = (v[n - 1] - v[n - 2]) / step;
+    level.second[0] = level.second[1];
+    level.second[n - 1] = level.second[n - 2];
+}
+
+const ScaleSpace::Level& ScaleSpace::levelAt(size_t level) const {
+    if (level >= levelCount_) {
+        throw std::out_of_range("Level index out of range");
+    }
+    return levels_[level];
+}
+
+float ScaleSpace::getSigma(size_t level) const {
+    return levelAt(level).sigma;
+}
+
+size_t ScaleSpace::getStep(size_t level) const {
+    return levelAt(level).step;
+}
+
+const std::vector<float>& ScaleSpace::getLevel(size_t level) const {
+    return levelAt(level).values;
+}
+
+const std::vector<float>& ScaleSpace::getFirstDerivative(size_t level) const {
+    return levelAt(level).first;
+}
+
+const std::vector<float>& ScaleSpace::getSecondDerivative(size_t level) const {
+    return levelAt(level).second;
+}
+
+std::vector<ScaleSpace::Peak> ScaleSpace::findPeaks(float minLifetime, float minResponse) const {
+    struct Track {
+        Peak peak;
+        float lastPosition; // 最近一层中的位置
+    };
+    std::vector<Track> tracks;
+    std::vector<size_t> active; // 在上一层仍然存在的轨迹
+    std::vector<LevelPeak> found; // 当前层的局部极大值（各层复用）
+    std::vector<size_t> owner;    // owner[p]为第p个极大值所属的轨迹，kNone表示尚未关联
+    constexpr size_t kNone = static_cast<size_t>(-1);
+
+    for (size_t k = 0; k < levelCount_; ++k) {
+        const Level& level = levels_[k];
+        const std::vector<float>& v = level.values;
+        const float step = static_cast<float>(level.step);
+
+        // 本层的局部极大值（平台取中点），要求二阶导数为负
+        found.clear();
+        for (size_t i = 1; i + 1 < v.size();) {
+            if (!(v[i] > v[i - 1])) {
+                ++i;
+                continue;
+            }
+            size_t j = i;
+            while (j + 1 < v.size() && v[j + 1] == v[i]) {
+                ++j;
+            }
+            if (j + 1 < v.size() && v[j + 1] < v[i]) {
+                size_t center = (i + j) / 2;
+                float second = level.second[center];
+                if (second < 0.0f) {
+                    float offset = (i == j) ? parabolicOffset(v[i - 1], v[i], v[i + 1]) : 0.0f;
+                    found.push_back({(static_cast<float>(center) + offset) * step,
+                                     -level.sigma * level.sigma * second, v[center]});
+                }
+            }
+            i = j + 1;
+        }
+
+        // 与上一层仍然存在的轨迹按位置就近关联，距离上限随sigma增大。
+        // 轨迹和极大值都按位置有序，且尺度空间中的波峰不会交叉，
+        // 因此按顺序匹配：每条轨迹只在上一条轨迹所匹配极大值的右侧查找，整层是一次线性归并
+        const float tolerance = std::max(step, 0.5f * level.sigma);
+        owner.assign(found.size(), kNone);
+        size_t next = 0;
+        for (size_t t : active) {
+            Track& track = tracks[t];
+            const float target = track.lastPosition;
+            size_t right = next;
+            while (right < found.size() && found[right].position < target) {
+                ++right;
+            }
+
+            size_t best = found.size();
+            float bestDistance = tolerance;
+            if (right < found.size() && found[right].position - target <= bestDistance) {
+                best = right;
+                bestDistance = found[right].position - target;
+            }
+            if (right > next && target - found[right - 1].position <= bestDistance) {
+                best = right - 1;
+            }
+            if (best == found.size()) {
+                next = std::max(next, right > 0 ? right - 1 : 0);
+                continue; // 轨迹在本层消失
+            }
+            owner[best] = t;
+            next = best + 1;
+            track.lastPosition = found[best].position;
+            track.peak.lastLevel = k;
+            if (found[best].response > track.peak.response) {
+                track.peak.response = found[best].response;
+                track.peak.position = found[best].position;
+                track.peak.scale = level.sigma;
+                track.peak.height = found[best].height;
+            }
+        }
+
+        // 未关联的极大值开始新轨迹；按极大值的顺序收集，下一层的轨迹仍按位置有序
+        active.clear();
+        for (size_t p = 0; p < found.size(); ++p) {
+            if (owner[p] == kNone) {
+                Peak peak{found[p].position, level.sigma, found[p].response, found[p].height, k, k, 0.0f};
+                tracks.push_back({peak, found[p].position});
+                owner[p] = tracks.size() - 1;
+            }
+            active.push_back(owner[p]);
+        }
+    }
+
+    float maxResponse = 0.0f;
+    for (const auto& track : tracks) {
+        maxResponse = std::max(maxResponse, track.peak.response);
+    }
+
+    std::vector<Peak> peaks;
+    for (auto& track : tracks) {
+        Peak& peak = track.peak;
+        peak.lifetime = static_cast<float>(peak.lastLevel - peak.firstLevel) / levelsPerOctave_;
+        if (peak.lifetime + 1e-6f >= minLifetime && peak.response >= minResponse * maxResponse) {
+            peaks.push_back(peak);
+        }
+    }
+    std::sort(peaks.begin(), peaks.end(), [](const Peak& a, const Peak& b) {
+        return a.response > b.response;
+    });
+    return peaks;
+}
+
+} // namespace histogram
@@ -0,0 +1,165 @@
+#ifndef SCALE_SPACE_HPP
+#define SCALE_SPACE_HPP
+
+#include "GaussianFilter.hpp"
+#include "Histogram.hpp"
+#include <vector>
+
+namespace histogram {
+
+/**
+ * @brief 一维高斯尺度空间，用于多尺度波峰检测
+ *
+ * sigma按几何级数排列（每倍频程levelsPerOctave层），每一层由上一层再做一次
+ * 小核高斯滤波得到（高斯的半群性质：σ_k² = σ_{k-1}² + σ_inc²）。sigma每增加一倍，
+ * 数据隔点抽取一次，后续层的核长度和数据长度都减半，因此整个尺度空间的代价
+ * 约为单次小sigma滤波的两倍，而不是每个sigma各做一次完整滤波。
+ *
+ * 每层同时给出一阶、二阶高斯导数响应（在该层平滑结果上做中心差分），
+ * 波峰在相邻层之间按位置关联，得到跨尺度稳定的波峰列表。
+ */
+class ScaleSpace {
+public:
+    /**
+     * @brief 跨尺度跟踪得到的波峰
+     */
+    struct Peak {
+        float position;    // 波峰位置（原始bin坐标，取响应最大的尺度上的抛物线插值结果）
+        float scale;       // 尺度归一化响应最大时的sigma（原始bin单位）
+        float response;    // 最大尺度归一化响应 -σ²·L''
+        float height;      // 该尺度上平滑后的计数
+        size_t firstLevel; // 出现的最细层
+        size_t lastLevel;  // 存在的最粗层
+        float lifetime;    // 存在的尺度范围（倍频程）
+    };
+
+    /**
+     * @brief 构造函数
+     * @param minSigma 最细层的sigma（原始bin单位），应不小于1以保证抽取时不混叠
+     * @param maxSigma 最粗层的sigma上限
+     * @param levelsPerOctave 每倍频程的层数
+     * @param downsample sigma每增加一倍时是否隔点抽取
+     */
+    ScaleSpace(float minSigma = 1.0f, float maxSigma = 32.0f, size_t levelsPerOctave = 3,
+               bool downsample = true);
+
+    /**
+     * @brief 由直方图计数构建尺度空间
+     * @param counts 直方图计数
+     * @param size 数据长度
+     */
+    void build(const size_t* counts, size_t size);
+
+    /**
+     * @brief 由一维数据构建尺度空间
+     * @param values 输入数据
+     * @param size 数据长度
+     */
+    void build(const float* values, size_t size);
+
+    /**
+     * @brief 由直方图构建尺度空间
+     * @param hist 直方图
+     */
+    void build(const Histogram& hist);
+
+    /**
+     * @brief 获取层数
+     * @return 层数
+     */
+    size_t getLevelCount() const { return levelCount_; }
+
+    /**
+     * @brief 获取指定层的sigma
+     * @param level 层索引
+     * @return sigma（原始bin单位）
+     */
+    float getSigma(size_t level) const;
+
+    /**
+     * @brief 获取指定层的采样间隔
+     * @param level 层索引
+     * @return 相邻样本在原始bin坐标中的距离（2的幂）
+     */
+    size_t getStep(size_t level) const;
+
+    /**
+     * @brief 获取指定层的平滑结果
+     * @param level 层索引
+     * @return 平滑后的数据，第i个样本位于原始bin坐标 i·getStep(level)
+     */
+    const std::vector<float>& getLevel(size_t level) const;
+
+    /**
+     * @brief 获取指定层的一阶导数响应（原始bin单位）
+     * @param level 层索引
+     * @return 一阶导数，长度与getLevel相同
+     */
+    const std::vector<float>& getFirstDerivative(size_t level) const;
+
+    /**
+     * @brief 获取指定层的二阶导数响应（原始bin单位）
+     * @param level 层索引
+     * @return 二阶导数，长度与getLevel相同
+     */
+    const std::vector<float>& getSecondDerivative(size_t level) const;
+
+    /**
+     * @brief 检测跨尺度稳定的波峰
+     * @param minLifetime 最短存在范围（倍频程），只在少数层出现的波峰视为噪声
+     * @param minResponse 最小尺度归一化响应（相对于所有波峰中的最大响应，0-1）
+     * @return 波峰列表，按响应从大到小排序
+     */
+    std::vector<Peak> findPeaks(float minLifetime = 1.0f, float minResponse = 0.05f) const;
+
+private:
+    struct Level {
+        float sigma;                    // 原始bin单位的sigma
+        size_t step;                    // 采样间隔
+        std::vector<float> values;      // 平滑结果
+        std::vector<float> first;       // 一阶导数
+        std::vector<float> second;      // 二阶导数
+    };
+
+    /**
+     * @brief 从已有的第0层开始逐层构建
+     */
+    void buildLevels();
+
+    /**
+     * @brief 准备第index层（复用已分配的缓冲区）
+     * @param index 层索引
+     * @param sigma 原始bin单位的sigma
+     * @param step 采样间隔
+     * @param size 样本数
+     * @return 该层
+     */
+    Level& prepareLevel(size_t index, float sigma, size_t step, size_t size);
+
+    /**
+     * @brief 获取有效的层，越界时抛出异常
+     * @param level 层索引
+     * @return 该层
+     */
+    const Level& levelAt(size_t level) const;
+
+    /**
+     * @brief 计算一层的一阶、二阶导数
+     * @param level 层
+     */
+    static void computeDerivatives(Level& level);
+
+    float minSigma_;                           // 最细层sigma
+    float maxSigma_;                           // 最粗层sigma上限
+    size_t levelsPerOctave_;                   // 每倍频程层数
+    bool downsample_;                          // 是否抽取
+    GaussianFilter baseFilter_;                // 第0层的滤波器
+    std::vector<GaussianFilter> stepFilters_;  // 倍频程内第m层相对上一层的增量滤波器（采样单位）
+    std::vector<Level> levels_;                // 各层（重复构建时复用）
+    size_t levelCount_;                        // 有效层数
+    std::vector<float> scratch_;               // 抽取前的滤波结果
+};
+
+} // namespace histogram
+
+#endif // SCALE_SPACE_HPP
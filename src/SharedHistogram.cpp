@@ -0,0 +1,315 @@
+#include "SharedHistogram.hpp"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace histogram {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x42485348; // "HSHB"
+constexpr uint32_t kFormatVersion = 1;
+// 代号保持同一个奇数值超过该时长时，认为执行clear()的进程已经崩溃
+constexpr std::chrono::milliseconds kClearTimeout(500);
+
+using Counter = std::atomic<uint64_t>;
+static_assert(Counter::is_always_lock_free, "shared counters must be lock-free");
+
+std::runtime_error systemError(const std::string& what, const std::string& name) {
+    return std::runtime_error(what + ": " + name + ": " + std::strerror(errno));
+}
+
+} // namespace
+
+/**
+ * @brief 共享内存头部，计数器数组紧随其后
+ */
+struct SharedHistogram::Header {
+    std::atomic<uint32_t> magic;    // 初始化完成后才写入
+    uint32_t version;               // 格式版本
+    float min;                      // 最小值
+    float max;                      // 最大值
+    uint64_t resolution;            // bin数量
+    Counter generation;             // 代号，清零期间为奇数
+    std::atomic<uint32_t> attached; // 附加的映射数
+    uint32_t reserved[7];
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == 4 && sizeof(Counter) == 8, "unexpected atomic layout");
+static_assert(sizeof(float) == 4, "unexpected float size");
+
+namespace {
+
+constexpr size_t kHeaderSize = 64;
+
+} // namespace
+
+SharedHistogram::SharedHistogram(std::string name, void* mapping, size_t mappingSize)
+    : name_(std::move(name)), mapping_(mapping), mappingSize_(mappingSize) {
+    static_assert(sizeof(Header) <= kHeaderSize, "header does not fit");
+    const Header* h = header();
+    resolution_ = static_cast<size_t>(h->resolution);
+    min_ = h->min;
+    max_ = h->max;
+    binWidth_ = (max_ - min_) / resolution_;
+}
+
+SharedHistogram SharedHistogram::create(const std::string& name, float min, float max, size_t resolution) {
+    if (min >= max) {
+        throw std::invalid_argument("min must be less than max");
+    }
+    if (resolution == 0) {
+        throw std::invalid_argument("resolution must be greater than 0");
+    }
+
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        throw systemError("Cannot create shared memory", name);
+    }
+    const size_t size = kHeaderSize + resolution * sizeof(Counter);
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        std::runtime_error error = systemError("Cannot resize shared memory", name);
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        throw error;
+    }
+    void* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::runtime_error error = systemError("Cannot map shared memory", name);
+        ::shm_unlink(name.c_str());
+        throw error;
+    }
+
+    // ftruncate得到的内存已清零；用placement new构造原子对象，最后发布魔数
+    Header* h = new (mapping) Header;
+    h->version = kFormatVersion;
+    h->min = min;
+    h->max = max;
+    h->resolution = resolution;
+    new (&h->generation) Counter(0);
+    new (&h->attached) std::atomic<uint32_t>(1);
+    Counter* counts = reinterpret_cast<Counter*>(static_cast<char*>(mapping) + kHeaderSize);
+    for (size_t i = 0; i < resolution; ++i) {
+        new (&counts[i]) Counter(0);
+    }
+    h->magic.store(kMagic, std::memory_order_release);
+    return SharedHistogram(name, mapping, size);
+}
+
+SharedHistogram SharedHistogram::attach(const std::string& name) {
+    int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        throw systemError("Cannot open shared memory", name);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        std::runtime_error error = systemError("Cannot stat shared memory", name);
+        ::close(fd);
+        throw error;
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    if (size < kHeaderSize) {
+        ::close(fd);
+        throw std::runtime_error("Shared histogram is not initialized: " + name);
+    }
+    void* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw systemError("Cannot map shared memory", name);
+    }
+
+    Header* h = static_cast<Header*>(mapping);
+    if (h->magic.load(std::memory_order_acquire) != kMagic || h->version != kFormatVersion ||
+        h->resolution == 0 || !(h->min < h->max) ||
+        h->resolution > (size - kHeaderSize) / sizeof(Counter)) {
+        ::munmap(mapping, size);
+        throw std::runtime_error("Invalid shared histogram: " + name);
+    }
+    h->attached.fetch_add(1, std::memory_order_relaxed);
+    return SharedHistogram(name, mapping, size);
+}
+
+bool SharedHistogram::unlink(const std::string& name) {
+    return ::shm_unlink(name.c_str()) == 0;
+}
+
+SharedHistogram::~SharedHistogram() {
+    detach();
+}
+
+SharedHistogram::SharedHistogram(SharedHistogram&& other) noexcept
+    : name_(std::move(other.name_)), mapping_(other.mapping_), mappingSize_(other.mappingSize_),
+      resolution_(other.resolution_), min_(other.min_), max_(other.max_), binWidth_(other.binWidth_) {
+    other.mapping_ = nullptr;
+    other.mappingSize_ = 0;
+}
+
+SharedHistogram& SharedHistogram::operator=(SharedHistogram&& other) noexcept {
+    if (this != &other) {
+        detach();
+        name_ = std::move(other.name_);
+        mapping_ = other.mapping_;
+        mappingSize_ = other.mappingSize_;
+        resolution_ = other.resolution_;
+        min_ = other.min_;
+        max_ = other.max_;
+        binWidth_ = other.binWidth_;
+        other.mapping_ = nullptr;
+        other.mappingSize_ = 0;
+    }
+    return *this;
+}
+
+void SharedHistogram::detach() {
+    if (mapping_ != nullptr) {
+        header()->attached.fetch_sub(1, std::memory_order_relaxed);
+        ::munmap(mapping_, mappingSize_);
+        mapping_ = nullptr;
+        mappingSize_ = 0;
+    }
+}
+
+SharedHistogram::Header* SharedHistogram::header() const {
+    if (mapping_ == nullptr) {
+        throw std::logic_error("SharedHistogram is detached");
+    }
+    return static_cast<Header*>(mapping_);
+}
+
+void SharedHistogram::addData(float value) {
+    // 与Histogram::getBinIndex的判断相同：max归入最后一个bin
+    if (!(value >= min_ && value <= max_)) {
+        return; // 超出范围或NaN
+    }
+    size_t binIndex = static_cast<size_t>((value - min_) / binWidth_);
+    if (binIndex >= resolution_) {
+        binIndex = resolution_ - 1;
+    }
+    addBinCount(binIndex, 1);
+}
+
+void SharedHistogram::addBinCount(size_t binIndex, size_t count) {
+    if (binIndex >= resolution_) {
+        throw std::out_of_range("binIndex out of range");
+    }
+    header();
+    Counter* counts = reinterpret_cast<Counter*>(static_cast<char*>(mapping_) + kHeaderSize);
+    counts[binIndex].fetch_add(count, std::memory_order_relaxed);
+}
+
+size_t SharedHistogram::getBinCount(size_t binIndex) const {
+    if (binIndex >= resolution_) {
+        throw std::out_of_range("binIndex out of range");
+    }
+    header();
+    const Counter* counts = reinterpret_cast<const Counter*>(static_cast<const char*>(mapping_) + kHeaderSize);
+    return static_cast<size_t>(counts[binIndex].load(std::memory_order_relaxed));
+}
+
+size_t SharedHistogram::getTotalCount() const {
+    header();
+    const Counter* counts = reinterpret_cast<const Counter*>(static_cast<const char*>(mapping_) + kHeaderSize);
+    uint64_t total = 0;
+    for (size_t i = 0; i < resolution_; ++i) {
+        total += counts[i].load(std::memory_order_relaxed);
+    }
+    return static_cast<size_t>(total);
+}
+
+uint64_t SharedHistogram::getGeneration() const {
+    return header()->generation.load(std::memory_order_acquire);
+}
+
+uint32_t SharedHistogram::getAttachedCount() const {
+    return header()->attached.load(std::memory_order_relaxed);
+}
+
+bool SharedHistogram::waitForEvenGeneration(uint64_t& generation) const {
+    const Header* h = header();
+    generation = h->generation.load(std::memory_order_acquire);
+    if ((generation & 1) == 0) {
+        return true;
+    }
+    // 同一个奇数代号持续超过kClearTimeout才算卡住；代号变化说明清零仍在推进，重新计时
+    uint64_t stuck = generation;
+    auto since = std::chrono::steady_clock::now();
+    for (;;) {
+        std::this_thread::yield();
+        generation = h->generation.load(std::memory_order_acquire);
+        if ((generation & 1) == 0) {
+            return true;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (generation != stuck) {
+            stuck = generation;
+            since = now;
+        } else if (now - since > kClearTimeout) {
+            return false;
+        }
+    }
+}
+
+Histogram SharedHistogram::snapshot() const {
+    const Header* h = header();
+    const Counter* counts = reinterpret_cast<const Counter*>(static_cast<const char*>(mapping_) + kHeaderSize);
+    Histogram hist(min_, max_, resolution_);
+    std::vector<size_t> values(resolution_);
+    for (;;) {
+        uint64_t before;
+        if (!waitForEvenGeneration(before)) {
+            throw std::runtime_error("SharedHistogram clear() did not finish (crashed writer?); call clear() to recover: " +
+                                     name_);
+        }
+        for (size_t i = 0; i < resolution_; ++i) {
+            values[i] = static_cast<size_t>(counts[i].load(std::memory_order_relaxed));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (h->generation.load(std::memory_order_relaxed) == before) {
+            break;
+        }
+    }
+    for (size_t i = 0; i < resolution_; ++i) {
+        if (values[i] > 0) {
+            hist.addBinCount(i, values[i]);
+        }
+    }
+    return hist;
+}
+
+void SharedHistogram::clear() {
+    Header* h = header();
+    Counter* counts = reinterpret_cast<Counter*>(static_cast<char*>(mapping_) + kHeaderSize);
+
+    // 用CAS把代号从偶数改为奇数，多个进程同时清零时依次进行；
+    // 代号卡在奇数（执行清零的进程崩溃）超过kClearTimeout时接管，完成那次清零
+    uint64_t generation;
+    for (;;) {
+        if (!waitForEvenGeneration(generation)) {
+            break; // 接管：generation为卡住的奇数代号
+        }
+        if (h->generation.compare_exchange_weak(generation, generation + 1, std::memory_order_relaxed)) {
+            ++generation;
+            break;
+        }
+    }
+    std::atomic_thread_fence(std::memory_order_release); // 清零的写入不能早于代号变为奇数
+    for (size_t i = 0; i < resolution_; ++i) {
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+    // 被接管的进程若只是过慢，它最后的CAS会失败，不会把代号改回奇数
+    h->generation.compare_exchange_strong(generation, generation + 1, std::memory_order_release,
+                                          std::memory_order_relaxed);
+}
+
+} // namespace histogram
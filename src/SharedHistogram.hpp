@@ -0,0 +1,177 @@
+#ifndef SHARED_HISTOGRAM_HPP
+#define SHARED_HISTOGRAM_HPP
+
+#include "Histogram.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace histogram {
+
+/**
+ * @brief 位于POSIX共享内存中、可被多个进程同时写入的直方图
+ *
+ * 共享内存对象由一个64字节的头部（魔数、版本、范围、bin数、代号、附加进程数）和
+ * 紧随其后的uint64原子计数器数组组成。每次写入只对一个计数器做relaxed的原子加法，不加锁（不单独维护总计数，避免每次写入两次原子操作）；读取方用snapshot()
+ * 复制为普通的Histogram。clear()会递增代号（清零期间代号为奇数），snapshot()在代号变化时重试，
+ * 因此快照不会混入清零前后的计数；读取方也可以比较代号来发现两次快照之间的清零。
+ *
+ * 进程崩溃：写入只有单次原子加法，崩溃不会留下不一致的状态。若进程在clear()中途崩溃，代号停在奇数，
+ * 同一个奇数代号持续超过500毫秒后，snapshot()抛出std::runtime_error而不是无限等待，
+ * 任一进程再调用clear()即可接管并完成那次清零。附加数由attach()/detach()维护，
+ * 崩溃的进程不会减少它，因此只作参考，不能用来判断是否还有写入者。
+ *
+ * 创建者在头部完全初始化之后才写入魔数，attach()只接受已初始化的对象。映射在detach()或析构时释放，
+ * 共享内存对象本身要由unlink()删除（已附加的进程仍可继续使用到解除映射为止）。
+ */
+class SharedHistogram {
+public:
+    /**
+     * @brief 创建新的共享内存直方图（同名对象已存在时抛出std::runtime_error）
+     * @param name 共享内存对象名（以'/'开头，如"/histogram"）
+     * @param min 最小值
+     * @param max 最大值
+     * @param resolution 分辨率（bin数量）
+     * @return 已附加的直方图
+     */
+    static SharedHistogram create(const std::string& name, float min, float max, size_t resolution);
+
+    /**
+     * @brief 附加到已存在的共享内存直方图
+     * @param name 共享内存对象名
+     * @return 已附加的直方图
+     */
+    static SharedHistogram attach(const std::string& name);
+
+    /**
+     * @brief 删除共享内存对象
+     * @param name 共享内存对象名
+     * @return 是否删除成功（对象不存在时返回false）
+     */
+    static bool unlink(const std::string& name);
+
+    ~SharedHistogram();
+
+    SharedHistogram(const SharedHistogram&) = delete;
+    SharedHistogram& operator=(const SharedHistogram&) = delete;
+    SharedHistogram(SharedHistogram&& other) noexcept;
+    SharedHistogram& operator=(SharedHistogram&& other) noexcept;
+
+    /**
+     * @brief 解除映射（可重复调用）；之后除isAttached外的操作均不可用
+     */
+    void detach();
+
+    /**
+     * @brief 是否仍附加在共享内存上
+     * @return 是否已附加
+     */
+    bool isAttached() const { return mapping_ != nullptr; }
+
+    /**
+     * @brief 添加数据点（超出范围时忽略）
+     * @param value 数据值
+     */
+    void addData(float value);
+
+    /**
+     * @brief 直接向指定bin累加计数
+     * @param binIndex bin索引
+     * @param count 累加的计数值
+     */
+    void addBinCount(size_t binIndex, size_t count);
+
+    /**
+     * @brief 获取指定bin当前的计数值
+     * @param binIndex bin索引
+     * @return bin的计数值
+     */
+    size_t getBinCount(size_t binIndex) const;
+
+    /**
+     * @brief 获取当前的总数据点数（对所有计数器求和，代价O(resolution)）
+     * @return 总数据点数
+     */
+    size_t getTotalCount() const;
+
+    /**
+     * @brief 获取代号（每次clear()递增2）
+     * @return 代号
+     */
+    uint64_t getGeneration() const;
+
+    /**
+     * @brief 获取当前附加的进程（映射）数（崩溃而未detach的进程仍被计入）
+     * @return 附加数
+     */
+    uint32_t getAttachedCount() const;
+
+    /**
+     * @brief 复制为普通直方图；与clear()并发时重试，直到复制期间代号不变
+     * @return 直方图快照
+     * @throws std::runtime_error 清零卡住（代号保持同一奇数值超过500毫秒，执行clear()的进程可能已崩溃）
+     */
+    Histogram snapshot() const;
+
+    /**
+     * @brief 清零所有计数并递增代号；多个进程同时调用时依次执行，
+     *        遇到崩溃进程留下的未完成清零（卡住超过500毫秒）时接管并完成它
+     */
+    void clear();
+
+    /**
+     * @brief 获取共享内存对象名
+     * @return 对象名
+     */
+    const std::string& getName() const { return name_; }
+
+    /**
+     * @brief 获取bin数量
+     * @return bin数量
+     */
+    size_t getResolution() const { return resolution_; }
+
+    /**
+     * @brief 获取最小值
+     * @return 最小值
+     */
+    float getMin() const { return min_; }
+
+    /**
+     * @brief 获取最大值
+     * @return 最大值
+     */
+    float getMax() const { return max_; }
+
+    /**
+     * @brief 获取bin宽度
+     * @return bin宽度
+     */
+    float getBinWidth() const { return binWidth_; }
+
+private:
+    struct Header;
+
+    SharedHistogram(std::string name, void* mapping, size_t mappingSize);
+
+    Header* header() const;
+
+    /**
+     * @brief 等待代号变为偶数（没有进行中的清零）
+     * @param generation 输出最后读到的代号
+     * @return 是否等到；同一个奇数代号持续超过超时时长时返回false
+     */
+    bool waitForEvenGeneration(uint64_t& generation) const;
+
+    std::string name_;   // 共享内存对象名
+    void* mapping_;      // 映射起始地址
+    size_t mappingSize_; // 映射字节数
+    size_t resolution_;  // bin数量
+    float min_;          // 最小值
+    float max_;          // 最大值
+    float binWidth_;     // bin宽度
+};
+
+} // namespace histogram
+
+#endif // SHARED_HISTOGRAM_HPP
@@ -0,0 +1,324 @@
+#include "TDigest.hpp"
+#include "ByteIO.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace histogram {
+
+namespace {
+
+const char kMagic[4] = {'T', 'D', 'G', '1'};
+constexpr float kMaxSerializedCompression = 1e5f; // 反序列化接受的最大压缩参数，限制缓冲区大小
+constexpr double kPi = 3.14159265358979323846;
+
+/**
+ * @brief 分段线性的累计分布节点
+ *
+ * 节点依次为(min, 0)、每个质心的(均值, 质心中点处的累计权重)以及(max, 总权重)，
+ * 累计概率和分位数分别是该折线及其反函数。
+ */
+struct Knots {
+    std::vector<double> x;   // 节点位置（单调不减）
+    std::vector<double> pos; // 节点累计权重（严格递增）
+};
+
+template <typename Centroid>
+Knots buildKnots(const std::vector<Centroid>& centroids, float minValue, float maxValue) {
+    Knots knots;
+    knots.x.reserve(centroids.size() + 2);
+    knots.pos.reserve(centroids.size() + 2);
+
+    knots.x.push_back(minValue);
+    knots.pos.push_back(0.0);
+    double cumulative = 0.0;
+    for (const auto& c : centroids) {
+        knots.x.push_back(std::min(std::max(c.mean, static_cast<double>(minValue)),
+                                   static_cast<double>(maxValue)));
+        knots.pos.push_back(cumulative + c.weight / 2.0);
+        cumulative += c.weight;
+    }
+    knots.x.push_back(maxValue);
+    knots.pos.push_back(cumulative);
+    return knots;
+}
+
+/**
+ * @brief 在节点折线上求x处的累计权重
+ */
+double interpolatePosition(const Knots& knots, double x) {
+    if (x < knots.x.front()) {
+        return 0.0;
+    }
+    if (x >= knots.x.back()) {
+        return knots.pos.back();
+    }
+    size_t k = std::upper_bound(knots.x.begin(), knots.x.end(), x) - knots.x.begin();
+    double fraction = (x - knots.x[k - 1]) / (knots.x[k] - knots.x[k - 1]);
+    return knots.pos[k - 1] + fraction * (knots.pos[k] - knots.pos[k - 1]);
+}
+
+/**
+ * @brief 在节点折线上求累计权重target处的x（反函数）
+ */
+double interpolateValue(const Knots& knots, double target) {
+    if (target <= 0.0) {
+        return knots.x.front();
+    }
+    if (target >= knots.pos.back()) {
+        return knots.x.back();
+    }
+    size_t k = std::upper_bound(knots.pos.begin(), knots.pos.end(), target) - knots.pos.begin();
+    double fraction = (target - knots.pos[k - 1]) / (knots.pos[k] - knots.pos[k - 1]);
+    return knots.x[k - 1] + fraction * (knots.x[k] - knots.x[k - 1]);
+}
+
+} // namespace
+
+TDigest::TDigest(float compression)
+    : compression_(compression), totalCount_(0), min_(0.0f), max_(0.0f) {
+    if (!(compression >= 10.0f)) {
+        throw std::invalid_argument("compression must be at least 10");
+    }
+    bufferCapacity_ = static_cast<size_t>(compression * 5);
+    buffer_.reserve(bufferCapacity_);
+}
+
+void TDigest::add(float value) {
+    add(&value, 1);
+}
+
+void TDigest::add(const float* values, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        float value = values[i];
+        if (!std::isfinite(value)) {
+            continue; // NaN和±inf会使min/max和质心失去意义
+        }
+        if (totalCount_ == 0) {
+            min_ = value;
+            max_ = value;
+        } else {
+            min_ = std::min(min_, value);
+            max_ = std::max(max_, value);
+        }
+        ++totalCount_;
+        buffer_.push_back({value, 1.0});
+        if (buffer_.size() >= bufferCapacity_) {
+            compress();
+        }
+    }
+}
+
+void TDigest::merge(const TDigest& other) {
+    if (other.totalCount_ == 0) {
+        return;
+    }
+    other.compress();
+
+    if (totalCount_ == 0) {
+        min_ = other.min_;
+        max_ = other.max_;
+    } else {
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+    totalCount_ += other.totalCount_;
+    addCentroids(other.centroids_);
+}
+
+void TDigest::addCentroids(const std::vector<Centroid>& centroids) {
+    for (const auto& c : centroids) {
+        buffer_.push_back(c);
+        if (buffer_.size() >= bufferCapacity_) {
+            compress();
+        }
+    }
+    compress();
+}
+
+void TDigest::compress() const {
+    if (buffer_.empty()) {
+        return;
+    }
+
+    buffer_.insert(buffer_.end(), centroids_.begin(), centroids_.end());
+    std::sort(buffer_.begin(), buffer_.end(), [](const Centroid& a, const Centroid& b) {
+        return a.mean < b.mean;
+    });
+
+    double total = 0.0;
+    for (const auto& c : buffer_) {
+        total += c.weight;
+    }
+
+    // k1尺度函数：k(q) = δ/(2π)·asin(2q-1)，每个质心覆盖的k增量不超过1
+    const double scale = compression_ / (2.0 * kPi);
+    auto kOf = [scale](double q) { return scale * std::asin(2.0 * q - 1.0); };
+    auto qOf = [scale](double k) {
+        double angle = std::min(std::max(k / scale, -kPi / 2), kPi / 2);
+        return (std::sin(angle) + 1.0) / 2.0;
+    };
+
+    std::vector<Centroid> merged;
+    merged.reserve(static_cast<size_t>(compression_) * 2);
+
+    Centroid current = buffer_[0];
+    double weightSoFar = 0.0;
+    double limit = total * qOf(kOf(0.0) + 1.0);
+    for (size_t i = 1; i < buffer_.size(); ++i) {
+        const Centroid& next = buffer_[i];
+        if (weightSoFar + current.weight + next.weight <= limit) {
+            current.weight += next.weight;
+            current.mean += (next.mean - current.mean) * next.weight / current.weight;
+        } else {
+            weightSoFar += current.weight;
+            merged.push_back(current);
+            limit = total * qOf(kOf(weightSoFar / total) + 1.0);
+            current = next;
+        }
+    }
+    merged.push_back(current);
+
+    centroids_ = std::move(merged);
+    buffer_.clear();
+}
+
+float TDigest::getPercentile(float percentile) const {
+    if (percentile < 0.0f || percentile > 100.0f) {
+        throw std::invalid_argument("Percentile must be between 0 and 100");
+    }
+    if (totalCount_ == 0) {
+        throw std::runtime_error("TDigest has no data");
+    }
+
+    compress();
+    Knots knots = buildKnots(centroids_, min_, max_);
+    return static_cast<float>(interpolateValue(knots, percentile / 100.0 * knots.pos.back()));
+}
+
+float TDigest::getCumulativeProbability(float value) const {
+    if (totalCount_ == 0) {
+        throw std::runtime_error("TDigest has no data");
+    }
+
+    compress();
+    Knots knots = buildKnots(centroids_, min_, max_);
+    return static_cast<float>(interpolatePosition(knots, value) / knots.pos.back());
+}
+
+size_t TDigest::getCentroidCount() const {
+    compress();
+    return centroids_.size();
+}
+
+Histogram TDigest::toHistogram(size_t resolution) const {
+    if (totalCount_ == 0) {
+        throw std::runtime_error("TDigest has no data");
+    }
+
+    // 所有数据相同时扩展一个很小的范围，并把全部计数放进第一个bin
+    if (!(max_ > min_)) {
+        float width = std::max(std::abs(min_) * 1e-6f, 1e-6f);
+        Histogram hist(min_, min_ + width, resolution);
+        hist.addBinCount(0, totalCount_);
+        return hist;
+    }
+
+    compress();
+    Knots knots = buildKnots(centroids_, min_, max_);
+    const double total = knots.pos.back();
+
+    // 按bin边界的累计计数差分得到每个bin的计数，保证总数与草图一致
+    Histogram hist(min_, max_, resolution);
+    const float binWidth = hist.getBinWidth();
+    size_t previous = 0;
+    for (size_t k = 0; k < resolution; ++k) {
+        size_t cumulative = totalCount_;
+        if (k + 1 < resolution) {
+            float edge = min_ + (k + 1) * binWidth;
+            double fraction = interpolatePosition(knots, edge) / total;
+            cumulative = static_cast<size_t>(std::llround(fraction * static_cast<double>(totalCount_)));
+            cumulative = std::min(std::max(cumulative, previous), totalCount_);
+        }
+        if (cumulative > previous) {
+            hist.addBinCount(k, cumulative - previous);
+        }
+        previous = cumulative;
+    }
+    return hist;
+}
+
+CDF TDigest::toCDF(size_t resolution) const {
+    CDF cdf;
+    cdf.computeFromHistogram(toHistogram(resolution));
+    return cdf;
+}
+
+void TDigest::serialize(std::string& output) const {
+    compress();
+
+    output.append(kMagic, sizeof(kMagic));
+    detail::appendLittleEndian(output, compression_);
+    detail::appendLittleEndian(output, min_);
+    detail::appendLittleEndian(output, max_);
+    detail::appendLittleEndian(output, static_cast<uint64_t>(totalCount_));
+    detail::appendLittleEndian(output, static_cast<uint32_t>(centroids_.size()));
+    for (const auto& c : centroids_) {
+        detail::appendLittleEndian(output, c.mean);
+        detail::appendLittleEndian(output, c.weight);
+    }
+}
+
+TDigest TDigest::deserialize(const char* data, size_t size) {
+    detail::ByteReader reader(data, size);
+    if (!std::equal(kMagic, kMagic + sizeof(kMagic), reader.readBytes(sizeof(kMagic)))) {
+        throw std::runtime_error("Invalid TDigest data");
+    }
+
+    // 先校验头部再构造：非有限或过大的压缩参数会使缓冲区容量的转换溢出
+    float compression = reader.readLittleEndian<float>();
+    if (!(compression >= 10.0f && compression <= kMaxSerializedCompression)) {
+        throw std::runtime_error("Invalid TDigest data: compression out of range");
+    }
+    TDigest digest(compression);
+    digest.min_ = reader.readLittleEndian<float>();
+    digest.max_ = reader.readLittleEndian<float>();
+    uint64_t totalCount = reader.readLittleEndian<uint64_t>();
+    uint32_t centroidCount = reader.readLittleEndian<uint32_t>();
+    if (reader.remaining() != static_cast<size_t>(centroidCount) * 2 * sizeof(double)) {
+        throw std::runtime_error("Invalid TDigest data");
+    }
+    if (!std::isfinite(digest.min_) || !std::isfinite(digest.max_) || digest.min_ > digest.max_ ||
+        (centroidCount == 0) != (totalCount == 0)) {
+        throw std::runtime_error("Invalid TDigest data: inconsistent header");
+    }
+
+    // 质心均值有限且非递减，权重有限且为正，权重之和等于总数据点数
+    digest.centroids_.resize(centroidCount);
+    double weightSum = 0.0;
+    for (size_t i = 0; i < digest.centroids_.size(); ++i) {
+        auto& c = digest.centroids_[i];
+        c.mean = reader.readLittleEndian<double>();
+        c.weight = reader.readLittleEndian<double>();
+        if (!std::isfinite(c.mean) || !std::isfinite(c.weight) || !(c.weight > 0.0) ||
+            (i > 0 && c.mean < digest.centroids_[i - 1].mean)) {
+            throw std::runtime_error("Invalid TDigest data: malformed centroid");
+        }
+        weightSum += c.weight;
+    }
+    if (std::abs(weightSum - static_cast<double>(totalCount)) > 0.5) {
+        throw std::runtime_error("Invalid TDigest data: centroid weights do not match total count");
+    }
+    digest.totalCount_ = static_cast<size_t>(totalCount);
+    return digest;
+}
+
+void TDigest::clear() {
+    centroids_.clear();
+    buffer_.clear();
+    totalCount_ = 0;
+    min_ = 0.0f;
+    max_ = 0.0f;
+}
+
+} // namespace histogram
@@ -0,0 +1,154 @@
+#ifndef TDIGEST_HPP
+#define TDIGEST_HPP
+
+#include "Histogram.hpp"
+#include "CDF.hpp"
+#include <string>
+#include <vector>
+
+namespace histogram {
+
+/**
+ * @brief 可合并的t-digest分位数草图
+ *
+ * 不需要预先知道数据范围，内存占用只与压缩参数有关（默认约几KB），
+ * 对尾部分位数精度较高。支持批量写入、跨线程合并以及序列化后跨进程合并，
+ * 并可在观测范围上转换为Histogram/CDF以复用波峰检测和SVG导出。
+ *
+ * 查询会先合并缓冲区中的数据，因此同一对象不能在多个线程间并发访问。
+ */
+class TDigest {
+public:
+    /**
+     * @brief 构造函数
+     * @param compression 压缩参数，越大越精确，质心数量约为该值的一半
+     */
+    explicit TDigest(float compression = 100.0f);
+
+    /**
+     * @brief 添加单个数据点（NaN和±inf会被忽略）
+     * @param value 数据值
+     */
+    void add(float value);
+
+    /**
+     * @brief 批量添加数据点（NaN和±inf会被忽略）
+     * @param values 数据数组
+     * @param count 数据个数
+     */
+    void add(const float* values, size_t count);
+
+    /**
+     * @brief 合并另一个草图
+     * @param other 另一个草图
+     */
+    void merge(const TDigest& other);
+
+    /**
+     * @brief 将缓冲区中的数据压缩进质心
+     */
+    void compress() const;
+
+    /**
+     * @brief 获取指定百分位的值
+     * @param percentile 百分位 [0, 100]
+     * @return 对应的数据值
+     */
+    float getPercentile(float percentile) const;
+
+    /**
+     * @brief 获取指定值的累计概率
+     * @param value 数据值
+     * @return 累计概率 [0, 1]
+     */
+    float getCumulativeProbability(float value) const;
+
+    /**
+     * @brief 获取总数据点数
+     * @return 总数据点数
+     */
+    size_t getTotalCount() const { return totalCount_; }
+
+    /**
+     * @brief 获取观测到的最小值
+     * @return 最小值
+     */
+    float getMin() const { return min_; }
+
+    /**
+     * @brief 获取观测到的最大值
+     * @return 最大值
+     */
+    float getMax() const { return max_; }
+
+    /**
+     * @brief 获取压缩参数
+     * @return 压缩参数
+     */
+    float getCompression() const { return compression_; }
+
+    /**
+     * @brief 获取质心数量
+     * @return 质心数量
+     */
+    size_t getCentroidCount() const;
+
+    /**
+     * @brief 在观测范围[min, max]上生成直方图
+     * @param resolution 分辨率（bin数量）
+     * @return 直方图，总计数与草图一致
+     */
+    Histogram toHistogram(size_t resolution) const;
+
+    /**
+     * @brief 在观测范围[min, max]上生成CDF
+     * @param resolution 分辨率（bin数量）
+     * @return CDF对象
+     */
+    CDF toCDF(size_t resolution) const;
+
+    /**
+     * @brief 序列化为二进制数据（追加到output）
+     * @param output 输出字符串
+     */
+    void serialize(std::string& output) const;
+
+    /**
+     * @brief 从二进制数据反序列化
+     * @param data 数据指针
+     * @param size 数据字节数
+     * @return 草图对象
+     * @throws std::runtime_error 数据截断、压缩参数超出[10, 1e5]、min > max、
+     *         质心均值或权重非有限、权重非正、均值未排序或权重之和与总数据点数不符
+     */
+    static TDigest deserialize(const char* data, size_t size);
+
+    /**
+     * @brief 清除所有数据
+     */
+    void clear();
+
+private:
+    struct Centroid {
+        double mean;   // 质心均值
+        double weight; // 质心权重
+    };
+
+    /**
+     * @brief 将带权重的质心加入缓冲区
+     * @param centroids 质心
+     */
+    void addCentroids(const std::vector<Centroid>& centroids);
+
+    float compression_;                       // 压缩参数
+    size_t bufferCapacity_;                   // 缓冲区容量
+    size_t totalCount_;                       // 总数据点数
+    float min_;                               // 观测最小值
+    float max_;                               // 观测最大值
+    mutable std::vector<Centroid> centroids_; // 已合并的质心（按均值排序）
+    mutable std::vector<Centroid> buffer_;    // 待合并的数据
+};
+
+} // namespace histogram
+
+#endif // TDIGEST_HPP
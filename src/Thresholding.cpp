@@ -0,0 +1,171 @@
+#include "Thresholding.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+namespace histogram {
+
+Thresholding::Thresholding(const Histogram& hist)
+    : resolution_(hist.getResolution()), min_(hist.getMin()), binWidth_(hist.getBinWidth()) {
+    cdf_.computeFromHistogram(hist, moments_);
+}
+
+double Thresholding::classScore(size_t begin, size_t end) const {
+    const double weight = moments_.counts[end] - moments_.counts[begin];
+    const double moment = moments_.moments[end] - moments_.moments[begin];
+    return weight > 0.0 ? moment * moment / weight : 0.0;
+}
+
+double Thresholding::classEntropy(size_t begin, size_t end) const {
+    // -Σ (c/w)·ln(c/w) = ln w - Σ c·ln c / w
+    const double weight = moments_.counts[end] - moments_.counts[begin];
+    const double entropy = moments_.entropy[end] - moments_.entropy[begin];
+    return weight > 0.0 ? std::log(weight) - entropy / weight : 0.0;
+}
+
+size_t Thresholding::otsu() const {
+    if (resolution_ < 2) {
+        throw std::invalid_argument("Thresholding requires at least 2 bins");
+    }
+    // 总均值固定时，最大化类间方差等价于最大化 Σ m²/w
+    size_t best = 1;
+    double bestScore = -1.0;
+    for (size_t t = 1; t < resolution_; ++t) {
+        const double score = classScore(0, t) + classScore(t, resolution_);
+        if (score > bestScore) {
+            bestScore = score;
+            best = t;
+        }
+    }
+    return best;
+}
+
+std::vector<size_t> Thresholding::multiOtsu(size_t count) const {
+    if (count == 0 || count >= resolution_) {
+        throw std::invalid_argument("Threshold count must be in [1, resolution - 1]");
+    }
+    const size_t n = resolution_;
+
+    // previous[i]：把[0, i)分为c类的最优得分；choice[c][j]：把[0, j)分为c+1类时最后一类的起点
+    const double none = -std::numeric_limits<double>::infinity();
+    std::vector<double> previous(n + 1, none);
+    std::vector<double> current(n + 1, none);
+    std::vector<std::vector<uint32_t>> choice(count + 1, std::vector<uint32_t>(n + 1, 0));
+    for (size_t j = 1; j <= n; ++j) {
+        previous[j] = classScore(0, j);
+    }
+
+    struct Range {
+        size_t lo, hi;       // 待求的右端点区间[lo, hi]
+        size_t optLo, optHi; // 最优起点的搜索区间
+    };
+    std::vector<Range> stack;
+    for (size_t c = 1; c <= count; ++c) {
+        // c+1类至少需要c+1个bin；最后一层只需要右端点n
+        const size_t jLo = c + 1;
+        const size_t jHi = n - (count - c);
+        std::fill(current.begin(), current.end(), none);
+        std::vector<uint32_t>& argmax = choice[c];
+
+        stack.push_back({jLo, jHi, c, jHi - 1});
+        while (!stack.empty()) {
+            Range range = stack.back();
+            stack.pop_back();
+            const size_t j = range.lo + (range.hi - range.lo) / 2;
+            size_t bestStart = range.optLo;
+            double bestScore = none;
+            const size_t last = std::min(range.optHi, j - 1);
+            for (size_t i = range.optLo; i <= last; ++i) {
+                const double score = previous[i] + classScore(i, j);
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestStart = i;
+                }
+            }
+            current[j] = bestScore;
+            argmax[j] = static_cast<uint32_t>(bestStart);
+            if (range.lo < j) {
+                stack.push_back({range.lo, j - 1, range.optLo, bestStart});
+            }
+            if (j < range.hi) {
+                stack.push_back({j + 1, range.hi, bestStart, range.optHi});
+            }
+        }
+        std::swap(previous, current);
+    }
+
+    std::vector<size_t> thresholds(count);
+    size_t end = n;
+    for (size_t c = count; c >= 1; --c) {
+        end = choice[c][end];
+        thresholds[c - 1] = end;
+    }
+    return thresholds;
+}
+
+size_t Thresholding::kapur() const {
+    if (resolution_ < 2) {
+        throw std::invalid_argument("Thresholding requires at least 2 bins");
+    }
+    size_t best = 1;
+    double bestScore = -std::numeric_limits<double>::infinity();
+    for (size_t t = 1; t < resolution_; ++t) {
+        const double score = classEntropy(0, t) + classEntropy(t, resolution_);
+        if (score > bestScore) {
+            bestScore = score;
+            best = t;
+        }
+    }
+    return best;
+}
+
+size_t Thresholding::triangle() const {
+    if (resolution_ < 2) {
+        throw std::invalid_argument("Thresholding requires at least 2 bins");
+    }
+    auto countAt = [this](size_t i) { return moments_.counts[i + 1] - moments_.counts[i]; };
+
+    size_t peak = 0;
+    size_t first = resolution_;
+    size_t last = 0;
+    for (size_t i = 0; i < resolution_; ++i) {
+        const double c = countAt(i);
+        if (c > 0.0) {
+            first = std::min(first, i);
+            last = i;
+        }
+        if (c > countAt(peak)) {
+            peak = i;
+        }
+    }
+
+    // 连线的另一端取拖尾最后一个非零bin之外的位置；到连线的垂直距离正比于 H·|e-i| - |e-p|·c_i
+    const bool rightTail = last - peak >= peak - first;
+    const double height = countAt(peak);
+    const double end = rightTail ? static_cast<double>(last) + 1.0 : static_cast<double>(first) - 1.0;
+    const double span = std::abs(end - static_cast<double>(peak));
+    const size_t begin = rightTail ? peak + 1 : first;
+    const size_t stop = rightTail ? last + 1 : peak;
+
+    size_t best = rightTail ? std::min(peak + 1, resolution_ - 1) : peak;
+    double bestDistance = -std::numeric_limits<double>::infinity();
+    for (size_t i = begin; i < stop; ++i) {
+        const double distance = height * std::abs(end - static_cast<double>(i)) - span * countAt(i);
+        if (distance > bestDistance) {
+            bestDistance = distance;
+            best = rightTail ? i : i + 1;
+        }
+    }
+    return std::max<size_t>(best, 1);
+}
+
+float Thresholding::getThresholdValue(size_t threshold) const {
+    if (threshold > resolution_) {
+        throw std::out_of_range("Threshold out of range");
+    }
+    return min_ + static_cast<float>(threshold) * binWidth_;
+}
+
+} // namespace histogram
@@ -0,0 +1,99 @@
+#ifndef THRESHOLDING_HPP
+#define THRESHOLDING_HPP
+
+#include "Histogram.hpp"
+#include "CDF.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace histogram {
+
+/**
+ * @brief 基于直方图的全局阈值算法：Otsu、多级Otsu、Kapur最大熵和三角法
+ *
+ * 构造时在计算CDF的同一遍扫描中求出计数、一阶矩和熵项的累计表，之后任意bin区间的
+ * 类内统计量都是两项之差。Otsu、Kapur和三角法为O(L)；K个阈值的多级Otsu用动态规划，
+ * 区间代价满足四边形不等式，最优划分点随右端点单调，按分治求每层，代价O(K·L·log L)。
+ *
+ * 阈值以bin索引t表示：索引小于t的bin属于较低的类，对应的数据值为第t个bin的下边界
+ * （见getThresholdValue）。相同得分时取较小的t。
+ */
+class Thresholding {
+public:
+    /**
+     * @brief 构造函数，计算CDF和累计矩表
+     * @param hist 直方图（不能为空）
+     */
+    explicit Thresholding(const Histogram& hist);
+
+    /**
+     * @brief Otsu阈值：最大化类间方差
+     * @return 阈值bin索引，范围[1, L-1]
+     */
+    size_t otsu() const;
+
+    /**
+     * @brief 多级Otsu阈值：把直方图分为count+1类，最大化类间方差
+     * @param count 阈值个数K（1 ≤ K < L）
+     * @return 严格递增的K个阈值bin索引
+     */
+    std::vector<size_t> multiOtsu(size_t count) const;
+
+    /**
+     * @brief Kapur阈值：最大化前景和背景的熵之和
+     * @return 阈值bin索引，范围[1, L-1]
+     */
+    size_t kapur() const;
+
+    /**
+     * @brief 三角法阈值：在最高bin与较长一侧拖尾末端的连线上，取离直方图最远的bin，该bin归入拖尾一侧
+     * @return 阈值bin索引，范围[1, L-1]
+     */
+    size_t triangle() const;
+
+    /**
+     * @brief 把阈值bin索引换算为数据值
+     * @param threshold 阈值bin索引
+     * @return 第threshold个bin的下边界
+     */
+    float getThresholdValue(size_t threshold) const;
+
+    /**
+     * @brief 获取同一遍扫描得到的CDF
+     * @return CDF
+     */
+    const CDF& getCDF() const { return cdf_; }
+
+    /**
+     * @brief 获取累计矩表
+     * @return 累计矩表
+     */
+    const CumulativeMoments& getMoments() const { return moments_; }
+
+    /**
+     * @brief 获取bin数量
+     * @return bin数量
+     */
+    size_t getResolution() const { return resolution_; }
+
+private:
+    /**
+     * @brief bin区间[begin, end)对类间方差的贡献 (Σ j·c_j)² / Σ c_j，空区间为0
+     */
+    double classScore(size_t begin, size_t end) const;
+
+    /**
+     * @brief bin区间[begin, end)内归一化分布的熵，空区间为0
+     */
+    double classEntropy(size_t begin, size_t end) const;
+
+    CDF cdf_;                   // 累计分布
+    CumulativeMoments moments_; // 累计矩表
+    size_t resolution_;         // bin数量
+    float min_;                 // 最小值
+    float binWidth_;            // bin宽度
+};
+
+} // namespace histogram
+
+#endif // THRESHOLDING_HPP
@@ -0,0 +1,86 @@
+# histogram-cli的端到端测试，由ctest以 cmake -P 运行
+# 参数：CLI为可执行文件路径，WORK_DIR为临时目录
+
+if(NOT CLI OR NOT WORK_DIR)
+    message(FATAL_ERROR "Usage: cmake -DCLI=<histogram-cli> -DWORK_DIR=<dir> -P test_cli.cmake")
+endif()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+# 运行CLI，返回码、标准输出和标准错误分别写入<prefix>_code、<prefix>_out、<prefix>_err；
+# INPUT指定重定向到标准输入的文件
+function(run_cli prefix)
+    cmake_parse_arguments(RUN "" "INPUT" "ARGS" ${ARGN})
+    set(input)
+    if(RUN_INPUT)
+        set(input INPUT_FILE "${RUN_INPUT}")
+    endif()
+    execute_process(COMMAND "${CLI}" ${RUN_ARGS} ${input}
+                    RESULT_VARIABLE code OUTPUT_VARIABLE out ERROR_VARIABLE err)
+    set(${prefix}_code "${code}" PARENT_SCOPE)
+    set(${prefix}_out "${out}" PARENT_SCOPE)
+    set(${prefix}_err "${err}" PARENT_SCOPE)
+endfunction()
+
+function(expect_equal actual expected what)
+    if(NOT "${actual}" STREQUAL "${expected}")
+        message(FATAL_ERROR "${what}: expected '${expected}', got '${actual}'")
+    endif()
+endfunction()
+
+function(expect_match text pattern what)
+    if(NOT "${text}" MATCHES "${pattern}")
+        message(FATAL_ERROR "${what}: '${text}' does not match '${pattern}'")
+    endif()
+endfunction()
+
+# 3000行CSV，其中几行带一个比读块更长的字段，使记录跨越块边界并触发块加倍
+set(padding "")
+foreach(i RANGE 1 200)
+    string(APPEND padding "x")
+endforeach()
+set(values "")
+foreach(i RANGE 1 3000)
+    math(EXPR whole "${i} % 97")
+    if(i EQUAL 1 OR i EQUAL 500 OR i EQUAL 1000 OR i EQUAL 2500)
+        string(APPEND values "${whole}.25,${padding}\n")
+    else()
+        string(APPEND values "${whole}.25\n")
+    endif()
+endforeach()
+set(input "${WORK_DIR}/values.csv")
+file(WRITE "${input}" "${values}")
+
+# 标准输入按64字节分块流式读入，结果与一次读入整个文件相同
+set(common --min 0 --max 100 --bins 50 --csv -)
+run_cli(file ARGS ${common} "${input}")
+expect_equal("${file_code}" "0" "file input exit code")
+foreach(block 64 1000 65536)
+    run_cli(stdin ARGS ${common} --block-size ${block} INPUT "${input}")
+    expect_equal("${stdin_code}" "0" "stdin exit code (block ${block})")
+    expect_equal("${stdin_out}" "${file_out}" "stdin CSV (block ${block})")
+endforeach()
+run_cli(summary ARGS --min 0 --max 100 --bins 50 --block-size 64 INPUT "${input}")
+expect_match("${summary_out}" "count 3000\n" "stdin value count")
+
+# 合并：几何一致时计数相加，不一致时无论在线程内还是线程间合并都报错
+run_cli(coarse ARGS --min 0 --max 100 --bins 10 --binary "${WORK_DIR}/coarse.bin" "${input}")
+run_cli(fine ARGS --min 0 --max 100 --bins 20 --binary "${WORK_DIR}/fine.bin" "${input}")
+expect_equal("${coarse_code}${fine_code}" "00" "binary output exit codes")
+run_cli(merged ARGS --merge "${WORK_DIR}/coarse.bin" "${WORK_DIR}/coarse.bin")
+expect_equal("${merged_code}" "0" "merge exit code")
+expect_match("${merged_out}" "count 6000\n" "merged count")
+foreach(threads 1 2)
+    run_cli(mismatch ARGS --merge --threads ${threads} "${WORK_DIR}/coarse.bin" "${WORK_DIR}/fine.bin")
+    expect_equal("${mismatch_code}" "1" "mismatched merge exit code (threads ${threads})")
+    expect_match("${mismatch_err}" "different range or resolution" "mismatched merge error (threads ${threads})")
+endforeach()
+
+# 参数错误：无符号参数不接受负数
+foreach(option --bins --column --threads --block-size)
+    run_cli(negative ARGS ${option} -1 "${input}")
+    expect_equal("${negative_code}" "2" "${option} -1 exit code")
+endforeach()
+run_cli(zero ARGS --block-size 0 "${input}")
+expect_equal("${zero_code}" "2" "--block-size 0 exit code")
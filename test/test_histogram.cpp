@@ -3,9 +3,45 @@
 #include "CDF.hpp"
 #include "GaussianFilter.hpp"
 #include "SVGExporter.hpp"
+#include "HistogramTransform.hpp"
+#include "CSVExporter.hpp"
+#include "TDigest.hpp"
+#include "FFTConvolver.hpp"
+#include "ScaleSpace.hpp"
+#include "PeakFinder.hpp"
+#include "PeakTracker.hpp"
+#include "PeakRefiner.hpp"
+#include "GaussianMixture.hpp"
+#include "Thresholding.hpp"
+#ifdef HISTOGRAM_HAS_POSIX
+#include "MappedHistogram.hpp"
+#include "SharedHistogram.hpp"
+#include "Ingestor.hpp"
+#endif
+#include "OpenMetricsExporter.hpp"
+#include "CompactHistogram.hpp"
 #include <vector>
 #include <random>
+#include <iostream>
 #include <tuple>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <set>
+#include <limits>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+#include <atomic>
+#ifdef HISTOGRAM_HAS_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #if __has_include(<filesystem>)
 #include <filesystem>
@@ -256,6 +292,1828 @@ TEST_F(HistogramTest, PeakDetectionSVGExport) {
     EXPECT_TRUE(fs::exists("test_output/histogram_with_peaks.svg"));
 }
 
+// 测试批量累计概率计算
+TEST_F(HistogramTest, BatchCumulativeProbabilities) {
+    histogram::Histogram hist(-5.0f, 5.0f, 97);
+    std::mt19937 gen(2024);
+    std::normal_distribution<float> dist(0.0f, 1.5f);
+    for (int i = 0; i < 5000; ++i) {
+        hist.addData(dist(gen));
+    }
+
+    histogram::CDF cdf;
+    cdf.computeFromHistogram(hist);
+
+    // 包含范围外的数据和边界值，长度超过并行分块阈值
+    std::uniform_real_distribution<float> uniform(-6.0f, 6.0f);
+    std::vector<float> values(200003);
+    for (auto& v : values) {
+        v = uniform(gen);
+    }
+    values[0] = -5.0f;
+    values[1] = 5.0f;
+    values[2] = 4.9999f;
+
+    std::vector<float> probs(values.size());
+    cdf.getCumulativeProbabilities(values.data(), probs.data(), values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(probs[i], cdf.getCumulativeProbability(values[i])) << "index " << i;
+    }
+
+    // 插值结果应单调，且在bin边界处与阶梯CDF吻合
+    std::vector<float> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<float> interp(sorted.size());
+    cdf.getCumulativeProbabilities(sorted.data(), interp.data(), sorted.size(), true, 4);
+    for (size_t i = 1; i < interp.size(); ++i) {
+        ASSERT_LE(interp[i - 1], interp[i] + 1e-6f);
+    }
+
+    const auto& cdfValues = cdf.getCDFValues();
+    std::vector<float> edges;
+    for (size_t i = 0; i < hist.getResolution(); ++i) {
+        auto range = hist.getBinRange(i);
+        edges.push_back(range.first + 0.999f * (range.second - range.first));
+    }
+    std::vector<float> edgeProbs(edges.size());
+    cdf.getCumulativeProbabilities(edges.data(), edgeProbs.data(), edges.size(), true);
+    for (size_t i = 0; i < edges.size(); ++i) {
+        EXPECT_NEAR(edgeProbs[i], cdfValues[i], 1e-3f);
+    }
+
+    histogram::CDF empty;
+    float v = 0.0f, p = 0.0f;
+    EXPECT_THROW(empty.getCumulativeProbabilities(&v, &p, 1), std::runtime_error);
+}
+
+// 测试直方图均衡化与直方图匹配
+TEST_F(HistogramTest, HistogramTransform) {
+    std::mt19937 gen(7);
+    std::normal_distribution<float> sourceDist(0.0f, 1.0f);
+    std::normal_distribution<float> targetDist(5.0f, 2.0f);
+
+    histogram::Histogram sourceHist(-6.0f, 6.0f, 240);
+    histogram::Histogram targetHist(-5.0f, 15.0f, 400);
+    std::vector<float> samples(100000);
+    for (auto& v : samples) {
+        v = sourceDist(gen);
+        sourceHist.addData(v);
+    }
+    for (int i = 0; i < 100000; ++i) {
+        targetHist.addData(targetDist(gen));
+    }
+
+    histogram::CDF sourceCDF, targetCDF;
+    sourceCDF.computeFromHistogram(sourceHist);
+    targetCDF.computeFromHistogram(targetHist);
+
+    // 查找表应单调不减
+    histogram::HistogramTransform matcher(sourceCDF, targetCDF);
+    const auto& lut = matcher.getLookupTable();
+    ASSERT_EQ(lut.size(), sourceHist.getResolution() + 1);
+    for (size_t i = 1; i < lut.size(); ++i) {
+        ASSERT_LE(lut[i - 1], lut[i]);
+    }
+
+    // 批量变换（原地）与逐个变换一致，且匹配后的均值和标准差接近目标分布
+    std::vector<float> mapped(samples);
+    matcher.apply(mapped.data(), mapped.data(), mapped.size(), 3);
+    double sum = 0.0, sumSq = 0.0;
+    for (size_t i = 0; i < mapped.size(); ++i) {
+        ASSERT_NEAR(mapped[i], matcher.map(samples[i]), 1e-4f);
+        sum += mapped[i];
+        sumSq += mapped[i] * mapped[i];
+    }
+    double mean = sum / mapped.size();
+    double stddev = std::sqrt(sumSq / mapped.size() - mean * mean);
+    EXPECT_NEAR(mean, 5.0, 0.1);
+    EXPECT_NEAR(stddev, 2.0, 0.1);
+
+    // 8位数据均衡化：查表结果与map()四舍五入一致，输出分布接近均匀
+    histogram::Histogram byteHist(0.0f, 256.0f, 256);
+    std::binomial_distribution<int> byteDist(255, 0.3);
+    std::vector<uint8_t> bytes(65536);
+    for (auto& b : bytes) {
+        b = static_cast<uint8_t>(byteDist(gen));
+        byteHist.addData(static_cast<float>(b));
+    }
+    histogram::CDF byteCDF;
+    byteCDF.computeFromHistogram(byteHist);
+    histogram::HistogramTransform equalizer(byteCDF);
+
+    std::vector<uint8_t> equalized(bytes.size());
+    equalizer.apply(bytes.data(), equalized.data(), bytes.size());
+    histogram::Histogram equalizedHist(0.0f, 256.0f, 4);
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        float expected = std::min(std::max(std::round(equalizer.map(bytes[i])), 0.0f), 255.0f);
+        ASSERT_EQ(equalized[i], static_cast<uint8_t>(expected));
+        equalizedHist.addData(static_cast<float>(equalized[i]));
+    }
+    for (size_t i = 0; i < equalizedHist.getResolution(); ++i) {
+        EXPECT_NEAR(static_cast<double>(equalizedHist.getBinCount(i)) / bytes.size(), 0.25, 0.08);
+    }
+
+    std::vector<uint16_t> words = {0, 100, 200, 65535};
+    std::vector<uint16_t> wordsOut(words.size());
+    equalizer.apply(words.data(), wordsOut.data(), words.size());
+    EXPECT_EQ(wordsOut[3], 256);
+    EXPECT_LE(wordsOut[0], wordsOut[1]);
+    EXPECT_LE(wordsOut[1], wordsOut[2]);
+
+    histogram::CDF empty;
+    EXPECT_THROW(histogram::HistogramTransform{empty}, std::runtime_error);
+}
+
+// 测试快速CSV导出与原有iostream格式逐字节一致
+TEST_F(HistogramTest, CSVExportMatchesStreamFormat) {
+    histogram::Histogram hist(-123.456f, 789.01f, 50000);
+    std::mt19937 gen(99);
+    std::normal_distribution<float> dist(300.0f, 150.0f);
+    for (int i = 0; i < 200000; ++i) {
+        hist.addData(dist(gen));
+    }
+    histogram::CDF cdf;
+    cdf.computeFromHistogram(hist);
+
+    for (bool showAll : {false, true}) {
+        // 参考实现：与CDF::exportHistogramAndCDFToFile原有逐行格式化相同
+        std::ostringstream reference;
+        reference << "bin索引,计数,bin最小值,bin最大值,CDF值,累计概率%\n";
+        const auto& cdfValues = cdf.getCDFValues();
+        for (size_t i = 0; i < hist.getResolution(); ++i) {
+            auto range = hist.getBinRange(i);
+            size_t count = hist.getBinCount(i);
+            float cdfValue = cdfValues[i];
+            if (showAll || count > 0) {
+                reference << i << ","
+                          << count << ","
+                          << std::fixed << std::setprecision(2) << range.first << ","
+                          << std::fixed << std::setprecision(2) << range.second << ","
+                          << std::fixed << std::setprecision(6) << cdfValue << ","
+                          << std::fixed << std::setprecision(2) << (cdfValue * 100) << "%\n";
+            }
+        }
+
+        std::string serial, parallel;
+        histogram::CSVExporter::formatHistogramAndCDF(hist, cdf, serial, showAll);
+        histogram::CSVExporter::formatHistogramAndCDF(hist, cdf, parallel, showAll, 4);
+        EXPECT_TRUE(serial == reference.str());
+        EXPECT_TRUE(parallel == reference.str());
+
+        std::string path = showAll ? "test_output/export_all.csv" : "test_output/export.csv";
+        histogram::CDF::exportHistogramAndCDFToFile(hist, cdf, path, showAll);
+        std::ifstream file(path);
+        std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        EXPECT_TRUE(content == reference.str());
+    }
+
+    histogram::Histogram other(0.0f, 1.0f, 3);
+    std::string out;
+    EXPECT_THROW(histogram::CSVExporter::formatHistogramAndCDF(other, cdf, out), std::invalid_argument);
+}
+
+// 测试t-digest分位数草图
+TEST_F(HistogramTest, TDigestQuantiles) {
+    std::mt19937 gen(31);
+    std::normal_distribution<float> dist1(-20.0f, 3.0f);
+    std::normal_distribution<float> dist2(40.0f, 5.0f);
+
+    // 四个线程各自写入一个草图，最后合并
+    std::vector<std::vector<float>> parts(4);
+    std::vector<float> all;
+    for (size_t p = 0; p < parts.size(); ++p) {
+        for (int i = 0; i < 50000; ++i) {
+            float v = (i % 3 == 0) ? dist1(gen) : dist2(gen);
+            parts[p].push_back(v);
+            all.push_back(v);
+        }
+    }
+    std::vector<histogram::TDigest> digests(parts.size());
+    std::vector<std::thread> workers;
+    for (size_t p = 0; p < parts.size(); ++p) {
+        workers.emplace_back([&, p]() { digests[p].add(parts[p].data(), parts[p].size()); });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    histogram::TDigest digest;
+    for (const auto& d : digests) {
+        digest.merge(d);
+    }
+
+    std::sort(all.begin(), all.end());
+    EXPECT_EQ(digest.getTotalCount(), all.size());
+    EXPECT_FLOAT_EQ(digest.getMin(), all.front());
+    EXPECT_FLOAT_EQ(digest.getMax(), all.back());
+    EXPECT_LE(digest.getCentroidCount(), 200u);
+
+    // 以秩误差衡量精度，尾部更精确
+    for (float q : {0.1f, 1.0f, 10.0f, 33.0f, 50.0f, 90.0f, 99.0f, 99.9f}) {
+        float estimate = digest.getPercentile(q);
+        size_t rank = std::lower_bound(all.begin(), all.end(), estimate) - all.begin();
+        double rankError = std::abs(static_cast<double>(rank) / all.size() - q / 100.0);
+        double tolerance = (q < 1.0f || q > 99.0f) ? 0.0005 : 0.005;
+        EXPECT_LT(rankError, tolerance) << "percentile " << q;
+    }
+    EXPECT_NEAR(digest.getCumulativeProbability(digest.getPercentile(75.0f)), 0.75f, 1e-3f);
+
+    // 序列化后跨进程合并结果一致
+    std::string bytes;
+    digest.serialize(bytes);
+    EXPECT_LT(bytes.size(), 8192u);
+    histogram::TDigest restored = histogram::TDigest::deserialize(bytes.data(), bytes.size());
+    EXPECT_EQ(restored.getTotalCount(), digest.getTotalCount());
+    EXPECT_FLOAT_EQ(restored.getPercentile(42.0f), digest.getPercentile(42.0f));
+    EXPECT_THROW(histogram::TDigest::deserialize(bytes.data(), bytes.size() - 1), std::runtime_error);
+
+    // 篡改的数据：依次改写压缩参数、min、总数据点数、首个质心的权重和第二个质心的均值
+    auto tampered = [&](size_t offset, auto value) {
+        std::string copy = bytes;
+        std::memcpy(&copy[offset], &value, sizeof(value));
+        return copy;
+    };
+    const size_t centroids = 28;
+    for (const std::string& bad :
+         {tampered(4, std::numeric_limits<float>::infinity()), tampered(4, 1e9f), tampered(8, 1e30f),
+          tampered(16, uint64_t(digest.getTotalCount() + 7)), tampered(centroids + 8, -1.0),
+          tampered(centroids + 8, std::nan("")), tampered(centroids + 16, 1e300)}) {
+        EXPECT_THROW(histogram::TDigest::deserialize(bad.data(), bad.size()), std::runtime_error);
+    }
+
+    // 转换为直方图后保留双峰形状
+    histogram::Histogram hist = digest.toHistogram(100);
+    EXPECT_EQ(hist.getTotalCount(), digest.getTotalCount());
+    EXPECT_FLOAT_EQ(hist.getMin(), digest.getMin());
+    EXPECT_NEAR(hist.getBinRange(hist.getMaxBinIndex()).first, 40.0f, 3.0f);
+    size_t leftMode = hist.getBinIndex(-20.0f);
+    size_t valley = hist.getBinIndex(10.0f);
+    EXPECT_GT(hist.getBinCount(leftMode), 10 * hist.getBinCount(valley));
+    histogram::CDF cdf = digest.toCDF(100);
+    EXPECT_NEAR(cdf.getPercentile(50.0f), digest.getPercentile(50.0f), 2.0f);
+
+    histogram::TDigest constant;
+    for (int i = 0; i < 10; ++i) {
+        constant.add(3.0f);
+    }
+    EXPECT_FLOAT_EQ(constant.getPercentile(50.0f), 3.0f);
+    EXPECT_EQ(constant.toHistogram(10).getBinCount(0), 10u);
+
+    // 非有限值被跳过，观测范围和转换结果不受影响
+    histogram::TDigest withInfinity;
+    const float mixed[] = {1.0f, std::numeric_limits<float>::infinity(), 2.0f,
+                           -std::numeric_limits<float>::infinity(), std::nanf(""), 3.0f};
+    withInfinity.add(mixed, 6);
+    withInfinity.add(std::numeric_limits<float>::infinity());
+    EXPECT_EQ(withInfinity.getTotalCount(), 3u);
+    EXPECT_FLOAT_EQ(withInfinity.getMin(), 1.0f);
+    EXPECT_FLOAT_EQ(withInfinity.getMax(), 3.0f);
+    histogram::Histogram finite = withInfinity.toHistogram(10);
+    EXPECT_TRUE(std::isfinite(finite.getBinWidth()));
+    EXPECT_EQ(finite.getTotalCount(), 3u);
+    EXPECT_TRUE(std::isfinite(withInfinity.toCDF(10).getPercentile(50.0f)));
+
+    histogram::TDigest empty;
+    EXPECT_THROW(empty.getPercentile(50.0f), std::runtime_error);
+}
+
+// 测试高斯核缓存和写入调用方缓冲区的滤波接口
+TEST_F(HistogramTest, GaussianFilterCallerBuffers) {
+    histogram::GaussianFilter filter(2.0f);
+    EXPECT_EQ(filter.getKernel().size(), 13u);
+    float kernelSum = 0.0f;
+    for (float w : filter.getKernel()) {
+        kernelSum += w;
+    }
+    EXPECT_NEAR(kernelSum, 1.0f, 1e-6f);
+
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<size_t> dist(0, 1000);
+    std::vector<size_t> counts(257);
+    for (auto& c : counts) {
+        c = dist(gen);
+    }
+    std::vector<float> asFloat(counts.begin(), counts.end());
+
+    std::vector<float> expected = filter.filter(asFloat);
+    std::vector<float> fromCounts(counts.size());
+    std::vector<float> fromFloats(counts.size());
+    filter.filterCounts(counts.data(), fromCounts.data(), counts.size());
+    filter.filter(asFloat.data(), fromFloats.data(), asFloat.size());
+    for (size_t i = 0; i < counts.size(); ++i) {
+        EXPECT_EQ(fromCounts[i], expected[i]);
+        EXPECT_EQ(fromFloats[i], expected[i]);
+    }
+    EXPECT_EQ(filter.filterCounts(counts), expected);
+
+    filter.setSigma(0.5f);
+    EXPECT_FLOAT_EQ(filter.getSigma(), 0.5f);
+    EXPECT_EQ(filter.getKernel().size(), 5u);
+    filter.filter(asFloat.data(), fromFloats.data(), 0); // 空输入不访问缓冲区
+}
+
+// 测试递归高斯滤波相对直接卷积的精度
+TEST_F(HistogramTest, RecursiveGaussianAccuracy) {
+    std::mt19937 gen(11);
+    std::normal_distribution<float> noise(0.0f, 5.0f);
+    std::vector<float> signal(4000);
+    for (size_t i = 0; i < signal.size(); ++i) {
+        float x = static_cast<float>(i);
+        signal[i] = 100.0f * std::exp(-(x - 900.0f) * (x - 900.0f) / (2 * 60.0f * 60.0f))
+                  + 60.0f * std::exp(-(x - 2600.0f) * (x - 2600.0f) / (2 * 150.0f * 150.0f))
+                  + 20.0f + noise(gen);
+    }
+    signal[0] = 80.0f; // 边界处的尖峰用于检查边界归一化
+
+    for (float sigma : {1.0f, 3.0f, 10.0f, 50.0f, 200.0f}) {
+        histogram::GaussianFilter direct(sigma);
+        histogram::GaussianFilter recursive(sigma, histogram::GaussianFilter::Method::Recursive);
+        auto exact = direct.filter(signal);
+        auto approx = recursive.filter(signal);
+
+        float maxError = 0.0f;
+        float peak = 0.0f;
+        for (size_t i = 0; i < signal.size(); ++i) {
+            maxError = std::max(maxError, std::abs(exact[i] - approx[i]));
+            peak = std::max(peak, std::abs(exact[i]));
+        }
+        float relativeError = maxError / peak;
+        RecordProperty("RecursiveErrorSigma" + std::to_string(static_cast<int>(sigma)),
+                       std::to_string(relativeError));
+        EXPECT_LT(relativeError, 0.01f) << "sigma " << sigma;
+    }
+
+    // 常数信号在边界处也应保持不变
+    histogram::GaussianFilter recursive(25.0f, histogram::GaussianFilter::Method::Recursive);
+    std::vector<size_t> flat(500, 7);
+    for (float v : recursive.filterCounts(flat)) {
+        EXPECT_NEAR(v, 7.0f, 1e-3f);
+    }
+
+    // 过小的sigma退化为直接卷积
+    histogram::GaussianFilter tiny(0.3f, histogram::GaussianFilter::Method::Recursive);
+    EXPECT_EQ(tiny.filter(signal), histogram::GaussianFilter(0.3f).filter(signal));
+
+    // Direct滤波器不预先计算递归系数；之后切换方法或修改sigma时按需计算，结果与直接构造相同
+    histogram::GaussianFilter switched(0.3f);
+    switched.setSigma(10.0f);
+    switched.setMethod(histogram::GaussianFilter::Method::Recursive);
+    EXPECT_EQ(switched.filter(signal),
+              histogram::GaussianFilter(10.0f, histogram::GaussianFilter::Method::Recursive).filter(signal));
+    switched.setSigma(3.0f);
+    EXPECT_EQ(switched.filter(signal),
+              histogram::GaussianFilter(3.0f, histogram::GaussianFilter::Method::Recursive).filter(signal));
+}
+
+// 测试边界/内部分开计算的卷积与逐点重新归一化的参考实现一致
+TEST_F(HistogramTest, GaussianFilterMatchesReference) {
+    std::mt19937 gen(17);
+    std::uniform_real_distribution<float> dist(0.0f, 100.0f);
+
+    for (float sigma : {0.4f, 1.0f, 2.5f, 7.0f}) {
+        histogram::GaussianFilter filter(sigma);
+        const auto& kernel = filter.getKernel();
+        const int radius = static_cast<int>(kernel.size() / 2);
+
+        for (size_t size : {size_t(1), size_t(5), size_t(2 * radius), size_t(2 * radius + 1),
+                            size_t(2 * radius + 2), size_t(37), size_t(1000)}) {
+            std::vector<float> input(size);
+            for (auto& v : input) {
+                v = dist(gen);
+            }
+
+            auto output = filter.filter(input);
+            ASSERT_EQ(output.size(), size);
+            for (int i = 0; i < static_cast<int>(size); ++i) {
+                double sum = 0.0, weightSum = 0.0;
+                for (int j = -radius; j <= radius; ++j) {
+                    int idx = i + j;
+                    if (idx >= 0 && idx < static_cast<int>(size)) {
+                        sum += static_cast<double>(input[idx]) * kernel[j + radius];
+                        weightSum += kernel[j + radius];
+                    }
+                }
+                ASSERT_NEAR(output[i], sum / weightSum, 1e-3) << "sigma " << sigma << " size " << size << " i " << i;
+            }
+        }
+    }
+}
+
+// 测试FFT卷积与直接卷积一致，以及自动方法选择
+TEST_F(HistogramTest, FFTGaussianFilter) {
+    std::mt19937 gen(23);
+    std::uniform_real_distribution<float> dist(0.0f, 1000.0f);
+
+    for (float sigma : {0.8f, 3.0f, 20.0f, 90.0f}) {
+        histogram::GaussianFilter direct(sigma);
+        histogram::GaussianFilter fft(sigma, histogram::GaussianFilter::Method::FFT);
+        for (size_t size : {size_t(3), size_t(100), size_t(1000), size_t(12345)}) {
+            std::vector<float> input(size);
+            for (auto& v : input) {
+                v = dist(gen);
+            }
+            auto expected = direct.filter(input);
+            auto actual = fft.filter(input);
+            for (size_t i = 0; i < size; ++i) {
+                ASSERT_NEAR(actual[i], expected[i], 1e-3f) << "sigma " << sigma << " size " << size << " i " << i;
+            }
+        }
+    }
+
+    // 非对称核、多块重叠相加与计数输入
+    std::vector<float> kernel = {0.1f, 0.5f, 0.2f, 0.15f, 0.05f};
+    histogram::FFTConvolver convolver(kernel, 16);
+    EXPECT_EQ(convolver.getBlockSize(), convolver.getFFTSize() - kernel.size() + 1);
+    std::vector<size_t> counts(200);
+    for (size_t i = 0; i < counts.size(); ++i) {
+        counts[i] = (i * 37) % 101;
+    }
+    std::vector<float> output(counts.size());
+    convolver.convolve(counts.data(), output.data(), counts.size());
+    for (int i = 0; i < static_cast<int>(counts.size()); ++i) {
+        double expected = 0.0;
+        for (int j = 0; j < static_cast<int>(kernel.size()); ++j) {
+            int idx = i + 2 - j;
+            if (idx >= 0 && idx < static_cast<int>(counts.size())) {
+                expected += kernel[j] * static_cast<double>(counts[idx]);
+            }
+        }
+        ASSERT_NEAR(output[i], expected, 1e-3) << i;
+    }
+
+    // Auto：窄核短数据用直接卷积，宽核长数据换用O(n)或O(n·log)方法
+    histogram::GaussianFilter narrow(1.0f, histogram::GaussianFilter::Method::Auto);
+    EXPECT_EQ(narrow.selectMethod(1000), histogram::GaussianFilter::Method::Direct);
+    histogram::GaussianFilter wide(200.0f, histogram::GaussianFilter::Method::Auto);
+    EXPECT_NE(wide.selectMethod(1000000), histogram::GaussianFilter::Method::Direct);
+    EXPECT_EQ(wide.selectMethod(100), histogram::GaussianFilter::Method::Direct);
+}
+
+// 测试整数盒式滤波：宽度选择、与浮点参考实现一致、与高斯滤波接近
+TEST_F(HistogramTest, BoxFilterCounts) {
+    // 三次盒式滤波的总方差接近sigma²
+    for (float sigma : {0.5f, 1.0f, 2.5f, 7.0f, 30.0f}) {
+        auto widths = histogram::GaussianFilter::computeBoxWidths(sigma);
+        double variance = 0.0;
+        for (size_t w : widths) {
+            EXPECT_EQ(w % 2, 1u);
+            variance += (static_cast<double>(w) * w - 1.0) / 12.0;
+        }
+        EXPECT_NEAR(std::sqrt(variance), sigma, 0.35 + 0.02 * sigma) << "sigma " << sigma;
+    }
+
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<size_t> dist(0, 100000);
+    for (float sigma : {0.7f, 3.0f, 12.0f}) {
+        histogram::GaussianFilter filter(sigma);
+        auto widths = filter.getBoxWidths();
+        for (size_t size : {size_t(1), size_t(5), size_t(40), size_t(1000)}) {
+            std::vector<size_t> counts(size);
+            for (auto& c : counts) {
+                c = dist(gen);
+            }
+
+            // 浮点参考：对数据和指示函数分别做三次补零盒式卷积，再相除
+            std::vector<double> values(counts.begin(), counts.end());
+            std::vector<double> weights(size, 1.0);
+            auto boxConvolve = [&](const std::vector<double>& x) {
+                // 在足够长的补零数组上卷积，避免截断中间结果
+                int total = 0;
+                for (size_t w : widths) {
+                    total += static_cast<int>(w / 2);
+                }
+                std::vector<double> buffer(size + 2 * total, 0.0);
+                std::copy(x.begin(), x.end(), buffer.begin() + total);
+                for (size_t w : widths) {
+                    int r = static_cast<int>(w / 2);
+                    std::vector<double> next(buffer.size(), 0.0);
+                    for (int i = 0; i < static_cast<int>(buffer.size()); ++i) {
+                        for (int j = -r; j <= r; ++j) {
+                            if (i + j >= 0 && i + j < static_cast<int>(buffer.size())) {
+                                next[i] += buffer[i + j];
+                            }
+                        }
+                    }
+                    buffer.swap(next);
+                }
+                return std::vector<double>(buffer.begin() + total, buffer.begin() + total + size);
+            };
+            auto sums = boxConvolve(values);
+            auto mass = boxConvolve(weights);
+
+            auto actual = filter.filterCountsBox(counts);
+            ASSERT_EQ(actual.size(), size);
+            for (size_t i = 0; i < size; ++i) {
+                double expected = sums[i] / mass[i];
+                ASSERT_NEAR(static_cast<double>(actual[i]), expected, 0.5 + 1e-9)
+                    << "sigma " << sigma << " size " << size << " i " << i;
+            }
+
+            // 输出可以与输入共用缓冲区
+            filter.filterCountsBox(counts.data(), counts.data(), size);
+            EXPECT_EQ(counts, actual);
+        }
+    }
+
+    // 常数输入（包括边界）保持不变
+    histogram::GaussianFilter wide(9.0f);
+    std::vector<size_t> constant(100, 777);
+    EXPECT_EQ(wide.filterCountsBox(constant), constant);
+
+    // 平滑数据上与高斯滤波相差不大
+    std::vector<size_t> smooth(2000);
+    for (size_t i = 0; i < smooth.size(); ++i) {
+        double x = static_cast<double>(i);
+        smooth[i] = static_cast<size_t>(1000.0 + 5000.0 * std::exp(-(x - 700.0) * (x - 700.0) / (2 * 40.0 * 40.0))
+                                      + 3000.0 * std::exp(-(x - 1300.0) * (x - 1300.0) / (2 * 15.0 * 15.0)));
+    }
+    histogram::GaussianFilter gaussian(6.0f);
+    auto reference = gaussian.filterCounts(smooth);
+    auto box = gaussian.filterCountsBox(smooth);
+    for (size_t i = 0; i < smooth.size(); ++i) {
+        ASSERT_NEAR(static_cast<double>(box[i]), reference[i], 0.01 * reference[i] + 1.0) << i;
+    }
+}
+
+// 测试批量多行滤波与逐行滤波一致
+TEST_F(HistogramTest, GaussianFilterRows) {
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<size_t> dist(0, 5000);
+    using Method = histogram::GaussianFilter::Method;
+
+    for (Method method : {Method::Direct, Method::Recursive, Method::FFT}) {
+        histogram::GaussianFilter filter(2.5f, method);
+        for (size_t rows : {size_t(1), size_t(16), size_t(37)}) {
+            for (size_t cols : {size_t(1), size_t(6), size_t(120), size_t(5000)}) {
+                std::vector<size_t> counts(rows * cols);
+                for (auto& c : counts) {
+                    c = dist(gen);
+                }
+                std::vector<float> values(counts.begin(), counts.end());
+
+                for (unsigned threads : {1u, 4u}) {
+                    std::vector<float> batch(rows * cols, -1.0f);
+                    std::vector<float> batchCounts(rows * cols, -1.0f);
+                    filter.filterRows(values.data(), batch.data(), rows, cols, threads);
+                    filter.filterCountsRows(counts.data(), batchCounts.data(), rows, cols, threads);
+
+                    std::vector<float> expected(cols);
+                    for (size_t r = 0; r < rows; ++r) {
+                        filter.filter(values.data() + r * cols, expected.data(), cols);
+                        for (size_t c = 0; c < cols; ++c) {
+                            ASSERT_FLOAT_EQ(batch[r * cols + c], expected[c])
+                                << "rows " << rows << " cols " << cols << " r " << r << " c " << c;
+                            ASSERT_FLOAT_EQ(batchCounts[r * cols + c], expected[c]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// 测试分块并行滤波：任意线程数和块大小下与单线程结果逐位相同
+TEST_F(HistogramTest, ParallelGaussianFilter) {
+    std::mt19937 gen(23);
+    std::uniform_int_distribution<size_t> dist(0, 5000);
+    using Method = histogram::GaussianFilter::Method;
+
+    for (Method method : {Method::Direct, Method::FFT, Method::Recursive, Method::Auto}) {
+        for (float sigma : {0.8f, 3.0f, 12.0f}) {
+            histogram::GaussianFilter parallel(sigma, method);
+            EXPECT_EQ(parallel.getThreads(), 1u);
+            EXPECT_EQ(parallel.getChunkSize(), 0u);
+
+            for (size_t size : {size_t(5), size_t(100), size_t(3001), size_t(70000)}) {
+                std::vector<size_t> counts(size);
+                for (auto& c : counts) {
+                    c = dist(gen);
+                }
+                std::vector<float> values(counts.begin(), counts.end());
+
+                // 块大小小于核半径、与FFT块长度不对齐以及自动选择
+                for (unsigned threads : {2u, 3u, 8u}) {
+                    for (size_t chunkSize : {size_t(0), size_t(7), size_t(1000)}) {
+                        parallel.setThreads(threads);
+                        parallel.setChunkSize(chunkSize);
+                        // Auto在多线程时可能选择不同的方法，与该方法的单线程结果比较
+                        histogram::GaussianFilter serial(sigma, parallel.selectMethod(size));
+                        std::vector<float> expected(size);
+                        serial.filter(values.data(), expected.data(), size);
+                        std::vector<float> output(size, -1.0f);
+                        std::vector<float> outputCounts(size, -1.0f);
+                        parallel.filter(values.data(), output.data(), size);
+                        parallel.filterCounts(counts.data(), outputCounts.data(), size);
+                        for (size_t i = 0; i < size; ++i) {
+                            ASSERT_EQ(output[i], expected[i])
+                                << "method " << static_cast<int>(method) << " sigma " << sigma << " size " << size << " threads " << threads
+                                << " chunk " << chunkSize << " i " << i;
+                            ASSERT_EQ(outputCounts[i], expected[i]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// 测试尺度空间：增量构建与直接滤波一致，跨尺度波峰检测
+TEST_F(HistogramTest, ScaleSpacePeaks) {
+    std::mt19937 gen(17);
+    const size_t size = 1000;
+    std::vector<size_t> counts(size);
+    for (size_t i = 0; i < size; ++i) {
+        double x = static_cast<double>(i);
+        double mean = 20.0 + 400.0 * std::exp(-(x - 200.0) * (x - 200.0) / (2 * 3.0 * 3.0))
+                    + 150.0 * std::exp(-(x - 600.0) * (x - 600.0) / (2 * 25.0 * 25.0));
+        counts[i] = std::poisson_distribution<size_t>(mean)(gen);
+    }
+
+    // 不抽取时每层等于对原始数据直接做对应sigma的滤波（内部区域）
+    histogram::ScaleSpace full(1.0f, 16.0f, 3, false);
+    full.build(counts.data(), size);
+    ASSERT_EQ(full.getLevelCount(), 13u);
+    for (size_t k = 0; k < full.getLevelCount(); ++k) {
+        EXPECT_NEAR(full.getSigma(k), std::pow(2.0f, k / 3.0f), 1e-4f);
+        EXPECT_EQ(full.getStep(k), 1u);
+        auto expected = histogram::GaussianFilter(full.getSigma(k)).filterCounts(counts);
+        const auto& level = full.getLevel(k);
+        size_t margin = static_cast<size_t>(4 * full.getSigma(k)) + 2;
+        for (size_t i = margin; i + margin < size; ++i) {
+            ASSERT_NEAR(level[i], expected[i], 0.5f) << "level " << k << " i " << i;
+        }
+    }
+
+    // 抽取时第k层第i个样本对应原始坐标 i·step
+    histogram::ScaleSpace space(1.0f, 32.0f, 3);
+    space.build(counts.data(), size);
+    ASSERT_EQ(space.getLevelCount(), 16u);
+    EXPECT_EQ(space.getStep(0), 1u);
+    EXPECT_EQ(space.getStep(3), 2u);
+    EXPECT_EQ(space.getStep(15), 32u);
+    for (size_t k = 0; k < space.getLevelCount(); ++k) {
+        auto expected = histogram::GaussianFilter(space.getSigma(k)).filterCounts(counts);
+        const auto& level = space.getLevel(k);
+        ASSERT_EQ(level.size(), (size + space.getStep(k) - 1) / space.getStep(k));
+        ASSERT_EQ(space.getFirstDerivative(k).size(), level.size());
+        ASSERT_EQ(space.getSecondDerivative(k).size(), level.size());
+        size_t margin = static_cast<size_t>(4 * space.getSigma(k)) + 2 * space.getStep(k);
+        for (size_t i = 0; i < level.size(); ++i) {
+            size_t x = i * space.getStep(k);
+            if (x >= margin && x + margin < size) {
+                ASSERT_NEAR(level[i], expected[x], 2.0f) << "level " << k << " i " << i;
+            }
+        }
+    }
+
+    // 窄峰在小尺度上响应最大，宽峰在大尺度上响应最大；短暂的噪声极大值被过滤
+    auto peaks = space.findPeaks(1.0f, 0.05f);
+    ASSERT_GE(peaks.size(), 2u);
+    const histogram::ScaleSpace::Peak* narrow = nullptr;
+    const histogram::ScaleSpace::Peak* wide = nullptr;
+    for (const auto& peak : peaks) {
+        if (std::abs(peak.position - 200.0f) < 3.0f) {
+            narrow = &peak;
+        }
+        if (std::abs(peak.position - 600.0f) < 10.0f) {
+            wide = &peak;
+        }
+        EXPECT_GE(peak.lifetime, 1.0f);
+    }
+    ASSERT_NE(narrow, nullptr);
+    ASSERT_NE(wide, nullptr);
+    EXPECT_LT(narrow->scale, 8.0f);
+    EXPECT_GT(wide->scale, 16.0f);
+    EXPECT_LE(narrow->firstLevel, 1u);
+    for (size_t i = 1; i < peaks.size(); ++i) {
+        EXPECT_GE(peaks[i - 1].response, peaks[i].response);
+    }
+}
+
+// 测试scipy语义的波峰检测：平台、突出度、宽度与逐点扫描的参考实现一致
+TEST_F(HistogramTest, PeakFinderProminence) {
+    // 手工算例：平台[1,3]取中点2，平台[7,8]取中点7
+    const std::vector<float> x = {0, 1, 1, 1, 0, 2, 0, 3, 3, 0};
+    histogram::PeakFinder finder;
+    auto result = finder.find(x);
+    ASSERT_EQ(result.peaks, (std::vector<size_t>{2, 5, 7}));
+    EXPECT_EQ(result.prominences, (std::vector<float>{1, 2, 3}));
+    EXPECT_EQ(result.leftBases, (std::vector<size_t>{0, 4, 6}));
+    EXPECT_EQ(result.rightBases, (std::vector<size_t>{4, 6, 9}));
+    EXPECT_FLOAT_EQ(result.leftIps[2], 6.5f);
+    EXPECT_FLOAT_EQ(result.rightIps[2], 8.5f);
+    EXPECT_FLOAT_EQ(result.widths[2], 2.0f);
+    EXPECT_FLOAT_EQ(result.widthHeights[2], 1.5f);
+
+    // 旧的findPeaks要求两侧严格更低，检测不到平台波峰
+    histogram::Histogram plateau(0.0f, 10.0f, 10);
+    const size_t plateauCounts[] = {1, 2, 9, 9, 9, 2, 1, 1, 1, 1};
+    for (size_t i = 0; i < 10; ++i) {
+        plateau.addBinCount(i, plateauCounts[i]);
+    }
+    EXPECT_TRUE(plateau.findPeaks().empty());
+    ASSERT_EQ(finder.find(plateau).peaks, (std::vector<size_t>{3}));
+    EXPECT_FLOAT_EQ(finder.find(plateau).prominences[0], 8.0f);
+
+    // 随机整数数据（大量平台）与逐点扫描的参考实现比较
+    std::mt19937 gen(29);
+    std::uniform_int_distribution<size_t> dist(0, 6);
+    std::vector<size_t> counts(5000);
+    for (auto& c : counts) {
+        c = dist(gen);
+    }
+    auto all = finder.find(counts);
+    ASSERT_FALSE(all.empty());
+    for (size_t k = 0; k < all.size(); ++k) {
+        const size_t peak = all.peaks[k];
+        const double value = static_cast<double>(counts[peak]);
+        double leftMin = value;
+        size_t leftBase = peak;
+        for (size_t i = peak + 1; i-- > 0 && counts[i] <= counts[peak];) {
+            if (counts[i] < leftMin) {
+                leftMin = static_cast<double>(counts[i]);
+                leftBase = i;
+            }
+        }
+        double rightMin = value;
+        size_t rightBase = peak;
+        for (size_t i = peak; i < counts.size() && counts[i] <= counts[peak]; ++i) {
+            if (counts[i] < rightMin) {
+                rightMin = static_cast<double>(counts[i]);
+                rightBase = i;
+            }
+        }
+        ASSERT_EQ(all.leftBases[k], leftBase) << "peak " << peak;
+        ASSERT_EQ(all.rightBases[k], rightBase) << "peak " << peak;
+        ASSERT_FLOAT_EQ(all.prominences[k], static_cast<float>(value - std::max(leftMin, rightMin)));
+        ASSERT_GE(all.leftIps[k], static_cast<float>(leftBase));
+        ASSERT_LE(all.rightIps[k], static_cast<float>(rightBase));
+    }
+
+    // 最小间距：保留的波峰两两间距不小于distance，且每个被删除的波峰附近都有更高的保留波峰
+    finder.setDistance(25);
+    auto spaced = finder.find(counts);
+    for (size_t k = 1; k < spaced.size(); ++k) {
+        ASSERT_GE(spaced.peaks[k] - spaced.peaks[k - 1], 25u);
+    }
+    for (size_t peak : all.peaks) {
+        bool covered = false;
+        for (size_t kept : spaced.peaks) {
+            size_t gap = kept > peak ? kept - peak : peak - kept;
+            covered = covered || (gap < 25 && counts[kept] >= counts[peak]);
+        }
+        ASSERT_TRUE(covered) << "peak " << peak;
+    }
+    // 高度相同的波峰与scipy一样保留靠右的
+    auto tied = finder.find(std::vector<float>{0.0f, 5.0f, 0.0f, 5.0f, 0.0f, 1.0f, 0.0f});
+    ASSERT_EQ(tied.size(), 1u);
+    EXPECT_EQ(tied.peaks[0], 3u);
+
+    // 突出度和宽度过滤
+    finder.setDistance(1);
+    finder.setProminence(4.0);
+    finder.setWidth(2.0);
+    auto filtered = finder.find(counts);
+    for (size_t k = 0; k < filtered.size(); ++k) {
+        EXPECT_GE(filtered.prominences[k], 4.0f);
+        EXPECT_GE(filtered.widths[k], 2.0f);
+    }
+    EXPECT_LT(filtered.size(), all.size());
+    EXPECT_THROW(finder.setDistance(0), std::invalid_argument);
+
+    // 平滑后的双峰数据：按突出度只保留两个主峰
+    std::vector<size_t> bimodal(400);
+    for (size_t i = 0; i < bimodal.size(); ++i) {
+        double x0 = static_cast<double>(i);
+        double mean = 10.0 + 300.0 * std::exp(-(x0 - 120.0) * (x0 - 120.0) / 200.0)
+                    + 200.0 * std::exp(-(x0 - 280.0) * (x0 - 280.0) / 800.0);
+        bimodal[i] = std::poisson_distribution<size_t>(mean)(gen);
+    }
+    auto smoothed = histogram::GaussianFilter(3.0f).filterCounts(bimodal);
+    histogram::PeakFinder major;
+    major.setProminence(50.0);
+    auto modes = major.find(smoothed);
+    ASSERT_EQ(modes.size(), 2u);
+    EXPECT_NEAR(static_cast<double>(modes.peaks[0]), 120.0, 4.0);
+    EXPECT_NEAR(static_cast<double>(modes.peaks[1]), 280.0, 6.0);
+    // 半突出度宽度约为2.355·sqrt(sigma_peak² + sigma_filter²)
+    EXPECT_NEAR(modes.widths[0], 2.355 * std::sqrt(100.0 + 9.0), 5.0);
+}
+
+// 测试持久同调波峰：出生/消亡配对、按持久度排序、对噪声稳定
+TEST_F(HistogramTest, PersistentPeaks) {
+    histogram::Histogram hist(0.0f, 7.0f, 7);
+    const size_t counts[] = {1, 5, 2, 4, 3, 8, 0};
+    for (size_t i = 0; i < 7; ++i) {
+        hist.addBinCount(i, counts[i]);
+    }
+    auto info = hist.getPersistentPeaksInfo(0.0f);
+    ASSERT_EQ(info.size(), 3u);
+    EXPECT_EQ(std::get<0>(info[0]), 5u);
+    EXPECT_EQ(std::get<3>(info[0]), 8u); // 最高峰：最大计数 - 最小计数
+    EXPECT_EQ(std::get<0>(info[1]), 1u);
+    EXPECT_EQ(std::get<3>(info[1]), 3u); // 在bin 2（计数2）处并入最高峰
+    EXPECT_EQ(std::get<0>(info[2]), 3u);
+    EXPECT_EQ(std::get<3>(info[2]), 1u); // 在bin 4（计数3）处并入
+    EXPECT_EQ(std::get<1>(info[1]), 5u);
+    EXPECT_FLOAT_EQ(std::get<2>(info[1]).first, 1.0f);
+    EXPECT_EQ(hist.findPersistentPeaks(0.2f), (std::vector<size_t>{5, 1}));
+
+    // 平台和两端：平台取最左侧的bin，端点也可以是波峰
+    histogram::Histogram edges(0.0f, 6.0f, 6);
+    const size_t edgeCounts[] = {9, 2, 6, 6, 1, 4};
+    for (size_t i = 0; i < 6; ++i) {
+        edges.addBinCount(i, edgeCounts[i]);
+    }
+    EXPECT_EQ(edges.findPersistentPeaks(0.0f), (std::vector<size_t>{0, 2, 5}));
+    EXPECT_TRUE(histogram::Histogram(0.0f, 1.0f, 10).findPersistentPeaks(0.0f).empty());
+
+    // 带泊松噪声的双峰：前两个持久度最高的波峰就是两个主峰，噪声峰的持久度远小于它们
+    std::mt19937 gen(31);
+    histogram::Histogram noisy(0.0f, 1000.0f, 1000);
+    histogram::Histogram scaled(0.0f, 1000.0f, 1000);
+    for (size_t i = 0; i < 1000; ++i) {
+        double x = static_cast<double>(i);
+        double mean = 50.0 + 800.0 * std::exp(-(x - 300.0) * (x - 300.0) / 2000.0)
+                    + 500.0 * std::exp(-(x - 700.0) * (x - 700.0) / 5000.0);
+        size_t count = std::poisson_distribution<size_t>(mean)(gen);
+        noisy.addBinCount(i, count);
+        scaled.addBinCount(i, count * 1000003); // 计数范围大时走比较排序
+    }
+    auto ranked = noisy.getPersistentPeaksInfo(0.0f);
+    ASSERT_GE(ranked.size(), 3u);
+    EXPECT_NEAR(static_cast<double>(std::get<0>(ranked[0])), 300.0, 20.0);
+    EXPECT_NEAR(static_cast<double>(std::get<0>(ranked[1])), 700.0, 30.0);
+    EXPECT_GT(std::get<3>(ranked[1]), 5 * std::get<3>(ranked[2]));
+    EXPECT_EQ(noisy.findPersistentPeaks(0.2f).size(), 2u);
+
+    auto rankedScaled = scaled.getPersistentPeaksInfo(0.0f);
+    ASSERT_EQ(rankedScaled.size(), ranked.size());
+    for (size_t k = 0; k < ranked.size(); ++k) {
+        EXPECT_EQ(std::get<0>(rankedScaled[k]), std::get<0>(ranked[k]));
+        EXPECT_EQ(std::get<3>(rankedScaled[k]), std::get<3>(ranked[k]) * 1000003);
+    }
+}
+
+// 测试增量波峰跟踪：每次更新后与全量扫描一致，回调与波峰集合的变化一致
+TEST_F(HistogramTest, PeakTracker) {
+    histogram::Histogram hist(0.0f, 100.0f, 100);
+    hist.addBinCount(50, 3); // 附加前已有的数据
+    histogram::PeakTracker tracker(hist);
+    EXPECT_EQ(tracker.getPeaks(), (std::vector<size_t>{50}));
+
+    std::set<size_t> expected(tracker.getPeaks().begin(), tracker.getPeaks().end());
+    size_t events = 0;
+    tracker.setCallback([&](size_t bin, bool appeared) {
+        ++events;
+        if (appeared) {
+            EXPECT_TRUE(expected.insert(bin).second) << "bin " << bin;
+        } else {
+            EXPECT_EQ(expected.erase(bin), 1u) << "bin " << bin;
+        }
+    });
+
+    auto scan = [&hist]() {
+        std::vector<size_t> peaks;
+        const auto& counts = hist.getBinCounts();
+        for (size_t i = 1; i + 1 < counts.size(); ++i) {
+            if (counts[i] > counts[i - 1] && counts[i] > counts[i + 1]) {
+                peaks.push_back(i);
+            }
+        }
+        return peaks;
+    };
+
+    std::mt19937 gen(37);
+    std::normal_distribution<float> dist(50.0f, 20.0f);
+    for (int step = 0; step < 3000; ++step) {
+        tracker.addData(dist(gen)); // 包括超出范围而被忽略的值
+        if (step % 7 == 0) {
+            ASSERT_EQ(tracker.getPeaks(), scan()) << "step " << step;
+            ASSERT_EQ(std::vector<size_t>(expected.begin(), expected.end()), scan());
+        }
+    }
+    EXPECT_GT(events, 0u);
+    tracker.addBinCount(0, 1000); // 端点不是波峰，但会使bin 1失去波峰地位
+    EXPECT_FALSE(tracker.isPeak(0));
+    EXPECT_FALSE(tracker.isPeak(1));
+    EXPECT_EQ(tracker.getPeaks(), scan());
+
+    auto info = tracker.getPeaksInfo();
+    ASSERT_EQ(info.size(), tracker.getPeakCount());
+    for (const auto& peak : info) {
+        EXPECT_EQ(std::get<1>(peak), hist.getBinCount(std::get<0>(peak)));
+        EXPECT_EQ(std::get<2>(peak), hist.getBinRange(std::get<0>(peak)));
+    }
+
+    // 查询不修改状态，没有更新时可以从多个线程同时查询
+    const std::vector<size_t> peaks = scan();
+    std::vector<std::thread> readers;
+    std::vector<int> matches(4, 0);
+    for (size_t t = 0; t < matches.size(); ++t) {
+        readers.emplace_back([&, t]() {
+            matches[t] = tracker.getPeaks() == peaks && tracker.getPeaksInfo().size() == peaks.size();
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(matches, std::vector<int>(matches.size(), 1));
+
+    // 直接修改直方图后重新扫描
+    hist.clear();
+    tracker.rescan();
+    EXPECT_EQ(tracker.getPeakCount(), 0u);
+    EXPECT_TRUE(expected.empty());
+
+    // 最小计数
+    histogram::PeakTracker strict(hist, 5);
+    strict.addBinCount(10, 4);
+    EXPECT_FALSE(strict.isPeak(10));
+    strict.addBinCount(10, 1);
+    EXPECT_TRUE(strict.isPeak(10));
+    EXPECT_THROW(strict.isPeak(100), std::out_of_range);
+}
+
+// 测试亚bin波峰定位：高斯拟合对采样高斯无偏，直方图上的误差远小于bin宽度
+TEST_F(HistogramTest, PeakRefinement) {
+    using Method = histogram::PeakRefiner::Method;
+    std::vector<float> samples(100);
+    const float mean = 50.3f;
+    const float sigma = 3.0f;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        float x = static_cast<float>(i) - mean;
+        samples[i] = 1000.0f * std::exp(-x * x / (2 * sigma * sigma));
+    }
+    const std::vector<size_t> peaks = {50};
+
+    auto gaussian = histogram::PeakRefiner(Method::Gaussian).refine(samples.data(), samples.size(), peaks);
+    ASSERT_EQ(gaussian.size(), 1u);
+    EXPECT_NEAR(gaussian.positions[0], mean, 1e-3f);
+    EXPECT_NEAR(gaussian.heights[0], 1000.0f, 0.5f);
+    EXPECT_NEAR(gaussian.fwhms[0], 2.35482f * sigma, 1e-2f);
+
+    auto parabolic = histogram::PeakRefiner(Method::Parabolic).refine(samples.data(), samples.size(), peaks);
+    EXPECT_NEAR(parabolic.positions[0], mean, 0.05f);
+    EXPECT_GT(parabolic.heights[0], samples[50]);
+    EXPECT_NEAR(parabolic.fwhms[0], 2.35482f * sigma, 1.5f);
+
+    auto centroid = histogram::PeakRefiner(Method::Centroid).refine(samples.data(), samples.size(), peaks);
+    EXPECT_NEAR(centroid.positions[0], mean, 0.1f);
+    EXPECT_NEAR(centroid.fwhms[0], 2.35482f * sigma, 0.2f);
+
+    // 直方图：sigma为1个bin，细化后的位置误差远小于bin宽度0.5
+    histogram::Histogram hist(0.0f, 20.0f, 40);
+    std::mt19937 gen(41);
+    std::normal_distribution<float> left(6.37f, 0.5f);
+    std::normal_distribution<float> right(13.81f, 0.5f);
+    for (int i = 0; i < 500000; ++i) {
+        hist.addData(left(gen));
+        hist.addData(right(gen));
+    }
+    auto found = hist.findPeaks(0.1f);
+    ASSERT_EQ(found.size(), 2u);
+    for (Method method : {Method::Gaussian, Method::Parabolic, Method::Centroid}) {
+        auto refined = histogram::PeakRefiner(method).refine(hist, found);
+        ASSERT_EQ(refined.size(), 2u);
+        float tolerance = method == Method::Gaussian ? 0.03f : 0.1f;
+        EXPECT_NEAR(refined.positions[0], 6.37f, tolerance) << static_cast<int>(method);
+        EXPECT_NEAR(refined.positions[1], 13.81f, tolerance) << static_cast<int>(method);
+        // 分箱使方差增加binWidth²/12
+        EXPECT_NEAR(refined.fwhms[0], 2.35482f * std::sqrt(0.25f + 0.25f / 12), 0.25f);
+    }
+
+    // 平顶改用半高宽度；端点按镜像处理，不偏移
+    const std::vector<float> flat = {1, 5, 5, 5, 1};
+    auto flatTop = histogram::PeakRefiner(Method::Parabolic).refine(flat.data(), flat.size(), {2});
+    EXPECT_FLOAT_EQ(flatTop.positions[0], 2.0f);
+    EXPECT_FLOAT_EQ(flatTop.fwhms[0], 3.25f); // 半高2.5处插值：0.375 ~ 3.625
+    const std::vector<size_t> edge = {9, 4, 1};
+    auto edgePeak = histogram::PeakRefiner().refine(edge.data(), edge.size(), {0});
+    EXPECT_FLOAT_EQ(edgePeak.positions[0], 0.0f);
+    EXPECT_GT(edgePeak.fwhms[0], 0.0f);
+    EXPECT_THROW(histogram::PeakRefiner().refine(edge.data(), edge.size(), {3}), std::out_of_range);
+}
+
+// 测试高斯混合拟合：EM收敛到真实分量、对数似然单调不减、并行与逐个拟合一致
+TEST_F(HistogramTest, GaussianMixtureFit) {
+    // 三个分量，两个部分重叠
+    histogram::Histogram hist(0.0f, 30.0f, 300);
+    std::mt19937 gen(42);
+    std::normal_distribution<float> a(6.0f, 1.0f);
+    std::normal_distribution<float> b(11.0f, 1.5f);
+    std::normal_distribution<float> c(22.0f, 2.0f);
+    for (int i = 0; i < 200000; ++i) {
+        hist.addData(a(gen));
+        if (i % 2 == 0) {
+            hist.addData(b(gen));
+        }
+        hist.addData(c(gen));
+    }
+
+    histogram::GaussianMixture mixture;
+    // 在三个分量附近的bin上初始化
+    std::vector<size_t> seeds = {60, 110, 220};
+    auto result = mixture.fit(hist, seeds);
+    ASSERT_EQ(result.components.size(), 3u);
+    EXPECT_TRUE(result.converged);
+    EXPECT_EQ(result.history.size(), result.iterations);
+    EXPECT_DOUBLE_EQ(result.history.back(), result.logLikelihood);
+    // EM的对数似然单调不减
+    for (size_t i = 1; i < result.history.size(); ++i) {
+        EXPECT_GE(result.history[i], result.history[i - 1] - 1e-6 * std::abs(result.history[i]));
+    }
+
+    const double means[] = {6.0, 11.0, 22.0};
+    const double sigmas[] = {1.0, 1.5, 2.0};
+    const double weights[] = {0.4, 0.2, 0.4};
+    for (size_t k = 0; k < 3; ++k) {
+        EXPECT_NEAR(result.components[k].mean, means[k], 0.05) << k;
+        EXPECT_NEAR(std::sqrt(result.components[k].variance), sigmas[k], 0.05) << k;
+        EXPECT_NEAR(result.components[k].weight, weights[k], 0.01) << k;
+    }
+
+    // 并行拟合与逐个拟合结果一致
+    std::vector<histogram::Histogram> hists;
+    for (int h = 0; h < 6; ++h) {
+        histogram::Histogram single(0.0f, 30.0f, 30);
+        std::normal_distribution<float> d(8.0f + h, 1.0f);
+        std::normal_distribution<float> e(20.0f, 1.5f);
+        for (int i = 0; i < 20000; ++i) {
+            single.addData(d(gen));
+            single.addData(e(gen));
+        }
+        hists.push_back(single);
+    }
+    auto parallel = mixture.fitAll(hists, 4);
+    ASSERT_EQ(parallel.size(), hists.size());
+    for (size_t h = 0; h < hists.size(); ++h) {
+        auto serial = mixture.fit(hists[h]);
+        ASSERT_EQ(parallel[h].components.size(), serial.components.size());
+        EXPECT_EQ(serial.components.size(), 2u);
+        EXPECT_EQ(parallel[h].iterations, serial.iterations);
+        for (size_t k = 0; k < serial.components.size(); ++k) {
+            EXPECT_DOUBLE_EQ(parallel[h].components[k].mean, serial.components[k].mean);
+        }
+    }
+
+    // 没有种子时退化为单个分量；空直方图没有分量
+    auto single = mixture.fit(hist, {});
+    ASSERT_EQ(single.components.size(), 1u);
+    EXPECT_DOUBLE_EQ(single.components[0].weight, 1.0);
+    EXPECT_EQ(mixture.fit(histogram::Histogram(0.0f, 1.0f, 10)).components.size(), 0u);
+
+    EXPECT_THROW(mixture.setTolerance(-1.0), std::invalid_argument);
+    EXPECT_THROW(mixture.setMaxIterations(0), std::invalid_argument);
+    EXPECT_THROW(mixture.fit(hist, {300}), std::out_of_range);
+}
+
+// 测试阈值分割：Otsu、Kapur、多级Otsu和三角法与直接计算或穷举的结果一致
+TEST_F(HistogramTest, Thresholding) {
+    // 双峰：阈值落在两峰之间的谷底附近
+    histogram::Histogram hist(0.0f, 256.0f, 256);
+    std::mt19937 gen(43);
+    std::normal_distribution<float> dark(60.0f, 10.0f);
+    std::normal_distribution<float> bright(180.0f, 15.0f);
+    for (int i = 0; i < 50000; ++i) {
+        hist.addData(dark(gen));
+        hist.addData(bright(gen));
+    }
+    histogram::Thresholding thresholding(hist);
+    size_t otsu = thresholding.otsu();
+    EXPECT_GT(otsu, 100u);
+    EXPECT_LT(otsu, 140u);
+    EXPECT_FLOAT_EQ(thresholding.getThresholdValue(otsu), static_cast<float>(otsu));
+    EXPECT_EQ(thresholding.multiOtsu(1), std::vector<size_t>{otsu});
+    // Kapur与逐类直接求熵的结果一致
+    const auto& binCounts = hist.getBinCounts();
+    auto entropy = [&](size_t begin, size_t end) {
+        double w = 0.0;
+        for (size_t i = begin; i < end; ++i) {
+            w += binCounts[i];
+        }
+        double h = 0.0;
+        for (size_t i = begin; i < end; ++i) {
+            if (binCounts[i] > 0) {
+                double p = binCounts[i] / w;
+                h -= p * std::log(p);
+            }
+        }
+        return h;
+    };
+    size_t kapur = 1;
+    double bestEntropy = -1.0;
+    for (size_t t = 1; t < binCounts.size(); ++t) {
+        double h = entropy(0, t) + entropy(t, binCounts.size());
+        if (h > bestEntropy + 1e-9) {
+            bestEntropy = h;
+            kapur = t;
+        }
+    }
+    EXPECT_EQ(thresholding.kapur(), kapur);
+    EXPECT_GT(kapur, 80u);
+    EXPECT_LT(kapur, 180u);
+
+    // 同一遍扫描得到的CDF与单独计算的一致
+    histogram::CDF cdf;
+    cdf.computeFromHistogram(hist);
+    EXPECT_EQ(thresholding.getCDF().getCDFValues(), cdf.getCDFValues());
+    EXPECT_DOUBLE_EQ(thresholding.getMoments().counts.back(), static_cast<double>(hist.getTotalCount()));
+
+    // 多级Otsu与穷举结果一致（含空bin）
+    auto score = [](const std::vector<size_t>& counts, const std::vector<size_t>& thresholds) {
+        double total = 0.0;
+        size_t begin = 0;
+        for (size_t k = 0; k <= thresholds.size(); ++k) {
+            size_t end = k < thresholds.size() ? thresholds[k] : counts.size();
+            double w = 0.0, m = 0.0;
+            for (size_t i = begin; i < end; ++i) {
+                w += counts[i];
+                m += static_cast<double>(i) * counts[i];
+            }
+            total += w > 0.0 ? m * m / w : 0.0;
+            begin = end;
+        }
+        return total;
+    };
+    std::uniform_int_distribution<int> countDist(0, 40);
+    for (int trial = 0; trial < 20; ++trial) {
+        const size_t size = 24;
+        histogram::Histogram small(0.0f, static_cast<float>(size), size);
+        std::vector<size_t> counts(size);
+        for (size_t i = 0; i < size; ++i) {
+            counts[i] = countDist(gen) < 10 ? 0 : countDist(gen);
+            small.addBinCount(i, counts[i]);
+        }
+        counts[trial % size] += 1;
+        small.addBinCount(trial % size, 1);
+        histogram::Thresholding t(small);
+        auto dp = t.multiOtsu(3);
+        ASSERT_EQ(dp.size(), 3u);
+        EXPECT_TRUE(dp[0] >= 1 && dp[0] < dp[1] && dp[1] < dp[2] && dp[2] < size);
+        double best = 0.0;
+        for (size_t a = 1; a < size; ++a) {
+            for (size_t b = a + 1; b < size; ++b) {
+                for (size_t c = b + 1; c < size; ++c) {
+                    best = std::max(best, score(counts, {a, b, c}));
+                }
+            }
+        }
+        EXPECT_NEAR(score(counts, dp), best, 1e-9 * best) << trial;
+    }
+
+    // 三角法：单峰长拖尾，阈值在峰与拖尾末端之间
+    histogram::Histogram skewed(0.0f, 100.0f, 100);
+    std::exponential_distribution<float> tail(0.1f);
+    for (int i = 0; i < 100000; ++i) {
+        skewed.addData(5.0f + tail(gen));
+    }
+    size_t triangle = histogram::Thresholding(skewed).triangle();
+    EXPECT_GT(triangle, 6u);
+    EXPECT_LT(triangle, 60u);
+
+    EXPECT_THROW(thresholding.multiOtsu(0), std::invalid_argument);
+    EXPECT_THROW(thresholding.multiOtsu(256), std::invalid_argument);
+    EXPECT_THROW(histogram::Thresholding(histogram::Histogram(0.0f, 1.0f, 10)), std::runtime_error);
+}
+
+// 测试紧凑二进制序列化：往返一致、编码长度、直接合并编码数据以及对无效数据的校验
+TEST_F(HistogramTest, HistogramSerialization) {
+    histogram::Histogram hist(-5.0f, 5.0f, 10000);
+    std::mt19937 gen(44);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    for (int i = 0; i < 200000; ++i) {
+        hist.addData(dist(gen));
+    }
+    hist.addBinCount(0, size_t(1) << 40); // 大计数需要多字节varint
+
+    for (bool delta : {false, true}) {
+        std::string data;
+        hist.serialize(data, delta);
+        // 稀疏的两端只占游程长度，远小于每个bin 8字节
+        EXPECT_LT(data.size(), hist.getResolution() * 2) << delta;
+        auto restored = histogram::Histogram::deserialize(data.data(), data.size());
+        EXPECT_EQ(restored.getMin(), hist.getMin());
+        EXPECT_EQ(restored.getMax(), hist.getMax());
+        EXPECT_EQ(restored.getBinCounts(), hist.getBinCounts());
+        EXPECT_EQ(restored.getTotalCount(), hist.getTotalCount());
+    }
+    // 大计数、平滑的直方图差分编码更短
+    histogram::Histogram smooth(0.0f, 1.0f, 1000);
+    for (size_t i = 0; i < 1000; ++i) {
+        double x = (static_cast<double>(i) - 500.0) / 150.0;
+        smooth.addBinCount(i, static_cast<size_t>(1e7 * std::exp(-x * x)) + 1);
+    }
+    std::string plain, delta;
+    smooth.serialize(plain);
+    smooth.serialize(delta, true);
+    EXPECT_LT(delta.size(), plain.size());
+
+    // 直接合并编码数据与merge结果一致
+    histogram::Histogram other(-5.0f, 5.0f, 10000);
+    for (int i = 0; i < 50000; ++i) {
+        other.addData(dist(gen) + 2.0f);
+    }
+    std::string encoded;
+    other.serialize(encoded, true);
+    histogram::Histogram expected = hist;
+    expected.merge(other);
+    histogram::Histogram merged = hist;
+    merged.mergeFromSerialized(encoded.data(), encoded.size());
+    EXPECT_EQ(merged.getBinCounts(), expected.getBinCounts());
+    EXPECT_EQ(merged.getTotalCount(), expected.getTotalCount());
+
+    // 空直方图和全零的尾部
+    histogram::Histogram empty(0.0f, 1.0f, 7);
+    std::string emptyData;
+    empty.serialize(emptyData);
+    EXPECT_EQ(histogram::Histogram::deserialize(emptyData.data(), emptyData.size()).getBinCounts(),
+              empty.getBinCounts());
+
+    // 几何不一致、截断或附加多余字节时抛出异常，且不修改当前直方图
+    histogram::Histogram coarse(-5.0f, 5.0f, 100);
+    EXPECT_THROW(coarse.mergeFromSerialized(encoded.data(), encoded.size()), std::invalid_argument);
+    histogram::Histogram target = hist;
+    EXPECT_THROW(target.mergeFromSerialized(encoded.data(), encoded.size() - 1), std::runtime_error);
+    EXPECT_EQ(target.getBinCounts(), hist.getBinCounts());
+    std::string padded = encoded + '\0';
+    EXPECT_THROW(target.mergeFromSerialized(padded.data(), padded.size()), std::runtime_error);
+    EXPECT_THROW(histogram::Histogram::deserialize("HSTX", 4), std::runtime_error);
+
+    // 伪造的头部：巨大的bin数在分配前被拒绝，总计数必须与各bin之和一致
+    auto forge = [](uint64_t resolution, uint64_t totalCount, std::initializer_list<uint64_t> body) {
+        std::string data("HSTB\x01\x00", 6);
+        const float range[2] = {0.0f, 1.0f};
+        data.append(reinterpret_cast<const char*>(range), sizeof(range));
+        for (uint64_t value : {resolution, totalCount}) {
+            for (; value >= 0x80; value >>= 7) {
+                data += static_cast<char>((value & 0x7F) | 0x80);
+            }
+            data += static_cast<char>(value);
+        }
+        for (uint64_t value : body) {
+            data += static_cast<char>(value); // 测试中的值都小于128
+        }
+        return data;
+    };
+    const std::string valid = forge(4, 3, {1, 2, 1, 2, 1, 0});
+    EXPECT_EQ(histogram::Histogram::deserialize(valid.data(), valid.size()).getTotalCount(), 3u);
+    for (const std::string& bad : {forge(~uint64_t(0), 0, {}), forge(uint64_t(1) << 32, 0, {}),
+                                   forge(4, 100, {1, 2, 1, 2, 1, 0}), forge(4, 0, {1, 2, 1, 2, 1, 0})}) {
+        EXPECT_THROW(histogram::Histogram::deserialize(bad.data(), bad.size()), std::runtime_error);
+        histogram::Histogram unchanged(0.0f, 1.0f, 4);
+        EXPECT_THROW(unchanged.mergeFromSerialized(bad.data(), bad.size()), std::exception);
+        EXPECT_EQ(unchanged.getTotalCount(), 0u);
+    }
+}
+
+#ifdef HISTOGRAM_HAS_POSIX
+// 测试内存映射直方图文件：写入后映射查询、移动语义以及对截断或篡改文件的校验
+TEST_F(HistogramTest, MappedHistogram) {
+    histogram::Histogram hist(-5.0f, 5.0f, 100000);
+    std::mt19937 gen(45);
+    std::normal_distribution<float> left(-2.0f, 0.5f);
+    std::normal_distribution<float> right(2.0f, 0.8f);
+    for (int i = 0; i < 200000; ++i) {
+        hist.addData(left(gen));
+        hist.addData(right(gen));
+    }
+    const std::string path = "test_output/mapped.hist";
+    histogram::MappedHistogram::write(hist, path);
+    EXPECT_EQ(fs::file_size(path), 4096u + hist.getResolution() * 8);
+
+    histogram::MappedHistogram mapped(path);
+    EXPECT_EQ(mapped.getResolution(), hist.getResolution());
+    EXPECT_EQ(mapped.getMin(), hist.getMin());
+    EXPECT_EQ(mapped.getMax(), hist.getMax());
+    EXPECT_EQ(mapped.getBinWidth(), hist.getBinWidth());
+    EXPECT_EQ(mapped.getTotalCount(), hist.getTotalCount());
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(mapped.getBinCounts()) % 4096, 0u); // 计数数组页对齐
+    EXPECT_TRUE(std::equal(hist.getBinCounts().begin(), hist.getBinCounts().end(), mapped.getBinCounts()));
+    EXPECT_EQ(mapped.getBinCount(12345), hist.getBinCount(12345));
+    EXPECT_EQ(mapped.getBinRange(777), hist.getBinRange(777));
+    EXPECT_EQ(mapped.getMaxBin(), hist.getMaxBin());
+    EXPECT_EQ(mapped.findPeaks(0.05f), hist.findPeaks(0.05f));
+
+    histogram::CDF fromMapping;
+    mapped.computeCDF(fromMapping);
+    histogram::CDF fromHistogram;
+    fromHistogram.computeFromHistogram(hist);
+    EXPECT_EQ(fromMapping.getCDFValues(), fromHistogram.getCDFValues());
+    EXPECT_EQ(fromMapping.getPercentile(50.0f), fromHistogram.getPercentile(50.0f));
+    EXPECT_EQ(mapped.toHistogram().getBinCounts(), hist.getBinCounts());
+
+    // 移动后原对象不再持有映射
+    histogram::MappedHistogram moved(std::move(mapped));
+    EXPECT_EQ(moved.getBinCount(12345), hist.getBinCount(12345));
+    EXPECT_EQ(mapped.getResolution(), 0u);
+    EXPECT_THROW(moved.getBinCount(hist.getResolution()), std::out_of_range);
+
+    // 截断或非本格式的文件
+    {
+        std::ofstream truncated("test_output/truncated.hist", std::ios::binary);
+        std::ifstream source(path, std::ios::binary);
+        std::vector<char> bytes(4096 + 100);
+        source.read(bytes.data(), bytes.size());
+        truncated.write(bytes.data(), bytes.size());
+    }
+    EXPECT_THROW(histogram::MappedHistogram("test_output/truncated.hist"), std::runtime_error);
+    {
+        std::ofstream other("test_output/not_a_histogram.hist", std::ios::binary);
+        other << std::string(8192, 'x');
+    }
+    EXPECT_THROW(histogram::MappedHistogram("test_output/not_a_histogram.hist"), std::runtime_error);
+    EXPECT_THROW(histogram::MappedHistogram("test_output/missing.hist"), std::runtime_error);
+
+    // 篡改头部：计数数组与头部重叠或不页对齐时拒绝打开；总计数不符时计算CDF报错
+    histogram::Histogram small(0.0f, 1.0f, 1024);
+    small.addData(0.25f);
+    small.addData(0.75f);
+    histogram::MappedHistogram::write(small, "test_output/small.hist");
+    auto patched = [](const std::string& name, std::vector<std::pair<size_t, uint64_t>> fields) {
+        std::ifstream source("test_output/small.hist", std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(source)), std::istreambuf_iterator<char>());
+        for (const auto& field : fields) {
+            std::memcpy(&bytes[field.first], &field.second, sizeof(uint64_t));
+        }
+        const std::string path = "test_output/" + name;
+        std::ofstream(path, std::ios::binary) << bytes;
+        return path;
+    };
+    const size_t resolutionField = 24, totalField = 32, offsetField = 40;
+    EXPECT_THROW(histogram::MappedHistogram(patched("overlap.hist", {{offsetField, 8}})), std::runtime_error);
+    EXPECT_THROW(histogram::MappedHistogram(patched("unaligned.hist", {{offsetField, 4096 + 8}, {resolutionField, 512}})),
+                 std::runtime_error);
+    histogram::MappedHistogram wrongTotal(patched("wrong_total.hist", {{totalField, 3}}));
+    EXPECT_EQ(wrongTotal.getTotalCount(), 3u);
+    histogram::CDF unchecked;
+    EXPECT_THROW(wrongTotal.computeCDF(unchecked), std::runtime_error);
+    histogram::MappedHistogram(patched("valid.hist", {})).computeCDF(unchecked);
+    EXPECT_FLOAT_EQ(unchecked.getCumulativeProbability(0.5f), 0.5f);
+
+    // 不同几何的merge会重新分箱，totalCount可能包含落在范围外的计数；写入的总计数取各bin之和
+    histogram::Histogram rebinned(1.00001e6f, 1.00002e6f, 1191);
+    histogram::Histogram other(1.00002e6f, 1.00004e6f, 2807);
+    for (size_t i = 0; i < rebinned.getResolution(); ++i) {
+        rebinned.addBinCount(i, 1);
+    }
+    for (size_t i = 0; i < other.getResolution(); ++i) {
+        other.addBinCount(i, 1);
+    }
+    rebinned.merge(other);
+    const auto& rebinnedCounts = rebinned.getBinCounts();
+    const size_t binSum = std::accumulate(rebinnedCounts.begin(), rebinnedCounts.end(), size_t(0));
+    histogram::MappedHistogram::write(rebinned, "test_output/rebinned.hist");
+    histogram::MappedHistogram rebinnedMapped("test_output/rebinned.hist");
+    EXPECT_EQ(rebinnedMapped.getTotalCount(), binSum);
+    EXPECT_NO_THROW(rebinnedMapped.computeCDF(unchecked));
+}
+
+// 测试共享内存直方图：多进程并发写入、快照、清零代号以及崩溃后清零的恢复
+TEST_F(HistogramTest, SharedHistogram) {
+    const std::string name = "/histogram_test_" + std::to_string(::getpid());
+    histogram::SharedHistogram::unlink(name);
+    auto shared = histogram::SharedHistogram::create(name, 0.0f, 10.0f, 100);
+    EXPECT_THROW(histogram::SharedHistogram::create(name, 0.0f, 10.0f, 100), std::runtime_error);
+
+    // 另一个附加点（与其他进程附加相同）看到同一份计数
+    auto reader = histogram::SharedHistogram::attach(name);
+    EXPECT_EQ(reader.getResolution(), 100u);
+    EXPECT_EQ(reader.getMin(), 0.0f);
+    EXPECT_EQ(reader.getMax(), 10.0f);
+    EXPECT_EQ(shared.getAttachedCount(), 2u);
+
+    // 多个子进程并发写入
+    const int workers = 4;
+    const int perWorker = 20000;
+    std::vector<pid_t> children;
+    for (int w = 0; w < workers; ++w) {
+        pid_t pid = ::fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            auto child = histogram::SharedHistogram::attach(name);
+            for (int i = 0; i < perWorker; ++i) {
+                child.addData(static_cast<float>(i % 100) / 10.0f + 0.05f);
+            }
+            child.detach();
+            ::_exit(0);
+        }
+        children.push_back(pid);
+    }
+    shared.addData(10.0f); // 最大值归入最后一个bin
+    shared.addData(-1.0f); // 超出范围，忽略
+    for (pid_t pid : children) {
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+
+    histogram::Histogram expected(0.0f, 10.0f, 100);
+    for (int w = 0; w < workers; ++w) {
+        for (int i = 0; i < perWorker; ++i) {
+            expected.addData(static_cast<float>(i % 100) / 10.0f + 0.05f);
+        }
+    }
+    expected.addData(10.0f);
+    auto snapshot = reader.snapshot();
+    EXPECT_EQ(snapshot.getBinCounts(), expected.getBinCounts());
+    EXPECT_EQ(reader.getTotalCount(), expected.getTotalCount());
+    EXPECT_EQ(snapshot.getTotalCount(), expected.getTotalCount());
+    EXPECT_EQ(shared.getAttachedCount(), 2u);
+
+    // 清零递增代号
+    uint64_t generation = reader.getGeneration();
+    shared.clear();
+    EXPECT_EQ(reader.getGeneration(), generation + 2);
+    EXPECT_EQ(reader.getTotalCount(), 0u);
+    EXPECT_EQ(reader.getBinCount(50), 0u);
+
+    // 模拟在clear()中途崩溃的进程：代号停在奇数。snapshot()超时后抛出，再次clear()接管并完成清零
+    {
+        int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        ASSERT_GE(fd, 0);
+        void* raw = ::mmap(nullptr, 64, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        ASSERT_NE(raw, MAP_FAILED);
+        const size_t generationField = 24;
+        reinterpret_cast<std::atomic<uint64_t>*>(static_cast<char*>(raw) + generationField)->fetch_add(1);
+        ::munmap(raw, 64);
+    }
+    shared.addData(5.0f); // 崩溃进程已清零的部分之后写入的计数
+    EXPECT_EQ(reader.getGeneration() & 1, 1u);
+    EXPECT_THROW(reader.snapshot(), std::runtime_error);
+    reader.clear();
+    EXPECT_EQ(reader.getGeneration(), generation + 4);
+    EXPECT_EQ(reader.snapshot().getTotalCount(), 0u);
+    shared.clear();
+    EXPECT_EQ(reader.getGeneration(), generation + 6);
+
+    reader.detach();
+    EXPECT_FALSE(reader.isAttached());
+    EXPECT_EQ(shared.getAttachedCount(), 1u);
+    EXPECT_THROW(reader.snapshot(), std::logic_error);
+    EXPECT_TRUE(histogram::SharedHistogram::unlink(name));
+    EXPECT_THROW(histogram::SharedHistogram::attach(name), std::runtime_error);
+    shared.addData(1.0f); // 删除对象后已有的映射仍然可用
+    EXPECT_EQ(shared.getTotalCount(), 1u);
+}
+
+// 测试批量导入：与逐个添加一致，CSV、文本和二进制输入在任意块大小下结果相同
+TEST_F(HistogramTest, Ingestor) {
+    using Format = histogram::Ingestor::Format;
+    std::mt19937 gen(47);
+    std::normal_distribution<float> dist(50.0f, 15.0f);
+    std::vector<float> values(20000);
+    for (auto& v : values) {
+        v = dist(gen);
+    }
+
+    // 批量添加与逐个添加一致（含最大值、越界值和NaN）
+    histogram::Histogram expected(0.0f, 100.0f, 1000);
+    for (float v : values) {
+        expected.addData(v);
+    }
+    std::vector<float> batch = values;
+    batch.push_back(100.0f);
+    batch.push_back(-1.0f);
+    batch.push_back(std::numeric_limits<float>::quiet_NaN());
+    expected.addData(100.0f);
+    for (unsigned threads : {1u, 4u}) {
+        histogram::Histogram filled(0.0f, 100.0f, 1000);
+        filled.addData(batch.data(), batch.size(), threads);
+        EXPECT_EQ(filled.getBinCounts(), expected.getBinCounts());
+        EXPECT_EQ(filled.getTotalCount(), expected.getTotalCount());
+    }
+    expected.clear();
+    for (float v : values) {
+        expected.addData(v);
+    }
+
+    // CSV：表头、CRLF、空行、空白和前导'+'；读取第二列
+    std::ostringstream csv;
+    csv << std::setprecision(9) << "id,value,tag\r\n";
+    for (size_t i = 0; i < values.size(); ++i) {
+        csv << i << ", " << (i % 7 == 0 ? "+" : "") << values[i] << " ,x" << (i % 3 == 0 ? "\r\n" : "\n");
+        if (i % 1000 == 0) {
+            csv << "\n";
+        }
+    }
+    csv << "1,bad,x\n7"; // 一条无法解析、一条列数不足，最后一行没有换行
+    const std::string text = csv.str();
+
+    histogram::Ingestor ingestor(Format::Text, 4);
+    ingestor.setColumn(1);
+    // 块大小不同（包括小于一行）时结果相同
+    for (size_t chunkSize : {size_t(0), size_t(7), size_t(1000), size_t(65536)}) {
+        ingestor.setChunkSize(chunkSize);
+        histogram::Histogram hist(0.0f, 100.0f, 1000);
+        auto stats = ingestor.ingest(text.data(), text.size(), hist);
+        EXPECT_EQ(stats.bytes, text.size());
+        EXPECT_EQ(stats.values, values.size()) << chunkSize;
+        EXPECT_EQ(stats.skipped, 3u) << chunkSize;
+        EXPECT_EQ(hist.getBinCounts(), expected.getBinCounts()) << chunkSize;
+    }
+
+    // 只扫描范围，不写入直方图
+    auto scanned = ingestor.scan(text.data(), text.size());
+    EXPECT_EQ(scanned.values, values.size());
+    EXPECT_EQ(scanned.minValue, *std::min_element(values.begin(), values.end()));
+    EXPECT_EQ(scanned.maxValue, *std::max_element(values.begin(), values.end()));
+
+    // 单列文本文件
+    {
+        std::ofstream file("test_output/values.txt");
+        file << std::setprecision(9);
+        for (float v : values) {
+            file << v << "\n";
+        }
+    }
+    histogram::Histogram fromText(0.0f, 100.0f, 1000);
+    histogram::Ingestor(Format::Text, 2).ingestFile("test_output/values.txt", fromText);
+    EXPECT_EQ(fromText.getBinCounts(), expected.getBinCounts());
+
+    // 二进制float32/float64文件
+    {
+        std::ofstream f32("test_output/values.f32", std::ios::binary);
+        std::ofstream f64("test_output/values.f64", std::ios::binary);
+        for (float v : values) {
+            double wide = v;
+            f32.write(reinterpret_cast<const char*>(&v), sizeof(v));
+            f64.write(reinterpret_cast<const char*>(&wide), sizeof(wide));
+        }
+    }
+    for (auto [format, path] : {std::make_pair(Format::Float32, "test_output/values.f32"),
+                                std::make_pair(Format::Float64, "test_output/values.f64")}) {
+        histogram::Ingestor binary(format, 3);
+        binary.setChunkSize(1001); // 按值的字节数向下对齐
+        histogram::Histogram hist(0.0f, 100.0f, 1000);
+        auto stats = binary.ingestFile(path, hist);
+        EXPECT_EQ(stats.values, values.size());
+        EXPECT_EQ(hist.getBinCounts(), expected.getBinCounts());
+    }
+
+    histogram::Histogram unused(0.0f, 1.0f, 10);
+    EXPECT_THROW(histogram::Ingestor(Format::Float64).ingest(text.data(), 12, unused), std::runtime_error);
+    EXPECT_THROW(histogram::Ingestor().ingestFile("test_output/missing.txt", unused), std::runtime_error);
+    EXPECT_EQ(histogram::Ingestor().ingest(nullptr, 0, unused).values, 0u);
+}
+#endif // HISTOGRAM_HAS_POSIX
+
+// 测试OpenMetrics导出：bucket累计计数、标签转义、le阶梯合并以及_sum的省略
+TEST_F(HistogramTest, OpenMetricsExporter) {
+    histogram::Histogram hist(0.0f, 4.0f, 4);
+    for (float v : {0.5f, 1.5f, 1.5f, 2.5f, 3.5f, 4.0f}) {
+        hist.addData(v);
+    }
+
+    // 每个bin一个bucket，le为bin的上边界
+    histogram::OpenMetricsExporter exporter("latency_seconds", "Request \"latency\"");
+    EXPECT_EQ(exporter.addSeries({{"job", "api"}, {"path", "a\\b\n"}}), 0u);
+    EXPECT_EQ(exporter.addSeries(), 1u);
+    std::string output;
+    exporter.write({&hist, &hist}, output);
+    histogram::OpenMetricsExporter::writeEOF(output);
+    EXPECT_EQ(output,
+              "# TYPE latency_seconds histogram\n"
+              "# HELP latency_seconds Request \\\"latency\\\"\n"
+              "latency_seconds_bucket{job=\"api\",path=\"a\\\\b\\n\",le=\"1\"} 1\n"
+              "latency_seconds_bucket{job=\"api\",path=\"a\\\\b\\n\",le=\"2\"} 3\n"
+              "latency_seconds_bucket{job=\"api\",path=\"a\\\\b\\n\",le=\"3\"} 4\n"
+              "latency_seconds_bucket{job=\"api\",path=\"a\\\\b\\n\",le=\"4\"} 6\n"
+              "latency_seconds_bucket{job=\"api\",path=\"a\\\\b\\n\",le=\"+Inf\"} 6\n"
+              "latency_seconds_sum{job=\"api\",path=\"a\\\\b\\n\"} 13\n"
+              "latency_seconds_count{job=\"api\",path=\"a\\\\b\\n\"} 6\n"
+              "latency_seconds_bucket{le=\"1\"} 1\n"
+              "latency_seconds_bucket{le=\"2\"} 3\n"
+              "latency_seconds_bucket{le=\"3\"} 4\n"
+              "latency_seconds_bucket{le=\"4\"} 6\n"
+              "latency_seconds_bucket{le=\"+Inf\"} 6\n"
+              "latency_seconds_sum 13\n"
+              "latency_seconds_count 6\n"
+              "# EOF\n");
+
+    // 合并到le阶梯：跨越边界的bin计入下一个bucket，低于最小值的bucket为0
+    exporter.setBuckets({-1.0f, 0.5f, 2.0f, 10.0f});
+    output.clear();
+    exporter.writeSeries(1, hist, output);
+    EXPECT_EQ(output,
+              "latency_seconds_bucket{le=\"-1\"} 0\n"
+              "latency_seconds_bucket{le=\"0.5\"} 0\n"
+              "latency_seconds_bucket{le=\"2\"} 3\n"
+              "latency_seconds_bucket{le=\"10\"} 6\n"
+              "latency_seconds_bucket{le=\"+Inf\"} 6\n"
+              "latency_seconds_count 6\n"); // 有负的le，省略_sum
+    exporter.setBuckets({0.5f, 2.0f});
+    output.clear();
+    exporter.writeSeries(1, hist, output);
+    EXPECT_EQ(output,
+              "latency_seconds_bucket{le=\"0.5\"} 0\n"
+              "latency_seconds_bucket{le=\"2\"} 3\n"
+              "latency_seconds_bucket{le=\"+Inf\"} 6\n"
+              "latency_seconds_sum 13\n"
+              "latency_seconds_count 6\n");
+
+    // 最小值为负的直方图同样省略_sum
+    histogram::Histogram negative(-2.0f, 2.0f, 2);
+    negative.addData(-1.0f);
+    negative.addData(1.0f);
+    exporter.setBuckets({});
+    output.clear();
+    exporter.writeSeries(1, negative, output);
+    EXPECT_EQ(output,
+              "latency_seconds_bucket{le=\"0\"} 1\n"
+              "latency_seconds_bucket{le=\"2\"} 2\n"
+              "latency_seconds_bucket{le=\"+Inf\"} 2\n"
+              "latency_seconds_count 2\n");
+
+    // 几何不同的直方图使用各自的bucket划分；复用缓冲区时不再分配
+    std::mt19937 gen(49);
+    std::normal_distribution<float> dist(50.0f, 15.0f);
+    histogram::Histogram fine(0.0f, 100.0f, 1000);
+    for (int i = 0; i < 10000; ++i) {
+        fine.addData(dist(gen));
+    }
+    exporter.setBuckets({25.0f, 50.0f, 75.0f});
+    output.clear();
+    exporter.writeSeries(1, fine, output);
+    const auto& counts = fine.getBinCounts();
+    std::ostringstream expected;
+    expected << "latency_seconds_bucket{le=\"25\"} " << std::accumulate(counts.begin(), counts.begin() + 250, size_t(0)) << "\n"
+             << "latency_seconds_bucket{le=\"50\"} " << std::accumulate(counts.begin(), counts.begin() + 500, size_t(0)) << "\n"
+             << "latency_seconds_bucket{le=\"75\"} " << std::accumulate(counts.begin(), counts.begin() + 750, size_t(0)) << "\n"
+             << "latency_seconds_bucket{le=\"+Inf\"} " << fine.getTotalCount() << "\n";
+    EXPECT_EQ(output.substr(0, expected.str().size()), expected.str());
+    const size_t capacity = output.capacity();
+    const char* buffer = output.data();
+    output.clear();
+    exporter.writeSeries(1, fine, output);
+    EXPECT_EQ(output.capacity(), capacity);
+    EXPECT_EQ(output.data(), buffer);
+
+    EXPECT_THROW(histogram::OpenMetricsExporter("1bad"), std::invalid_argument);
+    EXPECT_THROW(exporter.addSeries({{"le", "1"}}), std::invalid_argument);
+    EXPECT_THROW(exporter.setBuckets({2.0f, 1.0f}), std::invalid_argument);
+    EXPECT_THROW(exporter.writeSeries(5, hist, output), std::out_of_range);
+    EXPECT_THROW(exporter.write({&hist}, output), std::invalid_argument);
+}
+
+// 测试变宽压缩直方图：分位误差和总变差距离不超过上界，最优划分与穷举一致，序列化往返
+TEST_F(HistogramTest, CompactHistogram) {
+    using histogram::CompactHistogram;
+    std::mt19937 gen(50);
+    std::normal_distribution<float> dist(50.0f, 10.0f);
+    histogram::Histogram hist(0.0f, 100.0f, 5000);
+    for (int i = 0; i < 200000; ++i) {
+        hist.addData(dist(gen));
+    }
+    const auto& bins = hist.getBinCounts();
+    const double total = static_cast<double>(hist.getTotalCount());
+
+    // 原直方图在第j个bin边界处的CDF与压缩结果之差
+    auto maxRankError = [&](const CompactHistogram& compact) {
+        double cumulative = 0.0;
+        double worst = 0.0;
+        for (size_t j = 0; j <= bins.size(); ++j) {
+            const float edge = (j == bins.size()) ? hist.getMax() : hist.getMin() + j * hist.getBinWidth();
+            worst = std::max(worst, std::abs(cumulative / total - compact.getCumulativeProbability(edge)));
+            if (j < bins.size()) {
+                cumulative += bins[j];
+            }
+        }
+        return worst;
+    };
+
+    // 误差为0时只合并计数相同的bin（两端的空bin），无损
+    auto lossless = CompactHistogram::compactByQuantileError(hist, 0.0);
+    EXPECT_LT(lossless.getResolution(), bins.size());
+    EXPECT_EQ(lossless.toHistogram().getBinCounts(), bins);
+    histogram::CDF cdf;
+    cdf.computeFromHistogram(hist);
+    for (float p : {1.0f, 10.0f, 50.0f, 90.0f, 99.0f}) {
+        EXPECT_NEAR(lossless.getPercentile(p), cdf.getPercentile(p), 0.02f) << p;
+    }
+
+    for (double epsilon : {1e-4, 1e-3, 1e-2}) {
+        auto greedy = CompactHistogram::compactByQuantileError(hist, epsilon);
+        auto optimal = CompactHistogram::compactByQuantileError(hist, epsilon, true);
+        EXPECT_LE(maxRankError(greedy), epsilon + 1e-5) << epsilon;
+        EXPECT_LE(maxRankError(optimal), epsilon + 1e-5) << epsilon;
+        EXPECT_LE(optimal.getResolution(), greedy.getResolution());
+        EXPECT_EQ(greedy.getTotalCount(), hist.getTotalCount());
+        EXPECT_EQ(greedy.getEdges().front(), 0u);
+        EXPECT_EQ(greedy.getEdges().back(), bins.size());
+        // 百分位的秩误差同样有界
+        for (float p : {5.0f, 50.0f, 95.0f}) {
+            EXPECT_NEAR(cdf.getCumulativeProbability(greedy.getPercentile(p)), p / 100.0f, epsilon + 2e-3);
+        }
+    }
+    EXPECT_LT(CompactHistogram::compactByQuantileError(hist, 1e-3).getResolution() * 10, bins.size());
+
+    // 小直方图上与穷举所有划分的最少bucket数一致
+    histogram::Histogram small(0.0f, 12.0f, 12);
+    const size_t smallCounts[] = {0, 3, 7, 2, 9, 9, 9, 4, 0, 1, 6, 2};
+    for (size_t i = 0; i < 12; ++i) {
+        small.addBinCount(i, smallCounts[i]);
+    }
+    for (double epsilon : {0.0, 0.02, 0.05, 0.1, 0.3}) {
+        std::vector<double> c(13, 0.0);
+        for (size_t i = 0; i < 12; ++i) {
+            c[i + 1] = c[i] + smallCounts[i];
+        }
+        size_t bruteForce = 12;
+        for (unsigned mask = 0; mask < (1u << 11); ++mask) {
+            std::vector<size_t> edges = {0};
+            for (size_t i = 1; i < 12; ++i) {
+                if (mask & (1u << (i - 1))) {
+                    edges.push_back(i);
+                }
+            }
+            edges.push_back(12);
+            bool feasible = true;
+            for (size_t k = 0; k + 1 < edges.size() && feasible; ++k) {
+                const size_t a = edges[k];
+                const size_t b = edges[k + 1];
+                for (size_t j = a + 1; j < b; ++j) {
+                    const double chord = c[a] + (c[b] - c[a]) * (j - a) / (b - a);
+                    feasible = feasible && std::abs(c[j] - chord) <= epsilon * c[12] + 1e-9;
+                }
+            }
+            if (feasible) {
+                bruteForce = std::min(bruteForce, edges.size() - 1);
+            }
+        }
+        EXPECT_EQ(CompactHistogram::compactByQuantileError(small, epsilon, true).getResolution(), bruteForce) << epsilon;
+    }
+
+    // 总变差距离：在原始bin上的均匀展开与原分布的距离不超过上界，上界越大bucket越少
+    size_t previous = bins.size() + 1;
+    for (double distance : {0.0, 0.01, 0.05, 0.2}) {
+        auto compact = CompactHistogram::compactByTotalVariation(hist, distance);
+        double tv = 0.0;
+        for (size_t k = 0; k < compact.getResolution(); ++k) {
+            const auto& edges = compact.getEdges();
+            const double mean = static_cast<double>(compact.getBucketCount(k)) / (edges[k + 1] - edges[k]);
+            for (size_t i = edges[k]; i < edges[k + 1]; ++i) {
+                tv += std::abs(bins[i] - mean);
+            }
+        }
+        EXPECT_LE(tv / (2.0 * total), distance + 1e-9) << distance;
+        EXPECT_LT(compact.getResolution(), previous);
+        previous = compact.getResolution();
+    }
+    EXPECT_EQ(CompactHistogram::compactByTotalVariation(hist, 0.0).toHistogram().getBinCounts(), bins);
+
+    // 不同几何merge后totalCount包含落在范围外的计数，预算按各bin之和计算，否则会超出距离上界
+    histogram::Histogram rebinned(1.00001e6f, 1.00002e6f, 1191);
+    histogram::Histogram other(1.00002e6f, 1.00004e6f, 2807);
+    for (size_t i = 0; i < rebinned.getResolution(); ++i) {
+        rebinned.addBinCount(i, 1);
+    }
+    for (size_t i = 0; i < other.getResolution(); ++i) {
+        other.addBinCount(i, i + 1 == other.getResolution() ? 1000 : 1);
+    }
+    rebinned.merge(other);
+    const auto& rebinnedBins = rebinned.getBinCounts();
+    const double rebinnedSum = std::accumulate(rebinnedBins.begin(), rebinnedBins.end(), 0.0);
+    ASSERT_GT(static_cast<double>(rebinned.getTotalCount()), rebinnedSum);
+    auto rebinnedCompact = CompactHistogram::compactByTotalVariation(rebinned, 0.05);
+    const auto& rebinnedEdges = rebinnedCompact.getEdges();
+    double rebinnedTv = 0.0;
+    for (size_t k = 0; k < rebinnedCompact.getResolution(); ++k) {
+        const double mean =
+            static_cast<double>(rebinnedCompact.getBucketCount(k)) / (rebinnedEdges[k + 1] - rebinnedEdges[k]);
+        for (size_t i = rebinnedEdges[k]; i < rebinnedEdges[k + 1]; ++i) {
+            rebinnedTv += std::abs(rebinnedBins[i] - mean);
+        }
+    }
+    EXPECT_LE(rebinnedTv / (2.0 * rebinnedSum), 0.05 + 1e-9);
+
+    // 序列化往返
+    auto compact = CompactHistogram::compactByQuantileError(hist, 1e-3);
+    std::string encoded;
+    compact.serialize(encoded);
+    auto decoded = CompactHistogram::deserialize(encoded.data(), encoded.size());
+    EXPECT_EQ(decoded.getEdges(), compact.getEdges());
+    EXPECT_EQ(decoded.getTotalCount(), compact.getTotalCount());
+    EXPECT_EQ(decoded.getPercentile(50.0f), compact.getPercentile(50.0f));
+    EXPECT_EQ(decoded.getBucketRange(3), compact.getBucketRange(3));
+    std::string full;
+    hist.serialize(full);
+    EXPECT_LT(encoded.size() * 10, full.size());
+    EXPECT_THROW(CompactHistogram::deserialize(encoded.data(), encoded.size() - 1), std::runtime_error);
+    EXPECT_THROW(CompactHistogram::deserialize(full.data(), full.size()), std::runtime_error);
+    // 头部声称2^40个bin和2^40个bucket而没有数据，必须在预留空间之前拒绝
+    const std::string huge = "\x80\x80\x80\x80\x80\x20"; // LEB128编码的2^40
+    std::string forged = encoded.substr(0, 13) + huge + '\0' + huge;
+    EXPECT_THROW(CompactHistogram::deserialize(forged.data(), forged.size()), std::runtime_error);
+
+    EXPECT_THROW(CompactHistogram::compactByQuantileError(hist, -1.0), std::invalid_argument);
+    EXPECT_THROW(CompactHistogram::compactByTotalVariation(hist, std::nan("")), std::invalid_argument);
+    EXPECT_THROW(compact.getPercentile(101.0f), std::invalid_argument);
+    EXPECT_THROW(compact.getBucketCount(compact.getResolution()), std::out_of_range);
+    EXPECT_THROW(CompactHistogram::compactByQuantileError(histogram::Histogram(0.0f, 1.0f, 10), 0.1).getPercentile(50.0f),
+                 std::runtime_error);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
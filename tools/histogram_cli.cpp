@@ -0,0 +1,513 @@
+#include "Histogram.hpp"
+#include "CDF.hpp"
+#include "CSVExporter.hpp"
+#include "Ingestor.hpp"
+#include "Parallel.hpp"
+#include "SVGExporter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+using histogram::Histogram;
+using histogram::Ingestor;
+using Clock = std::chrono::steady_clock;
+
+// 从标准输入流式读入时每块的默认字节数
+constexpr size_t kStdinBlockSize = size_t(32) << 20;
+
+const char* kUsage =
+    "用法: histogram-cli [选项] [文件 ...]\n"
+    "\n"
+    "从文件或标准输入（无文件或文件为'-'）读入数值并构建直方图。\n"
+    "\n"
+    "输入:\n"
+    "  --format text|f32|f64   输入格式：换行分隔的文本/CSV、小端float32、小端float64（默认text）\n"
+    "  --column N              CSV中读取的列（从0开始，默认0）\n"
+    "  --delimiter C           CSV字段分隔符（默认','）\n"
+    "  --threads N             解析线程数（默认0，使用硬件并发数）\n"
+    "  --block-size N          从标准输入流式读入时每块的字节数（默认33554432）\n"
+    "\n"
+    "直方图:\n"
+    "  --min V --max V         值范围；省略时先扫描一遍输入自动确定\n"
+    "                          （标准输入需要先完整读入内存，流式处理请指定范围）\n"
+    "  --bins N                bin数量（默认1000）\n"
+    "  --merge                 输入为--binary输出的序列化直方图，并行合并（范围和bin数取自输入）\n"
+    "\n"
+    "输出（'-'表示标准输出）:\n"
+    "  --percentiles P,P,...   输出指定百分位\n"
+    "  --peaks                 输出波峰（最小突出度见--prominence，默认0.1）\n"
+    "  --prominence P          波峰的最小突出度（相对最大bin，0-1）\n"
+    "  --csv PATH              直方图和CDF的CSV\n"
+    "  --binary PATH           紧凑二进制格式（可用--merge合并）\n"
+    "  --delta                 二进制格式使用差分编码\n"
+    "  --svg PATH              直方图SVG\n"
+    "  --stats                 在标准错误输出吞吐量和各阶段耗时\n"
+    "  -h, --help              显示帮助\n"
+    "\n"
+    "未指定任何输出时打印摘要（总数、范围、常用百分位和波峰）。\n";
+
+/**
+ * @brief 命令行参数错误
+ */
+class UsageError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+struct Options {
+    bool hasMin = false;
+    bool hasMax = false;
+    float min = 0.0f;
+    float max = 0.0f;
+    size_t bins = 1000;
+    Ingestor::Format format = Ingestor::Format::Text;
+    size_t column = 0;
+    char delimiter = ',';
+    unsigned threads = 0;
+    size_t blockSize = kStdinBlockSize;
+    bool merge = false;
+    std::vector<float> percentiles;
+    bool peaks = false;
+    float prominence = 0.1f;
+    std::string csvPath;
+    std::string binaryPath;
+    std::string svgPath;
+    bool delta = false;
+    bool stats = false;
+    std::vector<std::string> inputs;
+};
+
+/**
+ * @brief 各阶段耗时和读入统计，--stats时输出
+ */
+struct Timings {
+    double scan = 0.0;
+    double ingest = 0.0;
+    double merge = 0.0;
+    double output = 0.0;
+    size_t bytes = 0;
+    size_t values = 0;
+    size_t skipped = 0;
+};
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+template <typename T>
+T parseNumber(const std::string& option, const std::string& text) {
+    // 流提取无符号数时接受负号并按模回绕（"-1"得到最大值），这里直接拒绝
+    if (std::is_unsigned<T>::value) {
+        const size_t first = text.find_first_not_of(" \t\n\v\f\r");
+        if (first != std::string::npos && text[first] == '-') {
+            throw UsageError("无效的" + option + "参数: " + text);
+        }
+    }
+    std::istringstream stream(text);
+    T value;
+    if (!(stream >> value) || !stream.eof()) {
+        throw UsageError("无效的" + option + "参数: " + text);
+    }
+    return value;
+}
+
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw UsageError(arg + "缺少参数");
+            }
+            return argv[++i];
+        };
+
+        if (arg == "-h" || arg == "--help") {
+            std::cout << kUsage;
+            std::exit(0);
+        } else if (arg == "--min") {
+            options.min = parseNumber<float>(arg, value());
+            options.hasMin = true;
+        } else if (arg == "--max") {
+            options.max = parseNumber<float>(arg, value());
+            options.hasMax = true;
+        } else if (arg == "--bins") {
+            options.bins = parseNumber<size_t>(arg, value());
+        } else if (arg == "--format") {
+            const std::string format = value();
+            if (format == "text") {
+                options.format = Ingestor::Format::Text;
+            } else if (format == "f32") {
+                options.format = Ingestor::Format::Float32;
+            } else if (format == "f64") {
+                options.format = Ingestor::Format::Float64;
+            } else {
+                throw UsageError("未知的输入格式: " + format);
+            }
+        } else if (arg == "--column") {
+            options.column = parseNumber<size_t>(arg, value());
+        } else if (arg == "--delimiter") {
+            const std::string delimiter = value();
+            if (delimiter.size() != 1) {
+                throw UsageError("分隔符必须是单个字符");
+            }
+            options.delimiter = delimiter[0];
+        } else if (arg == "--threads") {
+            options.threads = parseNumber<unsigned>(arg, value());
+        } else if (arg == "--block-size") {
+            options.blockSize = parseNumber<size_t>(arg, value());
+        } else if (arg == "--merge") {
+            options.merge = true;
+        } else if (arg == "--percentiles") {
+            std::istringstream list(value());
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                float percentile = parseNumber<float>("--percentiles", item);
+                if (!(percentile >= 0.0f && percentile <= 100.0f)) {
+                    throw UsageError("百分位必须在0到100之间: " + item);
+                }
+                options.percentiles.push_back(percentile);
+            }
+        } else if (arg == "--peaks") {
+            options.peaks = true;
+        } else if (arg == "--prominence") {
+            options.prominence = parseNumber<float>(arg, value());
+        } else if (arg == "--csv") {
+            options.csvPath = value();
+        } else if (arg == "--binary") {
+            options.binaryPath = value();
+        } else if (arg == "--svg") {
+            options.svgPath = value();
+        } else if (arg == "--delta") {
+            options.delta = true;
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg.size() > 1 && arg[0] == '-' && arg != "-") {
+            throw UsageError("未知选项: " + arg);
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+
+    if (options.inputs.empty()) {
+        options.inputs.push_back("-");
+    }
+    if (options.hasMin != options.hasMax) {
+        throw UsageError("--min和--max必须同时指定");
+    }
+    if (options.hasMin && !(options.min < options.max)) {
+        throw UsageError("--min必须小于--max");
+    }
+    if (options.bins == 0) {
+        throw UsageError("--bins必须大于0");
+    }
+    if (options.blockSize == 0) {
+        throw UsageError("--block-size必须大于0");
+    }
+    int toStdout = (options.csvPath == "-") + (options.binaryPath == "-") + (options.svgPath == "-");
+    if (toStdout > 1) {
+        throw UsageError("只能有一个输出写到标准输出");
+    }
+    return options;
+}
+
+/**
+ * @brief 读入整个文件（或标准输入）
+ */
+std::string readAll(const std::string& path) {
+    std::string data;
+    if (path == "-") {
+        std::vector<char> block(kStdinBlockSize);
+        size_t got;
+        while ((got = std::fread(block.data(), 1, block.size(), stdin)) > 0) {
+            data.append(block.data(), got);
+        }
+        return data;
+    }
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + path);
+    }
+    data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(&data[0], static_cast<std::streamsize>(data.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to read file: " + path);
+    }
+    return data;
+}
+
+void accumulate(Timings& timings, const Ingestor::Stats& stats) {
+    timings.bytes += stats.bytes;
+    timings.values += stats.values;
+    timings.skipped += stats.skipped;
+}
+
+/**
+ * @brief 从标准输入按块流式读入：每块只处理到最后一个完整记录，剩余部分并入下一块
+ * @param blockSize 块的初始字节数，单条记录比块还长时加倍
+ */
+void ingestStdin(const Ingestor& ingestor, size_t blockSize, Histogram& hist, Timings& timings) {
+    const size_t valueSize = ingestor.getFormat() == Ingestor::Format::Float32 ? 4
+                           : ingestor.getFormat() == Ingestor::Format::Float64 ? 8 : 1;
+    std::vector<char> buffer(blockSize);
+    size_t carried = 0;
+    for (;;) {
+        const size_t got = std::fread(buffer.data() + carried, 1, buffer.size() - carried, stdin);
+        const size_t filled = carried + got;
+        const bool eof = got == 0;
+        size_t complete = filled;
+        if (!eof) {
+            if (valueSize == 1) {
+                // 反向查找最后一个换行符（memrchr是GNU扩展）
+                auto last = std::find(std::make_reverse_iterator(buffer.begin() + filled),
+                                      std::make_reverse_iterator(buffer.begin()), '\n');
+                complete = static_cast<size_t>(last.base() - buffer.begin()); // 未找到时为0
+            } else {
+                complete = filled / valueSize * valueSize;
+            }
+            if (complete == 0) {
+                buffer.resize(buffer.size() * 2); // 单条记录比块还长
+                carried = filled;
+                continue;
+            }
+        }
+        accumulate(timings, ingestor.ingest(buffer.data(), complete, hist));
+        carried = filled - complete;
+        std::memmove(buffer.data(), buffer.data() + complete, carried);
+        if (eof) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief 读入数值构建直方图；未指定范围时先扫描一遍
+ */
+Histogram buildHistogram(const Options& options, Timings& timings) {
+    Ingestor ingestor(options.format, options.threads);
+    ingestor.setColumn(options.column);
+    ingestor.setDelimiter(options.delimiter);
+
+    // 自动范围时标准输入要读两遍，只能先读入内存
+    std::string stdinData;
+    bool stdinBuffered = false;
+    float min = options.min;
+    float max = options.max;
+    if (!options.hasMin) {
+        auto start = Clock::now();
+        float low = std::numeric_limits<float>::infinity();
+        float high = -std::numeric_limits<float>::infinity();
+        for (const auto& input : options.inputs) {
+            Ingestor::Stats stats;
+            if (input == "-") {
+                if (!stdinBuffered) {
+                    stdinData = readAll("-");
+                    stdinBuffered = true;
+                }
+                stats = ingestor.scan(stdinData.data(), stdinData.size());
+            } else {
+                stats = ingestor.scanFile(input);
+            }
+            low = std::min(low, stats.minValue);
+            high = std::max(high, stats.maxValue);
+        }
+        if (low > high) {
+            throw std::runtime_error("No values in input");
+        }
+        if (low == high) {
+            low -= 0.5f;
+            high += 0.5f;
+        }
+        min = low;
+        max = high;
+        timings.scan = secondsSince(start);
+    }
+
+    Histogram hist(min, max, options.bins);
+    auto start = Clock::now();
+    for (const auto& input : options.inputs) {
+        if (input != "-") {
+            accumulate(timings, ingestor.ingestFile(input, hist));
+        } else if (stdinBuffered) {
+            accumulate(timings, ingestor.ingest(stdinData.data(), stdinData.size(), hist));
+        } else {
+            ingestStdin(ingestor, options.blockSize, hist, timings);
+        }
+    }
+    timings.ingest = secondsSince(start);
+    return hist;
+}
+
+/**
+ * @brief 并行合并序列化的直方图：每个线程合并一段连续的输入，最后合并各线程的结果
+ */
+Histogram mergeSerialized(const Options& options, Timings& timings) {
+    auto start = Clock::now();
+    std::unique_ptr<Histogram> result;
+    std::mutex mutex;
+    const auto& inputs = options.inputs;
+    histogram::detail::parallelFor(inputs.size(), 1, options.threads, [&](size_t begin, size_t end) {
+        size_t bytes = 0;
+        std::string data = readAll(inputs[begin]);
+        bytes += data.size();
+        Histogram partial = Histogram::deserialize(data.data(), data.size());
+        for (size_t i = begin + 1; i < end; ++i) {
+            data = readAll(inputs[i]);
+            bytes += data.size();
+            partial.mergeFromSerialized(data.data(), data.size());
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        timings.bytes += bytes;
+        if (!result) {
+            result.reset(new Histogram(std::move(partial)));
+        } else {
+            // Histogram::merge会对不同几何重新分箱，这里与mergeFromSerialized一样要求完全一致
+            if (partial.getMin() != result->getMin() || partial.getMax() != result->getMax() ||
+                partial.getResolution() != result->getResolution()) {
+                throw std::invalid_argument("Serialized histogram has a different range or resolution");
+            }
+            result->merge(partial);
+        }
+    });
+    timings.values = result->getTotalCount();
+    timings.merge = secondsSince(start);
+    return std::move(*result);
+}
+
+/**
+ * @brief 写到文件或标准输出
+ */
+void writeOutput(const std::string& path, const std::string& data) {
+    if (path == "-") {
+        std::fwrite(data.data(), 1, data.size(), stdout);
+        return;
+    }
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + path);
+    }
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write file: " + path);
+    }
+}
+
+void writeReport(const Options& options, const Histogram& hist, const histogram::CDF* cdf, std::ostream& out) {
+    const bool summary = options.percentiles.empty() && !options.peaks;
+    if (summary) {
+        out << "count " << hist.getTotalCount() << "\n";
+        out << "range " << hist.getMin() << " " << hist.getMax() << "\n";
+        out << "bins " << hist.getResolution() << "\n";
+    }
+
+    std::vector<float> percentiles = options.percentiles;
+    if (summary) {
+        percentiles = {1.0f, 50.0f, 90.0f, 99.0f, 99.9f};
+    }
+    if (cdf != nullptr) {
+        for (float percentile : percentiles) {
+            out << "p" << percentile << " " << cdf->getPercentile(percentile) << "\n";
+        }
+    }
+
+    if (summary || options.peaks) {
+        for (const auto& peak : hist.getPeaksInfo(options.prominence)) {
+            const auto& range = std::get<2>(peak);
+            out << "peak " << std::get<0>(peak) << " [" << range.first << ", " << range.second << ") "
+                << std::get<1>(peak) << "\n";
+        }
+    }
+}
+
+void writeOutputs(const Options& options, const Histogram& hist) {
+    std::unique_ptr<histogram::CDF> cdf;
+    if (hist.getTotalCount() > 0) {
+        cdf.reset(new histogram::CDF());
+        cdf->computeFromHistogram(hist);
+    }
+
+    if (!options.csvPath.empty()) {
+        if (!cdf) {
+            throw std::runtime_error("Histogram has no data");
+        }
+        if (options.csvPath == "-") {
+            histogram::CSVExporter::writeHistogramAndCDF(hist, *cdf, [](const char* data, size_t size) {
+                std::fwrite(data, 1, size, stdout);
+            }, false, options.threads);
+        } else {
+            histogram::CSVExporter::exportHistogramAndCDFToFile(hist, *cdf, options.csvPath, false, options.threads);
+        }
+    }
+    if (!options.binaryPath.empty()) {
+        std::string encoded;
+        hist.serialize(encoded, options.delta);
+        writeOutput(options.binaryPath, encoded);
+    }
+    if (!options.svgPath.empty()) {
+        histogram::SVGExporter::exportHistogram(hist, options.svgPath == "-" ? "/dev/stdout" : options.svgPath);
+    }
+
+    const bool anyFile = !options.csvPath.empty() || !options.binaryPath.empty() || !options.svgPath.empty();
+    if (!options.percentiles.empty() || options.peaks || !anyFile) {
+        // 有输出写到标准输出时，报告改写到标准错误
+        const bool stdoutTaken = options.csvPath == "-" || options.binaryPath == "-" || options.svgPath == "-";
+        writeReport(options, hist, cdf.get(), stdoutTaken ? std::cerr : std::cout);
+    }
+}
+
+void printStats(const Timings& timings, double total) {
+    const double megabytes = timings.bytes / double(1 << 20);
+    std::fprintf(stderr, "histogram-cli: %.1f MB, %zu values, %zu skipped, %.3f s total",
+                 megabytes, timings.values, timings.skipped, total);
+    const double busy = timings.scan + timings.ingest + timings.merge;
+    if (busy > 0.0) {
+        std::fprintf(stderr, ", %.1f MB/s", megabytes / busy);
+    }
+    std::fprintf(stderr, "\n  scan    %8.3f s\n  ingest  %8.3f s\n  merge   %8.3f s\n  output  %8.3f s\n",
+                 timings.scan, timings.ingest, timings.merge, timings.output);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const Options options = parseOptions(argc, argv);
+        auto start = Clock::now();
+        Timings timings;
+        Histogram hist = options.merge ? mergeSerialized(options, timings) : buildHistogram(options, timings);
+
+        auto outputStart = Clock::now();
+        writeOutputs(options, hist);
+        std::fflush(stdout);
+        timings.output = secondsSince(outputStart);
+
+        if (options.stats) {
+            printStats(timings, secondsSince(start));
+        }
+        return 0;
+    } catch (const UsageError& e) {
+        std::cerr << "histogram-cli: " << e.what() << "\n\n" << kUsage;
+        return 2;
+    } catch (const std::exception& e) {
+        std::cerr << "histogram-cli: " << e.what() << "\n";
+        return 1;
+    }
+}